@@ -0,0 +1,122 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace bench {
+
+namespace {
+
+/// prints value with a metric prefix (1.5k, 2.3M …)
+auto metric(double value) -> std::string {
+    constexpr auto prefixes = std::string_view{" kMGT"};
+    auto index = size_t{};
+    while (value >= 1000.0 && index + 1 < prefixes.size()) {
+        value /= 1000.0;
+        index++;
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.3g%c", value, prefixes[index]);
+    return buffer;
+}
+
+auto duration(double nanos) -> std::string {
+    char buffer[32];
+    if (nanos < 1e3) {
+        snprintf(buffer, sizeof(buffer), "%.1fns", nanos);
+    }
+    else if (nanos < 1e6) {
+        snprintf(buffer, sizeof(buffer), "%.2fus", nanos / 1e3);
+    }
+    else {
+        snprintf(buffer, sizeof(buffer), "%.2fms", nanos / 1e6);
+    }
+    return buffer;
+}
+
+} // namespace
+
+Runner::Runner(Options options)
+    : m_options{std::move(options)} {
+    if (m_options.csv && !m_options.checkOnly) {
+        puts("name,batch,samples,median_ns,min_ns,items_per_s,bytes_per_s");
+    }
+}
+
+bool Runner::isSelected(std::string_view name) const {
+    return m_options.filter.empty() || name.find(m_options.filter) != std::string_view::npos;
+}
+
+void Runner::check(std::string_view name, bool success, std::string_view detail) {
+    if (!isSelected(name)) return;
+    m_checks++;
+    if (success) return;
+    m_failures++;
+    fprintf(
+        stderr,
+        "FAILED %.*s%s%.*s\n",
+        static_cast<int>(name.size()),
+        name.data(),
+        detail.empty() ? "" : ": ",
+        static_cast<int>(detail.size()),
+        detail.data());
+}
+
+void Runner::report(std::string_view name, Work work, size_t batch, std::vector<double> &samples) {
+    m_measurements++;
+    std::sort(samples.begin(), samples.end());
+    const auto median = samples[samples.size() / 2];
+    const auto fastest = samples.front();
+    const auto perSecond = [&](uint64_t count) { return count == 0 ? 0.0 : static_cast<double>(count) * 1e9 / median; };
+    const auto itemsPerSecond = perSecond(work.items);
+    const auto bytesPerSecond = perSecond(work.bytes);
+    if (m_options.csv) {
+        printf(
+            "%.*s,%zu,%zu,%.1f,%.1f,%.0f,%.0f\n",
+            static_cast<int>(name.size()),
+            name.data(),
+            batch,
+            samples.size(),
+            median,
+            fastest,
+            itemsPerSecond,
+            bytesPerSecond);
+        return;
+    }
+    auto throughput = std::string{};
+    if (work.items != 0) throughput += metric(itemsPerSecond) + " items/s";
+    if (work.items != 0 && work.bytes != 0) throughput += ", ";
+    if (work.bytes != 0) throughput += metric(bytesPerSecond) + "B/s";
+    printf(
+        "%-48.*s %10s %10s  %s\n",
+        static_cast<int>(name.size()),
+        name.data(),
+        duration(median).c_str(),
+        duration(fastest).c_str(),
+        throughput.c_str());
+}
+
+auto Runner::finish() -> int {
+    fprintf(
+        m_failures == 0 ? stdout : stderr,
+        "%zu checks, %zu failed, %zu measurements\n",
+        m_checks,
+        m_failures,
+        m_measurements);
+    return m_failures == 0 ? 0 : 1;
+}
+
+auto Random::rect(Dimension bounds, Dimension maxSize) -> Rect {
+    const auto width = uniform(1, std::min(bounds.width, maxSize.width));
+    const auto height = uniform(1, std::min(bounds.height, maxSize.height));
+    return Rect{
+        Point{uniform(0, bounds.width - width), uniform(0, bounds.height - height)},
+        Dimension{width, height},
+    };
+}
+
+void Random::fill(std::span<uint8_t> bytes) {
+    for (auto &byte : bytes) byte = static_cast<uint8_t>(m_engine());
+}
+
+} // namespace bench
@@ -0,0 +1,124 @@
+#pragma once
+#include "win32/Geometry.h"
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+using win32::Dimension;
+using win32::Point;
+using win32::Rect;
+
+/// options of one benchmark run (see usage in main.cpp)
+struct Options {
+    bool checkOnly{}; ///< run the checks and each measurement only once (fast, used by CI tests)
+    bool csv{}; ///< print measurements as csv instead of a table
+    std::string filter{}; ///< only run cases with names that contain the filter
+    std::chrono::milliseconds minTime{250}; ///< measure each case at least this long
+};
+
+/// work done by one call of a measured operation
+struct Work {
+    uint64_t items{}; ///< rects, pixels, records … (0 = not reported)
+    uint64_t bytes{}; ///< bytes processed (0 = not reported)
+};
+
+/// Runs checks and measurements and reports them
+/// note: a failed check fails the whole run, measurements never fail
+struct Runner {
+    explicit Runner(Options options);
+
+    auto options() const -> Options const & { return m_options; }
+    /// true if the case with this name was selected by the filter
+    bool isSelected(std::string_view name) const;
+
+    /// record the result of a check
+    void check(std::string_view name, bool success, std::string_view detail = {});
+
+    /// call op until the minimum time is spent and report the median time per call
+    template<class Op>
+    void measure(std::string_view name, Work work, Op &&op) {
+        if (!isSelected(name)) return;
+        if (m_options.checkOnly) {
+            op();
+            return;
+        }
+        op(); // warm up caches and lazy allocations
+        auto batch = size_t{1};
+        auto samples = std::vector<double>{};
+        const auto start = Clock::now();
+        while (samples.size() < minSamples || Clock::now() - start < m_options.minTime) {
+            const auto begin = Clock::now();
+            for (auto i = size_t{}; i < batch; ++i) op();
+            const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+            if (elapsed < minBatchNanos && samples.empty()) {
+                batch *= 2; // too short to time reliably
+                continue;
+            }
+            samples.push_back(elapsed / static_cast<double>(batch));
+            if (samples.size() >= maxSamples) break;
+        }
+        report(name, work, batch, samples);
+    }
+
+    /// prints the summary - returns the exit code of the process
+    auto finish() -> int;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto minSamples = size_t{5};
+    static constexpr auto maxSamples = size_t{1000};
+    static constexpr auto minBatchNanos = 1'000'000.0;
+
+    void report(std::string_view name, Work work, size_t batch, std::vector<double> &samples);
+
+private:
+    Options m_options;
+    size_t m_checks{};
+    size_t m_failures{};
+    size_t m_measurements{};
+};
+
+/// keeps the compiler from optimizing away a result
+template<class T>
+void keep(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static auto const *volatile sink = &value;
+    sink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/// deterministic random numbers, so every run measures the same workload
+struct Random {
+    explicit Random(uint32_t seed)
+        : m_engine{seed} {}
+
+    /// uniform in [low, high]
+    auto uniform(int low, int high) -> int { return std::uniform_int_distribution<int>{low, high}(m_engine); }
+    auto byte() -> uint8_t { return static_cast<uint8_t>(m_engine()); }
+    /// rect with a size in [1, maxSize] that is completely inside of bounds
+    auto rect(Dimension bounds, Dimension maxSize) -> Rect;
+    void fill(std::span<uint8_t> bytes);
+
+private:
+    std::mt19937 m_engine;
+};
+
+// suites - every suite registers its checks and measurements
+void runGeometry(Runner &); ///< rect transforms, coalescing, culling, regions, damage
+void runSurface(Runner &); ///< pixel copies, moves, scaling, pointer shapes, hashing
+void runPipeline(Runner &); ///< software frame updates driven by synthetic captures
+void runTiming(Runner &); ///< latency histogram and frame trace
+
+} // namespace bench
@@ -0,0 +1,382 @@
+#include "Bench.h"
+
+#include "core/DamageTracker.h"
+#include "core/RectCoalescer.h"
+#include "core/RectTransform.h"
+#include "core/Region.h"
+#include "core/Rotation.h"
+#include "core/VisibleAreaCuller.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+
+namespace bench {
+
+namespace {
+
+using core::Region;
+
+constexpr auto rotations = std::array{
+    DXGI_MODE_ROTATION_IDENTITY,
+    DXGI_MODE_ROTATION_ROTATE90,
+    DXGI_MODE_ROTATION_ROTATE180,
+    DXGI_MODE_ROTATION_ROTATE270,
+};
+
+auto randomRects(Random &random, size_t count, Dimension bounds, Dimension maxSize) -> std::vector<Rect> {
+    auto rects = std::vector<Rect>(count);
+    for (auto &rect : rects) rect = random.rect(bounds, maxSize);
+    return rects;
+}
+
+auto toRECTs(std::span<const Rect> rects) -> std::vector<RECT> {
+    auto result = std::vector<RECT>(rects.size());
+    std::transform(rects.begin(), rects.end(), result.begin(), [](Rect const &r) { return r.toRECT(); });
+    return result;
+}
+
+bool operator==(RECT const &a, RECT const &b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+bool isNear(core::Vertex const &a, core::Vertex const &b) {
+    constexpr auto epsilon = 1e-5f;
+    return std::fabs(a.x - b.x) < epsilon && std::fabs(a.y - b.y) < epsilon && std::fabs(a.u - b.u) < epsilon &&
+           std::fabs(a.v - b.v) < epsilon;
+}
+
+void checkRectTransforms(Runner &runner) {
+    auto random = Random{3};
+    const auto spaceDim = Dimension{1920, 1080};
+    const auto rects = toRECTs(randomRects(random, 1000, spaceDim, {200, 200}));
+    auto rotated = std::vector<RECT>(rects.size());
+    auto instances = std::vector<core::QuadInstance>(rects.size());
+    auto quads = std::vector<core::QuadVertices>(rects.size());
+    for (const auto rotation : rotations) {
+        const auto rotatedDim = core::rotate(spaceDim, rotation);
+        const auto transform = core::VertexTransform::make({2560, 1440}, {13, -7}, rotatedDim);
+        core::rotateRects(rects, rotation, spaceDim, rotated);
+        core::emitQuadInstances(rects, rotation, spaceDim, instances);
+        core::emitQuadVertices(rects, rotation, spaceDim, transform, quads);
+
+        auto rotateFailures = 0;
+        auto instanceFailures = 0;
+        auto vertexFailures = 0;
+        for (auto i = size_t{}; i < rects.size(); ++i) {
+            const auto expected = core::rotate(Rect::fromRECT(rects[i]), rotation, spaceDim).toRECT();
+            if (!(rotated[i] == expected)) rotateFailures++;
+
+            const auto &instance = instances[i];
+            if (instance.left != static_cast<float>(expected.left) ||
+                instance.top != static_cast<float>(expected.top) ||
+                instance.right != static_cast<float>(expected.right) ||
+                instance.bottom != static_cast<float>(expected.bottom)) {
+                instanceFailures++;
+            }
+
+            for (auto k = size_t{}; k < core::unitQuadCorners.size(); ++k) {
+                const auto [cx, cy] = core::unitQuadCorners[k];
+                const auto vertex = transform.vertex(
+                    cx == 0.0f ? expected.left : expected.right, cy == 0.0f ? expected.top : expected.bottom);
+                if (!isNear(quads[i][k], vertex)) vertexFailures++;
+            }
+        }
+        const auto suffix = std::to_string(static_cast<int>(rotation));
+        runner.check("rect-transform/rotate rotation " + suffix, rotateFailures == 0);
+        runner.check("rect-transform/instances rotation " + suffix, instanceFailures == 0);
+        runner.check("rect-transform/vertices rotation " + suffix, vertexFailures == 0);
+    }
+}
+
+void checkInstanceCapacity(Runner &runner) {
+    auto success = core::instanceCapacityFor(0, 0) == 0 && core::instanceCapacityFor(1, 0) == 256 &&
+                   core::instanceCapacityFor(300, 256) == 512 && core::instanceCapacityFor(10, 4096) == 4096;
+    auto capacity = size_t{};
+    auto reallocations = 0;
+    for (auto required = size_t{1}; required <= 100'000; required += 97) {
+        const auto next = core::instanceCapacityFor(required, capacity);
+        if (next < required || next < capacity || (next & (next - 1)) != 0) success = false;
+        if (next != capacity) reallocations++;
+        capacity = next;
+    }
+    runner.check("rect-transform/instance capacity", success && reallocations <= 10);
+}
+
+/// bitmap of the pixels in rects (bounds start at 0,0)
+auto rasterize(std::span<const Rect> rects, Dimension bounds) -> std::vector<bool> {
+    auto bits = std::vector<bool>(static_cast<size_t>(bounds.width) * bounds.height);
+    for (const auto &rect : rects) {
+        for (auto y = rect.top(); y < rect.bottom(); ++y) {
+            for (auto x = rect.left(); x < rect.right(); ++x) bits[static_cast<size_t>(y) * bounds.width + x] = true;
+        }
+    }
+    return bits;
+}
+
+/// rects are sorted into bands that neither overlap nor touch
+bool isBanded(Region const &region) {
+    const auto rects = region.rects();
+    for (auto i = size_t{1}; i < rects.size(); ++i) {
+        const auto &previous = rects[i - 1];
+        const auto &rect = rects[i];
+        if (rect.width() <= 0 || rect.height() <= 0) return false;
+        if (previous.top() == rect.top()) {
+            if (previous.bottom() != rect.bottom() || previous.right() >= rect.left()) return false;
+        }
+        else if (previous.bottom() > rect.top() || previous.top() > rect.top()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void checkRegions(Runner &runner) {
+    constexpr auto bounds = Dimension{48, 48};
+    auto random = Random{1};
+    auto failures = 0;
+    for (auto iteration = 0; iteration < 2000; ++iteration) {
+        const auto a = randomRects(random, static_cast<size_t>(random.uniform(0, 5)), bounds, {20, 20});
+        const auto b = randomRects(random, static_cast<size_t>(random.uniform(0, 5)), bounds, {20, 20});
+        const auto regionA = Region::fromRects(a);
+        const auto regionB = Region::fromRects(b);
+        const auto bitsA = rasterize(a, bounds);
+        const auto bitsB = rasterize(b, bounds);
+
+        const auto united = regionA | regionB;
+        const auto intersected = regionA & regionB;
+        const auto subtracted = regionA - regionB;
+        auto success = isBanded(regionA) && isBanded(united) && isBanded(intersected) && isBanded(subtracted);
+        success = success && rasterize(regionA.rects(), bounds) == bitsA;
+
+        const auto bitsUnited = rasterize(united.rects(), bounds);
+        const auto bitsIntersected = rasterize(intersected.rects(), bounds);
+        const auto bitsSubtracted = rasterize(subtracted.rects(), bounds);
+        auto unitedArea = int64_t{};
+        for (auto i = size_t{}; i < bitsA.size(); ++i) {
+            if (bitsUnited[i] != (bitsA[i] || bitsB[i])) success = false;
+            if (bitsIntersected[i] != (bitsA[i] && bitsB[i])) success = false;
+            if (bitsSubtracted[i] != (bitsA[i] && !bitsB[i])) success = false;
+            unitedArea += bitsUnited[i] ? 1 : 0;
+        }
+        success = success && united.area() == unitedArea && (regionB | regionA) == united;
+
+        const auto probe = random.rect(bounds, {12, 12});
+        const auto bitsProbe = rasterize({&probe, 1}, bounds);
+        auto covers = true;
+        auto touches = false;
+        for (auto i = size_t{}; i < bitsA.size(); ++i) {
+            if (bitsProbe[i] && !bitsA[i]) covers = false;
+            if (bitsProbe[i] && bitsA[i]) touches = true;
+        }
+        success = success && regionA.contains(probe) == covers && regionA.intersects(probe) == touches;
+        if (!success) failures++;
+    }
+    runner.check("region/bitmap reference", failures == 0, std::to_string(failures) + " of 2000 differ");
+}
+
+void checkCoalescer(Runner &runner) {
+    auto random = Random{7};
+    auto coalescer = core::RectCoalescer{};
+    auto failures = 0;
+    for (auto iteration = 0; iteration < 200; ++iteration) {
+        const auto input = randomRects(random, static_cast<size_t>(random.uniform(1, 60)), {1920, 1080}, {64, 64});
+        const auto output = coalescer.coalesce(input);
+        const auto inputRegion = Region::fromRects(input);
+        const auto missing = inputRegion - Region::fromRects(output);
+        if (!missing.isEmpty() || output.size() > input.size()) failures++;
+        if (coalescer.lastStats().inputArea != inputRegion.area()) failures++;
+    }
+    runner.check("coalescer/covers input", failures == 0);
+
+    // the overlap of two merged rects is drawn once and counted once
+    const auto overlapping = std::array{Rect{{0, 0}, {100, 100}}, Rect{{50, 50}, {100, 100}}};
+    const auto merged = coalescer.coalesce(overlapping);
+    const auto &stats = coalescer.lastStats();
+    runner.check(
+        "coalescer/overlap overdraw",
+        merged.size() == 1 && stats.inputArea == 17500 && stats.overdrawArea == 150 * 150 - 17500);
+}
+
+void checkCuller(Runner &runner) {
+    auto random = Random{11};
+    const auto visible = Rect{{200, 100}, {800, 600}};
+    auto culler = core::VisibleAreaCuller{};
+    culler.setVisibleArea(visible);
+    auto failures = 0;
+    for (auto iteration = 0; iteration < 200; ++iteration) {
+        const auto dirty = randomRects(random, 20, {1920, 1080}, {300, 300});
+        culler.cull({}, dirty, true);
+        const auto expected = Region::fromRects(dirty) & Region{visible};
+        const auto kept = Region::fromRects(culler.dirty());
+        if (!(expected - kept).isEmpty() || !(kept - Region{visible}).isEmpty()) failures++;
+    }
+    runner.check("culler/dirty inside visible area", failures == 0);
+}
+
+void checkDamageTracker(Runner &runner) {
+    const auto desktop = core::CaptureMapping{DXGI_MODE_ROTATION_IDENTITY, Rect{{}, {1000, 800}}, {}};
+    auto tracker = core::DamageTracker{};
+    tracker.setOutputMapping({1.0f, {}, {1000, 800}});
+    auto success = tracker.present().isFull; // nothing presented yet
+
+    tracker.addOutput(Rect{{10, 10}, {5, 5}});
+    success = success && tracker.present().isFull; // back buffer is stale after a full present
+
+    auto present = tracker.present();
+    success = success && !present.isFull && present.dirty.empty() && present.redraw.empty();
+
+    const auto dirty = RECT{100, 100, 110, 120};
+    tracker.addCaptured({}, {&dirty, 1}, desktop);
+    present = tracker.present();
+    success = success && !present.isFull && present.dirty.size() == 1 && present.dirty[0].left() <= 100 &&
+              present.dirty[0].right() >= 110;
+
+    tracker.addOutput(Rect{{500, 500}, {4, 4}});
+    present = tracker.present();
+    success = success && !present.isFull && present.dirty.size() == 1 && present.redraw.size() == 2;
+
+    tracker.setOutputMapping({2.0f, {0.5f, 0.0f}, {1000, 800}});
+    success = success && tracker.present().isFull;
+
+    tracker.present();
+    tracker.addOutput(Rect{{0, 0}, {900, 800}});
+    success = success && tracker.present().isFull; // too large
+    runner.check("damage/present sequence", success);
+
+    const auto rotated = core::toTargetRect(
+        Rect{{0, 0}, {10, 20}}, {DXGI_MODE_ROTATION_ROTATE90, Rect{{1920, 0}, {100, 200}}, {1920, 0}});
+    runner.check("damage/target rect", rotated == Rect{{180, 0}, {20, 10}});
+}
+
+/// per rect rotation and vertex build like FrameUpdater did before the batched transforms (baseline)
+void emitQuadVerticesScalar(
+    std::span<const RECT> rects,
+    DXGI_MODE_ROTATION rotation,
+    Dimension spaceDim,
+    Dimension targetDim,
+    std::span<core::QuadVertices> out) {
+    const auto centerX = targetDim.width / 2;
+    const auto centerY = targetDim.height / 2;
+    const auto textureDim = core::rotate(spaceDim, rotation);
+    const auto makeVertex = [&](int x, int y) {
+        return core::Vertex{
+            (x - centerX) / static_cast<float>(centerX),
+            -1 * (y - centerY) / static_cast<float>(centerY),
+            x / static_cast<float>(textureDim.width),
+            y / static_cast<float>(textureDim.height),
+        };
+    };
+    for (auto i = size_t{}; i < rects.size(); ++i) {
+        const auto rotated = core::rotate(Rect::fromRECT(rects[i]), rotation, spaceDim);
+        auto &vertices = out[i];
+        vertices[0] = makeVertex(rotated.left(), rotated.bottom());
+        vertices[1] = makeVertex(rotated.left(), rotated.top());
+        vertices[2] = makeVertex(rotated.right(), rotated.bottom());
+        vertices[3] = vertices[2];
+        vertices[4] = vertices[1];
+        vertices[5] = makeVertex(rotated.right(), rotated.top());
+    }
+}
+
+void measureRectTransforms(Runner &runner) {
+    auto random = Random{5};
+    const auto spaceDim = Dimension{1920, 1080};
+    const auto rotation = DXGI_MODE_ROTATION_ROTATE90;
+    const auto targetDim = Dimension{2560, 1440};
+    const auto transform = core::VertexTransform::make(targetDim, {}, core::rotate(spaceDim, rotation));
+    for (const auto count : {size_t{10}, size_t{100}, size_t{1000}}) {
+        const auto rects = toRECTs(randomRects(random, count, spaceDim, {200, 200}));
+        auto rotated = std::vector<RECT>(count);
+        auto quads = std::vector<core::QuadVertices>(count);
+        auto instances = std::vector<core::QuadInstance>(count);
+        const auto suffix = std::to_string(count) + " rects";
+        const auto work = Work{.items = count};
+        runner.measure("rect-transform/rotate scalar " + suffix, work, [&] {
+            for (auto i = size_t{}; i < count; ++i) {
+                rotated[i] = core::rotate(Rect::fromRECT(rects[i]), rotation, spaceDim).toRECT();
+            }
+            keep(rotated.data());
+        });
+        runner.measure("rect-transform/rotate " + suffix, work, [&] {
+            core::rotateRects(rects, rotation, spaceDim, rotated);
+            keep(rotated.data());
+        });
+        runner.measure("rect-transform/vertices scalar " + suffix, work, [&] {
+            emitQuadVerticesScalar(rects, rotation, spaceDim, targetDim, quads);
+            keep(quads.data());
+        });
+        runner.measure("rect-transform/vertices " + suffix, work, [&] {
+            core::emitQuadVertices(rects, rotation, spaceDim, transform, quads);
+            keep(quads.data());
+        });
+        runner.measure("rect-transform/instances " + suffix, work, [&] {
+            core::emitQuadInstances(rects, rotation, spaceDim, instances);
+            keep(instances.data());
+        });
+    }
+}
+
+void measureRegions(Runner &runner) {
+    auto random = Random{9};
+    const auto bounds = Dimension{3840, 2160};
+    const auto a = randomRects(random, 1000, bounds, {64, 64});
+    const auto b = randomRects(random, 1000, bounds, {64, 64});
+    const auto regionA = Region::fromRects(a);
+    const auto regionB = Region::fromRects(b);
+    const auto work = Work{.items = regionA.size() + regionB.size()};
+    runner.measure("region/from 1000 rects", Work{.items = a.size()}, [&] { keep(Region::fromRects(a)); });
+    runner.measure("region/union 1k rects", work, [&] { keep(regionA | regionB); });
+    runner.measure("region/intersect 1k rects", work, [&] { keep(regionA & regionB); });
+    runner.measure("region/subtract 1k rects", work, [&] { keep(regionA - regionB); });
+}
+
+void measureCoalescer(Runner &runner) {
+    auto random = Random{13};
+    // typing like updates - many tiny rects along a few lines
+    auto input = std::vector<Rect>{};
+    for (auto line = 0; line < 10; ++line) {
+        const auto top = random.uniform(0, 1000);
+        for (auto column = 0; column < 50; ++column) input.push_back(Rect{{200 + column * 9, top}, {8, 16}});
+    }
+    auto coalescer = core::RectCoalescer{};
+    runner.measure("coalescer/500 glyph rects", Work{.items = input.size()}, [&] { keep(coalescer.coalesce(input)); });
+
+    auto culler = core::VisibleAreaCuller{};
+    culler.setVisibleArea(Rect{{0, 0}, {1280, 720}});
+    runner.measure("culler/500 glyph rects", Work{.items = input.size()}, [&] {
+        culler.cull({}, input, true);
+        keep(culler.dirty().data());
+    });
+}
+
+void measureDamageTracker(Runner &runner) {
+    auto random = Random{17};
+    const auto dirty = toRECTs(randomRects(random, 100, {1920, 1080}, {32, 32}));
+    const auto mapping = core::CaptureMapping{DXGI_MODE_ROTATION_IDENTITY, Rect{{}, {1920, 1080}}, {}};
+    auto tracker = core::DamageTracker{};
+    tracker.setOutputMapping({1.5f, {}, {2880, 1620}});
+    runner.measure("damage/100 dirty rects", Work{.items = dirty.size()}, [&] {
+        tracker.addCaptured({}, dirty, mapping);
+        keep(tracker.present());
+    });
+}
+
+} // namespace
+
+void runGeometry(Runner &runner) {
+    checkRectTransforms(runner);
+    checkInstanceCapacity(runner);
+    checkRegions(runner);
+    checkCoalescer(runner);
+    checkCuller(runner);
+    checkDamageTracker(runner);
+
+    measureRectTransforms(runner);
+    measureRegions(runner);
+    measureCoalescer(runner);
+    measureDamageTracker(runner);
+}
+
+} // namespace bench
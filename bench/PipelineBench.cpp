@@ -0,0 +1,696 @@
+#include "Bench.h"
+
+#include "CapturedUpdate.h"
+#include "FrameContext.h"
+#include "SessionRecorder.h"
+#include "SoftwareFrameUpdater.h"
+#include "SyntheticCaptureSource.h"
+#include "SyntheticWorkload.h"
+#include "TraceCaptureSource.h"
+
+#include "core/CaptureStaging.h"
+#include "core/PixelCopy.h"
+#include "core/RectCoalescer.h"
+#include "core/Rotation.h"
+#include "core/ScrollDetector.h"
+#include "core/SessionReplayer.h"
+#include "core/SessionTrace.h"
+#include "core/TileChangeDetector.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <ranges>
+#include <string>
+#include <thread>
+
+namespace bench {
+
+namespace {
+
+constexpr auto border = 10; // target pixels around the captured display
+
+constexpr auto rotations = std::array{
+    DXGI_MODE_ROTATION_IDENTITY,
+    DXGI_MODE_ROTATION_ROTATE90,
+    DXGI_MODE_ROTATION_ROTATE180,
+    DXGI_MODE_ROTATION_ROTATE270,
+};
+
+/// small display with random moves and dirty rects, the first step paints everything
+auto randomConfig(DXGI_MODE_ROTATION rotation) -> SyntheticCaptureSource::Config {
+    auto random = Random{static_cast<uint32_t>(rotation)};
+    auto config = SyntheticCaptureSource::Config{
+        .dimension = {200, 120},
+        .desktopTopLeft = {100, 50},
+        .rotation = rotation,
+    };
+    config.script.push_back({.dirty = {RECT{0, 0, 200, 120}}});
+    for (auto i = 0; i < 200; ++i) {
+        auto step = SyntheticCaptureSource::Step{};
+        const auto source = random.rect(config.dimension, {80, 60});
+        if (random.uniform(0, 1) == 0) {
+            const auto left = std::clamp(source.left() + random.uniform(-10, 10), 0, 200 - source.width());
+            const auto top = std::clamp(source.top() + random.uniform(-10, 10), 0, 120 - source.height());
+            const auto destination = Rect{{left, top}, source.dimension};
+            step.moved.push_back({source.topLeft.toPOINT(), destination.toRECT()});
+        }
+        step.dirty.push_back(random.rect(config.dimension, {10, 10}).toRECT());
+        if (i % 50 == 0) step.pointerShape = static_cast<size_t>(i / 50 % 2);
+        if (i % 3 == 0) step.pointerPosition = Point{i % 200, i % 120};
+        config.script.push_back(std::move(step));
+    }
+    config.pointerShapes = {SyntheticCaptureSource::colorArrowShape(), SyntheticCaptureSource::monochromeBeamShape()};
+    return config;
+}
+
+/// feeds all updates of source into a software frame updater
+/// returns true if the display part of the updated surface equals expected
+template<class Source>
+bool updatesBitExact(Source &source, DXGI_MODE_ROTATION rotation, Dimension dimension, core::SurfaceView expected) {
+    auto context = FrameContext{.offset = {100 - border, 50 - border}, .output_desc = source.init()};
+    const auto rotated = core::rotate(dimension, rotation);
+    auto updater = SoftwareFrameUpdater{{rotated.width + 2 * border, rotated.height + 2 * border}};
+    while (!source.isDone()) {
+        auto update = source.acquire(std::chrono::milliseconds{1});
+        if (!update) continue;
+        updater.update(update->frame, context);
+        source.release();
+    }
+    if (!expected) expected = source.surface();
+
+    const auto target = updater.surface();
+    const auto rowBytes = static_cast<size_t>(rotated.width) * core::bytesPerPixel;
+    for (auto y = 0; y < rotated.height; ++y) {
+        if (std::memcmp(target.pixel({border, border + y}), expected.row(y), rowBytes) != 0) return false;
+    }
+    return true;
+}
+
+/// updates of the synthetic source end up bit exact in the software frame updater
+void checkSoftwareUpdater(Runner &runner) {
+    for (const auto rotation : rotations) {
+        const auto config = randomConfig(rotation);
+        auto synthetic = SyntheticCaptureSource{config};
+        const auto equal = updatesBitExact(synthetic, rotation, config.dimension, {});
+        runner.check("software-updater/bit exact rotation " + std::to_string(static_cast<int>(rotation)), equal);
+    }
+}
+
+/// workloads are reproducible, stay on the desktop and replay bit exact in every rotation
+void checkWorkloads(Runner &runner) {
+    for (const auto kind : SyntheticWorkload::kinds) {
+        const auto name = std::string{SyntheticWorkload::name(kind)};
+        auto params = SyntheticWorkload::Params{.kind = kind, .dimension = {200, 120}, .frames = 150};
+        const auto script = SyntheticWorkload::script(params);
+        const auto isInside = [&](RECT const &rect) {
+            return rect.left >= 0 && rect.top >= 0 && rect.right <= 200 && rect.bottom <= 120 &&
+                rect.left < rect.right && rect.top < rect.bottom;
+        };
+        auto isValid = script.size() == params.frames + 1;
+        auto isSame = true;
+        const auto again = SyntheticWorkload::script(params);
+        for (auto i = size_t{}; isValid && i < script.size(); ++i) {
+            const auto &step = script[i];
+            const auto isInsideMove = [&](DXGI_OUTDUPL_MOVE_RECT const &move) {
+                const auto &destination = move.DestinationRect;
+                const auto source = RECT{
+                    move.SourcePoint.x,
+                    move.SourcePoint.y,
+                    move.SourcePoint.x + destination.right - destination.left,
+                    move.SourcePoint.y + destination.bottom - destination.top,
+                };
+                return isInside(destination) && isInside(source);
+            };
+            isValid = std::ranges::all_of(step.dirty, isInside) && std::ranges::all_of(step.unchanged, isInside) &&
+                std::ranges::all_of(step.moved, isInsideMove) && std::ranges::all_of(step.shifted, isInsideMove);
+            isSame = isSame && step.dirty.size() == again[i].dirty.size() && step.moved.size() == again[i].moved.size();
+        }
+        runner.check("workload/" + name + " valid & reproducible", isValid && isSame);
+
+        auto isExact = true;
+        for (const auto rotation : rotations) {
+            params.rotation = rotation;
+            auto config = SyntheticWorkload::config(params);
+            config.desktopTopLeft = {100, 50};
+            auto synthetic = SyntheticCaptureSource{std::move(config)};
+            isExact = isExact && updatesBitExact(synthetic, rotation, params.dimension, {});
+        }
+        runner.check("workload/" + name + " bit exact", isExact);
+    }
+}
+
+/// synthetic source that passes every acquired update through a stage of the CaptureThread
+/// note: Stage provides reset(DXGI_OUTPUT_DESC const &) and process(SyntheticCaptureSource &, CapturedUpdate &)
+template<class Stage>
+struct StagedSource {
+    SyntheticCaptureSource source;
+    Stage stage;
+
+    auto init() -> DXGI_OUTPUT_DESC {
+        const auto desc = source.init();
+        stage.reset(desc);
+        return desc;
+    }
+    auto acquire(std::chrono::milliseconds timeout) -> std::optional<CapturedUpdate> {
+        auto update = source.acquire(timeout);
+        if (update) stage.process(source, *update);
+        return update;
+    }
+    void release() { source.release(); }
+    bool isDone() const { return source.isDone(); }
+    auto surface() const -> core::SurfaceView { return source.surface(); }
+};
+
+/// copies the dirty regions of every update into the staging surfaces like the pipelined CaptureThread
+struct StagingStage {
+    void reset(DXGI_OUTPUT_DESC const &) {}
+    void process(SyntheticCaptureSource &source, CapturedUpdate &update) { source.stage(update); }
+};
+
+/// replaces the rects of every update with the results of a TileChangeDetector or ScrollDetector
+template<class Detector>
+struct DetectStage {
+    Detector detector;
+    std::vector<Rect> dirty{};
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> moved{};
+
+    void reset(DXGI_OUTPUT_DESC const &desc) {
+        detector.reset(Rect::fromRECT(desc.DesktopCoordinates).dimension, desc.Rotation);
+    }
+    void process(SyntheticCaptureSource &, CapturedUpdate &update) {
+        auto &frame = update.frame;
+        dirty.clear();
+        for (const auto &rect : frame.dirty()) dirty.push_back(Rect::fromRECT(rect));
+        moved.assign(frame.moved().begin(), frame.moved().end());
+        detector.detect(frame.cpuImage, moved, dirty);
+        if constexpr (requires { detector.moved(); }) {
+            frame.replaceRects(detector.moved(), detector.dirty());
+        }
+        else {
+            frame.replaceRects(moved, detector.dirty());
+        }
+    }
+};
+
+/// staged updates only carry the dirty regions - they end up bit exact as well
+void checkStaging(Runner &runner) {
+    auto isExact = true;
+    for (const auto rotation : rotations) {
+        const auto config = randomConfig(rotation);
+        auto staged = StagedSource<StagingStage>{.source = SyntheticCaptureSource{config}, .stage = {}};
+        isExact = isExact && updatesBitExact(staged, rotation, config.dimension, {});
+    }
+    runner.check("staging/bit exact", isExact);
+}
+
+/// only unchanged tiles are dropped - workloads with moves and over reported rects stay bit exact
+void checkChangeDetection(Runner &runner) {
+    for (const auto kind : {SyntheticWorkload::Kind::CoalescedBurst, SyntheticWorkload::Kind::WindowDrag}) {
+        const auto name = std::string{SyntheticWorkload::name(kind)};
+        auto isExact = true;
+        auto isSaving = true;
+        for (const auto rotation : rotations) {
+            const auto params =
+                SyntheticWorkload::Params{.kind = kind, .dimension = {200, 120}, .rotation = rotation, .frames = 150};
+            auto config = SyntheticWorkload::config(params);
+            config.desktopTopLeft = {100, 50};
+            auto detecting = StagedSource<DetectStage<core::TileChangeDetector>>{
+                .source = SyntheticCaptureSource{std::move(config)},
+                .stage = {.detector = core::TileChangeDetector{{.tileSize = 16}}},
+            };
+            isExact = isExact && updatesBitExact(detecting, rotation, params.dimension, {});
+            const auto &stats = detecting.stage.detector.stats();
+            isSaving = isSaving && stats.outputArea < stats.inputArea;
+        }
+        runner.check("change-detection/" + name + " bit exact", isExact);
+        if (kind == SyntheticWorkload::Kind::CoalescedBurst) {
+            runner.check("change-detection/" + name + " saves", isSaving);
+        }
+    }
+}
+
+/// moves are only synthesized for shifted content - all workloads stay bit exact
+void checkScrollDetection(Runner &runner) {
+    for (const auto kind : SyntheticWorkload::kinds) {
+        const auto name = std::string{SyntheticWorkload::name(kind)};
+        auto isExact = true;
+        auto isSaving = true;
+        for (const auto rotation : rotations) {
+            const auto params =
+                SyntheticWorkload::Params{.kind = kind, .dimension = {200, 120}, .rotation = rotation, .frames = 150};
+            auto config = SyntheticWorkload::config(params);
+            config.desktopTopLeft = {100, 50};
+            auto detecting = StagedSource<DetectStage<core::ScrollDetector>>{
+                .source = SyntheticCaptureSource{std::move(config)},
+                .stage = {.detector = core::ScrollDetector{{.minExtent = 32}}},
+            };
+            isExact = isExact && updatesBitExact(detecting, rotation, params.dimension, {});
+            const auto &stats = detecting.stage.detector.stats();
+            isSaving = isSaving && stats.scrolls > 0 && stats.outputArea < stats.inputArea;
+        }
+        runner.check("scroll-detection/" + name + " bit exact", isExact);
+        if (kind == SyntheticWorkload::Kind::RepaintScrolling) {
+            runner.check("scroll-detection/" + name + " saves", isSaving);
+        }
+    }
+}
+
+/// a changed visible area pauses the search until the new area was refreshed once
+void checkScrollVisibleArea(Runner &runner) {
+    auto random = Random{29};
+    const auto dimension = Dimension{200, 120};
+    const auto visible = Rect{{}, {200, 100}};
+    auto before = core::Surface{dimension};
+    random.fill({before.span().data, before.bytes().size()});
+    // content of the visible area scrolls up by 8 rows
+    auto after = core::Surface{dimension};
+    core::copyRect(before.view(), Rect{{}, dimension}, after.span(), {});
+    core::copyRect(before.view(), Rect{{0, 8}, {200, 92}}, after.span(), {});
+
+    auto detector = core::ScrollDetector{{.minExtent = 32}};
+    detector.reset(dimension, DXGI_MODE_ROTATION_IDENTITY);
+    const auto display = Rect{{}, dimension};
+    detector.detect(before.view(), {}, {&display, 1});
+    detector.setVisibleArea(visible);
+    detector.detect(after.view(), {}, {&visible, 1}); // refreshes the visible area
+    const auto isPaused = detector.stats().scrolls == 0;
+    detector.detect(before.view(), {}, {&visible, 1}); // scrolls back
+    runner.check("scroll-detection/visible area change", isPaused && detector.stats().scrolls == 1);
+}
+
+/// records all updates of source into path
+void recordSession(SyntheticCaptureSource &source, SessionRecorder::Config config) {
+    auto recorder = SessionRecorder{std::move(config)};
+    auto context = FrameContext{.output_desc = source.init()};
+    auto sequence = uint64_t{};
+    while (!source.isDone()) {
+        auto update = source.acquire(std::chrono::milliseconds{1});
+        if (!update) continue;
+        update->frame.sequence = ++sequence;
+        // note: the source is faster than any disk, wait instead of dropping updates
+        while (!recorder.record(*update, context, update->frame.cpuImage)) std::this_thread::yield();
+        source.release();
+    }
+}
+
+/// recorded sessions replay bit exact and survive a missing index
+void checkSessionTrace(Runner &runner) {
+    const auto path = std::filesystem::temp_directory_path() / "deskdup-bench.ddtrace";
+    for (const auto rotation : rotations) {
+        const auto config = randomConfig(rotation);
+        auto synthetic = SyntheticCaptureSource{config};
+        recordSession(synthetic, {.path = path});
+
+        auto replay = TraceCaptureSource{{.path = path}};
+        const auto equal = updatesBitExact(replay, rotation, config.dimension, synthetic.surface());
+        const auto suffix = std::to_string(static_cast<int>(rotation));
+        runner.check(
+            "session-trace/replay bit exact rotation " + suffix,
+            equal && replay.isComplete() && replay.updateCount() == config.script.size());
+    }
+
+    auto updateCount = size_t{};
+    {
+        auto reader = core::SessionTraceReader{};
+        auto pointerUpdates = size_t{};
+        auto shapes = size_t{};
+        auto success = reader.open(path);
+        updateCount = reader.updates().size();
+        for (auto i = size_t{}; success && i < updateCount; ++i) {
+            const auto update = reader.read(i);
+            success = update && update->sequence == i + 1 && update->hasImage;
+            if (success && update->pointerUpdateTime != 0) pointerUpdates++;
+            if (success && !update->shape.empty()) shapes++;
+        }
+        runner.check("session-trace/pointer updates", success && pointerUpdates == 69 && shapes == 4);
+    }
+
+    // interrupted recording - no index and the last record is cut off
+    using core::SessionTrace;
+    const auto indexBytes = SessionTrace::recordSize(updateCount * sizeof(SessionTrace::IndexEntry));
+    const auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - sizeof(SessionTrace::Trailer) - indexBytes - 100);
+    {
+        auto recovered = core::SessionTraceReader{};
+        const auto isRecovered = recovered.open(path) && !recovered.isComplete() &&
+            recovered.updates().size() == updateCount - 1 && recovered.read(updateCount - 2).has_value();
+        runner.check("session-trace/recover without index", isRecovered);
+    }
+    std::filesystem::remove(path);
+}
+
+bool isSameImage(core::SurfaceView a, core::SurfaceView b) {
+    if (a.dimension != b.dimension) return false;
+    const auto rowBytes = static_cast<size_t>(a.dimension.width) * core::bytesPerPixel;
+    for (auto y = 0; y < a.dimension.height; ++y) {
+        if (std::memcmp(a.row(y), b.row(y), rowBytes) != 0) return false;
+    }
+    return true;
+}
+
+/// seeking through keyframes reconstructs the same image as replaying every update
+void checkSessionReplayer(Runner &runner) {
+    const auto path = std::filesystem::temp_directory_path() / "deskdup-bench-replay.ddtrace";
+    const auto rotation = DXGI_MODE_ROTATION_ROTATE90;
+    auto synthetic = SyntheticCaptureSource{randomConfig(rotation)};
+    recordSession(synthetic, {.path = path, .keyframeInterval = 32});
+
+    auto sequential = core::SessionReplayer{};
+    auto seeking = core::SessionReplayer{};
+    auto success = sequential.open(path) && seeking.open(path);
+    runner.check("session-replay/keyframes", success && seeking.keyframeCount() == (sequential.updateCount() - 1) / 32);
+
+    auto seekedEqual = success;
+    for (auto position = size_t{}; success && position < sequential.updateCount(); ++position) {
+        if (position % 13 == 0 || position % 32 == 0) {
+            seekedEqual = seekedEqual && seeking.seek(position) && isSameImage(seeking.image(), sequential.image());
+            const auto &expected = sequential.pointer();
+            const auto &pointer = seeking.pointer();
+            seekedEqual = seekedEqual && std::ranges::equal(pointer.shape, expected.shape) &&
+                pointer.position.Position.x == expected.position.Position.x &&
+                pointer.position.Position.y == expected.position.Position.y;
+        }
+        success = sequential.next(std::chrono::milliseconds{0}).has_value();
+    }
+    runner.check(
+        "session-replay/seek bit exact",
+        success && seekedEqual && sequential.isDone() && isSameImage(sequential.image(), synthetic.surface()));
+    // note: no seek applies more updates than the keyframe interval
+    runner.check("session-replay/seek uses keyframes", seeking.stats().seekUpdates < seeking.stats().seeks * 32);
+
+    // 10 frames are recorded 16.7ms apart
+    auto paced = core::SessionReplayer{};
+    success = paced.open(path);
+    paced.setPacing(core::SessionReplayer::Pacing::RealTime);
+    const auto begin = std::chrono::steady_clock::now();
+    for (auto i = 0; success && paced.position() < 11; ++i) {
+        success = i < 100; // nothing due within 10ms is no progress
+        paced.next(std::chrono::milliseconds{10});
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    runner.check("session-replay/real time pacing", success && elapsed >= std::chrono::milliseconds{160});
+
+    const auto updateCount = sequential.updateCount();
+    runner.measure("session-replay/seek to the end", Work{.items = 1}, [&] {
+        seeking.seek(updateCount - 1);
+        keep(seeking.image().data);
+    });
+    runner.measure("session-replay/replay all", Work{.items = updateCount}, [&] {
+        sequential.seek(0);
+        while (sequential.next(std::chrono::milliseconds{0})) {}
+        keep(sequential.image().data);
+    });
+    std::filesystem::remove(path);
+}
+
+/// replays one frame update with the given rects on a 1080p display
+void measureUpdate(
+    Runner &runner, std::string_view name, std::span<const DXGI_OUTDUPL_MOVE_RECT> moved, std::span<const Rect> dirty) {
+    const auto display = Dimension{1920, 1080};
+    auto random = Random{19};
+    auto image = core::Surface{display};
+    auto span = image.span();
+    random.fill({span.data, image.bytes().size()});
+
+    auto frame = FrameUpdate{};
+    frame.cpuImage = image.view();
+    frame.replaceRects(moved, dirty);
+    auto context = FrameContext{};
+    context.output_desc.DesktopCoordinates = Rect{{}, display}.toRECT();
+    context.output_desc.Rotation = DXGI_MODE_ROTATION_IDENTITY;
+
+    const auto rectBytes = [](Rect const &rect) {
+        return static_cast<uint64_t>(rect.width()) * rect.height() * core::bytesPerPixel;
+    };
+    auto bytes = uint64_t{};
+    for (const auto &move : moved) bytes += rectBytes(Rect::fromRECT(move.DestinationRect));
+    for (const auto &rect : dirty) bytes += rectBytes(rect);
+
+    auto updater = SoftwareFrameUpdater{display};
+    runner.measure(name, Work{.items = moved.size() + dirty.size(), .bytes = bytes}, [&] {
+        updater.update(frame, context);
+        keep(updater.surface().data);
+    });
+}
+
+void measureSoftwareUpdater(Runner &runner) {
+    // typing - many glyph sized rects along a line
+    auto glyphs = std::vector<Rect>{};
+    for (auto column = 0; column < 100; ++column) glyphs.push_back(Rect{{100 + column * 9, 500}, {8, 16}});
+    measureUpdate(runner, "software-updater/typing 100 glyphs", {}, glyphs);
+
+    // scrolling - the editor moves up by one line and repaints the uncovered line
+    const auto scroll = DXGI_OUTDUPL_MOVE_RECT{POINT{0, 116}, RECT{0, 100, 1600, 1000}};
+    const auto strip = Rect{{0, 1000}, {1600, 16}};
+    measureUpdate(runner, "software-updater/scroll 1600x900", {&scroll, 1}, {&strip, 1});
+
+    // video - one large rect every frame
+    const auto video = Rect{{320, 180}, {1280, 720}};
+    measureUpdate(runner, "software-updater/video 720p", {}, {&video, 1});
+}
+
+/// every workload played through the software frame updater on 1080p (includes painting the synthetic desktop)
+void measureWorkloads(Runner &runner) {
+    for (const auto kind : SyntheticWorkload::kinds) {
+        const auto params = SyntheticWorkload::Params{.kind = kind, .frames = 60};
+        const auto config = SyntheticWorkload::config(params);
+        auto bytes = uint64_t{};
+        for (const auto &step : config.script | std::views::drop(1)) {
+            for (const auto &rects : {step.dirty, step.unchanged}) {
+                for (const auto &dirty : rects) bytes += static_cast<uint64_t>(core::area(Rect::fromRECT(dirty)));
+            }
+        }
+        const auto name = "workload/software-updater " + std::string{SyntheticWorkload::name(kind)};
+        auto updater = SoftwareFrameUpdater{params.dimension};
+        runner.measure(name, Work{.items = params.frames, .bytes = bytes * core::bytesPerPixel}, [&] {
+            auto source = SyntheticCaptureSource{config};
+            auto context = FrameContext{.output_desc = source.init()};
+            while (!source.isDone()) {
+                auto update = source.acquire(std::chrono::milliseconds{1});
+                if (!update) continue;
+                updater.update(update->frame, context);
+                source.release();
+            }
+            keep(updater.surface().data);
+        });
+    }
+}
+
+struct CaptureModeStats {
+    uint64_t updates{};
+    uint64_t frames{}; // accumulated frames of all updates
+    std::chrono::nanoseconds heldTime{}; // acquire to release of all updates
+};
+
+/// plays source like the CaptureThread to a consumer that is busy for renderTime after each delivered update
+/// note:
+/// * direct holds the frame until the consumer is done, pipelined stages and releases it right away
+/// * the consumer is simulated by waiting for its deadline, so both modes run on this thread
+auto playCaptureMode(
+    SyntheticCaptureSource &source,
+    bool isPipelined,
+    std::chrono::microseconds renderTime,
+    size_t updates,
+    SoftwareFrameUpdater &updater,
+    FrameContext const &context) -> CaptureModeStats {
+    using Clock = std::chrono::steady_clock;
+    auto stats = CaptureModeStats{};
+    auto consumerReadyAt = Clock::now();
+    while (stats.updates < updates) {
+        auto update = source.acquire(std::chrono::milliseconds{100});
+        if (!update) continue;
+        const auto acquiredAt = Clock::now();
+        if (isPipelined && source.stage(*update)) {
+            source.release();
+            stats.heldTime += Clock::now() - acquiredAt;
+            std::this_thread::sleep_until(consumerReadyAt); // the staged frame waits for the consumer
+            updater.update(update->frame, context);
+            consumerReadyAt = Clock::now() + renderTime;
+        }
+        else {
+            std::this_thread::sleep_until(consumerReadyAt);
+            updater.update(update->frame, context);
+            consumerReadyAt = Clock::now() + renderTime;
+            std::this_thread::sleep_until(consumerReadyAt); // the consumer holds the frame
+            source.release();
+            stats.heldTime += Clock::now() - acquiredAt;
+        }
+        stats.updates++;
+        stats.frames += update->frame.frames;
+    }
+    return stats;
+}
+
+/// accumulated frames and frame hold times of direct and pipelined capturing, and the added staging copies
+/// note: the desktop presents at 240 Hz in real time, the consumer renders for 8ms
+void measureStaging(Runner &runner) {
+    const auto renderTime = std::chrono::microseconds{8'000};
+    const auto updates = runner.options().checkOnly ? size_t{4} : size_t{30};
+    for (const auto kind : {SyntheticWorkload::Kind::Typing, SyntheticWorkload::Kind::Video}) {
+        const auto params = SyntheticWorkload::Params{.kind = kind, .frames = 60};
+        const auto workload = std::string{SyntheticWorkload::name(kind)};
+        const auto name = "staging/" + workload + " 1080p";
+        if (!runner.isSelected(name)) continue;
+
+        auto summary = std::string{};
+        for (const auto isPipelined : {false, true}) {
+            auto config = SyntheticWorkload::config(params);
+            config.presentInterval = std::chrono::microseconds{4'167};
+            config.loop = true;
+            auto source = SyntheticCaptureSource{std::move(config)};
+            auto context = FrameContext{.output_desc = source.init()};
+            auto updater = SoftwareFrameUpdater{params.dimension};
+            const auto stats = playCaptureMode(source, isPipelined, renderTime, updates, updater, context);
+            const auto count = static_cast<double>(stats.updates);
+            const auto heldMicros = std::chrono::duration<double, std::micro>(stats.heldTime).count() / count;
+            const auto framesTenths = static_cast<uint64_t>(static_cast<double>(stats.frames) * 10.0 / count + 0.5);
+            summary += std::string{summary.empty() ? "" : ", "} + (isPipelined ? "pipelined " : "direct ") +
+                std::to_string(framesTenths / 10) + "." + std::to_string(framesTenths % 10) + " frames/update held " +
+                std::to_string(static_cast<uint64_t>(heldMicros)) + "us";
+        }
+
+        // note: measures the staging copy of the last update of the workload again and again
+        auto source = SyntheticCaptureSource{SyntheticWorkload::config(params)};
+        source.init();
+        auto update = std::optional<CapturedUpdate>{};
+        while (!source.isDone()) {
+            if (auto next = source.acquire(std::chrono::milliseconds{1}); next) update = std::move(next);
+            source.release();
+        }
+        auto rects = std::vector<Rect>{};
+        auto bytes = uint64_t{};
+        for (const auto &rect : update->frame.dirty()) {
+            rects.push_back(Rect::fromRECT(rect));
+            bytes += static_cast<uint64_t>(core::area(rects.back())) * core::bytesPerPixel;
+        }
+        auto staging = core::CaptureStaging{};
+        runner.measure(name + " copy (" + summary + ")", Work{.items = rects.size(), .bytes = bytes}, [&] {
+            keep(staging.stage(update->frame.cpuImage, rects).data);
+        });
+    }
+}
+
+/// hashing costs and saved bytes of the change detection on 1080p
+void measureChangeDetection(Runner &runner) {
+    for (const auto kind : {SyntheticWorkload::Kind::CoalescedBurst, SyntheticWorkload::Kind::Video}) {
+        const auto params = SyntheticWorkload::Params{.kind = kind, .frames = 8}; // ends with a burst
+        auto source = SyntheticCaptureSource{SyntheticWorkload::config(params)};
+        const auto desc = source.init();
+        auto detector = core::TileChangeDetector{};
+        detector.reset(params.dimension, desc.Rotation);
+
+        // note: measures the detection of the last frame of the workload again and again
+        auto dirty = std::vector<Rect>{};
+        auto moved = std::vector<DXGI_OUTDUPL_MOVE_RECT>{};
+        auto image = core::SurfaceView{};
+        while (!source.isDone()) {
+            auto update = source.acquire(std::chrono::milliseconds{1});
+            if (!update) continue;
+            dirty.clear();
+            for (const auto &rect : update->frame.dirty()) dirty.push_back(Rect::fromRECT(rect));
+            moved.assign(update->frame.moved().begin(), update->frame.moved().end());
+            image = update->frame.cpuImage;
+            detector.detect(image, moved, dirty);
+            source.release();
+        }
+        const auto &stats = detector.stats();
+        const auto savedBytes = (stats.inputArea - stats.outputArea) * core::bytesPerPixel;
+        const auto name = "change-detection/" + std::string{SyntheticWorkload::name(kind)} + " 1080p (" +
+            std::to_string(savedBytes / static_cast<int64_t>(stats.frames) / 1024) + " KiB/frame saved)";
+        auto hashedBytes = uint64_t{};
+        for (const auto &rect : detector.tileRects(dirty)) hashedBytes += static_cast<uint64_t>(core::area(rect));
+        runner.measure(name, Work{.items = dirty.size(), .bytes = hashedBytes * core::bytesPerPixel}, [&] {
+            detector.detect(image, moved, dirty);
+            keep(detector.dirty().data());
+        });
+    }
+}
+
+/// search costs and saved bytes of the scroll detection on 1080p
+void measureScrollDetection(Runner &runner) {
+    for (const auto kind : {SyntheticWorkload::Kind::RepaintScrolling, SyntheticWorkload::Kind::Video}) {
+        const auto params = SyntheticWorkload::Params{.kind = kind, .frames = 60};
+        auto source = SyntheticCaptureSource{SyntheticWorkload::config(params)};
+        const auto desc = source.init();
+        auto detector = core::ScrollDetector{};
+        detector.reset(params.dimension, desc.Rotation);
+
+        // note: plays the workload up to the first scroll, the last two images are detected back and forth
+        auto before = core::Surface{params.dimension};
+        auto after = core::Surface{params.dimension};
+        auto dirty = std::vector<Rect>{};
+        auto moved = std::vector<DXGI_OUTDUPL_MOVE_RECT>{};
+        while (!source.isDone()) {
+            auto update = source.acquire(std::chrono::milliseconds{1});
+            if (!update) continue;
+            std::swap(before, after);
+            core::copyRect(update->frame.cpuImage, Rect{{}, after.dimension()}, after.span(), {});
+            dirty.clear();
+            for (const auto &rect : update->frame.dirty()) dirty.push_back(Rect::fromRECT(rect));
+            moved.assign(update->frame.moved().begin(), update->frame.moved().end());
+            source.release();
+            const auto scrolls = detector.stats().scrolls;
+            detector.detect(after.view(), moved, dirty);
+            if (detector.stats().scrolls != scrolls) break;
+        }
+        const auto input = detector.stats();
+        detector.detect(before.view(), moved, dirty);
+        const auto &output = detector.stats();
+        const auto savedArea = (output.inputArea - input.inputArea) - (output.outputArea - input.outputArea);
+        const auto name = "scroll-detection/" + std::string{SyntheticWorkload::name(kind)} + " 1080p (" +
+            std::to_string(savedArea * core::bytesPerPixel / 1024) + " KiB/frame saved)";
+        auto searchedBytes = uint64_t{};
+        for (const auto &rect : dirty) searchedBytes += static_cast<uint64_t>(core::area(rect)) * core::bytesPerPixel;
+        auto isBack = false;
+        runner.measure(name, Work{.items = dirty.size(), .bytes = searchedBytes}, [&] {
+            detector.detect(isBack ? before.view() : after.view(), moved, dirty);
+            isBack = !isBack;
+            keep(detector.dirty().data());
+        });
+    }
+}
+
+/// encoding costs of the session recorder on the capture thread
+void measureSessionTrace(Runner &runner) {
+    const auto display = Dimension{1920, 1080};
+    auto random = Random{23};
+    auto image = core::Surface{display};
+    auto span = image.span();
+    random.fill({span.data, image.bytes().size()});
+
+    const auto measureEncode = [&](std::string_view name, std::span<const RECT> dirty) {
+        const auto update = core::SessionTrace::Update{.hasImage = true, .dirty = dirty, .imageRects = dirty};
+        auto buffer = std::vector<uint8_t>(core::SessionTrace::encodedSize(update));
+        runner.measure(name, Work{.items = dirty.size(), .bytes = buffer.size()}, [&] {
+            core::SessionTrace::encode(update, image.view(), buffer);
+            keep(buffer.data());
+        });
+    };
+    auto glyphs = std::vector<RECT>{};
+    for (auto column = 0; column < 100; ++column) glyphs.push_back(RECT{100 + column * 9, 500, 108 + column * 9, 516});
+    measureEncode("session-trace/encode 100 glyphs", glyphs);
+    const auto video = RECT{320, 180, 1600, 900};
+    measureEncode("session-trace/encode video 720p", {&video, 1});
+}
+
+} // namespace
+
+void runPipeline(Runner &runner) {
+    checkSoftwareUpdater(runner);
+    checkStaging(runner);
+    checkWorkloads(runner);
+    checkChangeDetection(runner);
+    checkScrollDetection(runner);
+    checkScrollVisibleArea(runner);
+    checkSessionTrace(runner);
+    checkSessionReplayer(runner);
+    measureSoftwareUpdater(runner);
+    measureWorkloads(runner);
+    measureStaging(runner);
+    measureChangeDetection(runner);
+    measureScrollDetection(runner);
+    measureSessionTrace(runner);
+}
+
+} // namespace bench
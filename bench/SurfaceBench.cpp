@@ -0,0 +1,372 @@
+#include "Bench.h"
+
+#include "core/Hash.h"
+#include "core/LruCache.h"
+#include "core/MovePlanner.h"
+#include "core/PixelCopy.h"
+#include "core/PointerShape.h"
+#include "core/Surface.h"
+#include "core/SurfaceScaler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+
+namespace bench {
+
+namespace {
+
+using core::Surface;
+using Filter = core::SurfaceScaler::Filter;
+
+auto randomSurface(Random &random, Dimension dimension) -> Surface {
+    auto surface = Surface{dimension};
+    auto span = surface.span();
+    random.fill({span.data, surface.bytes().size()});
+    return surface;
+}
+
+auto surfaceBytes(Dimension dimension) -> uint64_t {
+    return static_cast<uint64_t>(dimension.width) * dimension.height * core::bytesPerPixel;
+}
+
+bool isEqual(core::SurfaceView a, core::SurfaceView b) {
+    if (a.dimension != b.dimension) return false;
+    const auto rowBytes = static_cast<size_t>(a.dimension.width) * core::bytesPerPixel;
+    for (auto y = 0; y < a.dimension.height; ++y) {
+        if (std::memcmp(a.row(y), b.row(y), rowBytes) != 0) return false;
+    }
+    return true;
+}
+
+auto pixelAt(core::SurfaceView surface, Point point) -> uint32_t {
+    auto pixel = uint32_t{};
+    std::memcpy(&pixel, surface.pixel(point), sizeof(pixel));
+    return pixel;
+}
+
+void checkCopyRect(Runner &runner) {
+    auto random = Random{2};
+    const auto from = randomSurface(random, {300, 200});
+    auto failures = 0;
+    for (auto iteration = 0; iteration < 200; ++iteration) {
+        auto to = randomSurface(random, {250, 180});
+        auto expected = Surface{to.dimension()};
+        std::memcpy(expected.span().data, to.bytes().data(), to.bytes().size());
+
+        const auto source = random.rect(from.dimension(), {250, 180});
+        const auto destination =
+            Point{random.uniform(0, 250 - source.width()), random.uniform(0, 180 - source.height())};
+        for (auto y = 0; y < source.height(); ++y) {
+            for (auto x = 0; x < source.width(); ++x) {
+                std::memcpy(
+                    expected.span().pixel({destination.x + x, destination.y + y}),
+                    from.view().pixel({source.left() + x, source.top() + y}),
+                    core::bytesPerPixel);
+            }
+        }
+        core::copyRect(from.view(), source, to.span(), destination);
+        if (!isEqual(to.view(), expected.view())) failures++;
+    }
+    runner.check("pixel-copy/copy rect", failures == 0);
+}
+
+void checkMovePlanner(Runner &runner) {
+    auto random = Random{1};
+    const auto dimension = Dimension{64, 48};
+    auto planner = core::MovePlanner{};
+    auto failures = 0;
+    for (auto iteration = 0; iteration < 2000; ++iteration) {
+        auto surface = randomSurface(random, dimension);
+        auto expected = Surface{dimension};
+        std::memcpy(expected.span().data, surface.bytes().data(), surface.bytes().size());
+
+        auto moves = std::vector<core::RectMove>{};
+        const auto count = random.uniform(1, 4);
+        for (auto m = 0; m < count; ++m) {
+            const auto source = random.rect(dimension, {40, 30});
+            const auto maxX = dimension.width - source.width();
+            const auto maxY = dimension.height - source.height();
+            // mostly small overlapping shifts like scrolling and dragging
+            const auto destination = random.uniform(0, 1) == 0
+                ? Point{random.uniform(0, maxX), random.uniform(0, maxY)}
+                : Point{
+                      std::clamp(source.left() + random.uniform(-3, 3), 0, maxX),
+                      std::clamp(source.top() + random.uniform(-3, 3), 0, maxY),
+                  };
+            moves.push_back({source, destination});
+        }
+        planner = core::MovePlanner{core::MovePlanner::Config{.maxBands = random.uniform(0, 5)}};
+        const auto &plan = planner.plan(moves);
+        auto temp = Surface{plan.tempDimension};
+        core::executeMovePlan(surface.span(), plan, temp.span());
+        core::applyMovesReference(expected.span(), moves);
+        if (!isEqual(surface.view(), expected.view())) failures++;
+    }
+    runner.check("move-planner/reference", failures == 0, std::to_string(failures) + " of 2000 differ");
+}
+
+void checkScaler(Runner &runner) {
+    auto random = Random{5};
+    const auto source = randomSurface(random, {96, 64});
+    auto scaler = core::SurfaceScaler{};
+
+    auto identity = Surface{source.dimension()};
+    for (const auto filter : {Filter::Nearest, Filter::Bilinear, Filter::IntegerRatio}) {
+        scaler.scale(source.view(), identity.span(), {.filter = filter});
+        const auto name = "scaler/identity filter " + std::to_string(static_cast<int>(filter));
+        runner.check(name, isEqual(identity.view(), source.view()));
+    }
+    // zooms just below 1 round to a 1×1 box
+    for (const auto filter : {Filter::Nearest, Filter::IntegerRatio}) {
+        scaler.scale(source.view(), identity.span(), {.outputZoom = 0.9996f, .filter = filter});
+        const auto name = "scaler/near identity filter " + std::to_string(static_cast<int>(filter));
+        runner.check(name, isEqual(identity.view(), source.view()));
+    }
+
+    auto nearest = Surface{{192, 128}};
+    auto replicate = Surface{{192, 128}};
+    scaler.scale(source.view(), nearest.span(), {.outputZoom = 2.0f, .filter = Filter::Nearest});
+    scaler.scale(source.view(), replicate.span(), {.outputZoom = 2.0f, .filter = Filter::IntegerRatio});
+    runner.check("scaler/replicate equals nearest", isEqual(nearest.view(), replicate.view()));
+
+    auto shifted = Surface{source.dimension()};
+    const auto background = uint32_t{0xFF102030};
+    scaler.scale(
+        source.view(),
+        shifted.span(),
+        {.captureOffset = {10.0f, 0.0f}, .filter = Filter::Nearest, .background = background});
+    runner.check(
+        "scaler/background",
+        pixelAt(shifted.view(), {9, 5}) == background &&
+            pixelAt(shifted.view(), {10, 5}) == pixelAt(source.view(), {0, 5}));
+
+    auto uniform = Surface{{96, 64}};
+    const auto color = uint32_t{0xFF4080C0};
+    for (auto y = 0; y < 64; ++y) {
+        for (auto x = 0; x < 96; ++x) std::memcpy(uniform.span().pixel({x, y}), &color, sizeof(color));
+    }
+    auto box = Surface{{32, 16}};
+    scaler.scale(uniform.view(), box.span(), {.outputZoom = 1.0f / 3.0f, .filter = Filter::IntegerRatio});
+    auto boxFailures = 0;
+    for (auto y = 0; y < 16; ++y) {
+        for (auto x = 0; x < 32; ++x) boxFailures += pixelAt(box.view(), {x, y}) == color ? 0 : 1;
+    }
+    runner.check("scaler/box average", boxFailures == 0);
+}
+
+void checkPointerShapes(Runner &runner) {
+    using Color = std::array<uint8_t, 4>;
+    auto random = Random{1};
+    auto converter = core::PointerShapeConverter{};
+    auto monochromeFailures = 0;
+    auto maskedFailures = 0;
+    for (auto iteration = 0; iteration < 200; ++iteration) {
+        const auto width = static_cast<UINT>(random.uniform(1, 70));
+        const auto height = static_cast<UINT>(random.uniform(1, 40));
+        const auto pitch = (width + 7) / 8 + static_cast<UINT>(random.uniform(0, 2));
+        const auto monochrome =
+            DXGI_OUTDUPL_POINTER_SHAPE_INFO{DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME, width, height * 2, pitch, {}};
+        auto masks = std::vector<uint8_t>(static_cast<size_t>(pitch) * height * 2);
+        random.fill(masks);
+        const auto converted = converter.convert(monochrome, masks);
+        for (auto row = 0u; row < height; ++row) {
+            for (auto column = 0u; column < width; ++column) {
+                const auto bit = 0x80 >> (column & 7);
+                const auto index = (column >> 3) + row * pitch;
+                const auto andBit = (masks[index] & bit) != 0;
+                const auto xorBit = (masks[index + static_cast<size_t>(height) * pitch] & bit) != 0;
+                const auto channel = uint8_t{xorBit ? uint8_t{0xFF} : uint8_t{0}};
+                const auto expected = Color{{channel, channel, channel, andBit ? uint8_t{0xFF} : uint8_t{0}}};
+                const auto *pixel = converted.pixel({static_cast<int>(column), static_cast<int>(row)});
+                if (std::memcmp(pixel, expected.data(), expected.size()) != 0) monochromeFailures++;
+            }
+        }
+
+        const auto masked = DXGI_OUTDUPL_POINTER_SHAPE_INFO{
+            DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR, width, height, width * 4 + 4, {}};
+        auto colors = std::vector<uint8_t>(static_cast<size_t>(masked.Pitch) * height);
+        for (auto &byte : colors) byte = random.uniform(0, 2) == 0 ? 0 : random.byte();
+        const auto normalized = converter.convert(masked, colors);
+        for (auto row = 0u; row < height; ++row) {
+            for (auto column = 0u; column < width; ++column) {
+                auto input = uint32_t{};
+                std::memcpy(&input, &colors[row * masked.Pitch + column * 4], sizeof(input));
+                const auto expected = (input & 0x00FFFFFFu) | ((input >> 24) != 0 ? 0xFF000000u : 0u);
+                if (pixelAt(normalized, {static_cast<int>(column), static_cast<int>(row)}) != expected) {
+                    maskedFailures++;
+                }
+            }
+        }
+    }
+    runner.check("pointer-shape/monochrome", monochromeFailures == 0);
+    runner.check("pointer-shape/masked color", maskedFailures == 0);
+
+    const auto color = DXGI_OUTDUPL_POINTER_SHAPE_INFO{DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR, 32, 32, 128, {}};
+    auto pixels = std::vector<uint8_t>(128 * 32);
+    random.fill(pixels);
+    const auto passed = converter.convert(color, pixels);
+    runner.check("pointer-shape/color", passed.data == pixels.data() && passed.pitch == 128);
+}
+
+/// shapes with equal data but other shape info are separate entries, found entries are evicted last
+void checkPointerShapeCache(Runner &runner) {
+    auto random = Random{5};
+    auto pixels = std::vector<uint8_t>(128 * 32);
+    random.fill(pixels);
+    const auto color = DXGI_OUTDUPL_POINTER_SHAPE_INFO{DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR, 32, 32, 128, {}};
+    auto hotSpot = color;
+    hotSpot.HotSpot = {3, 4};
+    auto masked = color;
+    masked.Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR;
+    auto narrow = color;
+    narrow.Width = 31;
+
+    const auto key = core::PointerShapeKey::make(color, pixels);
+    const auto hotSpotKey = core::PointerShapeKey::make(hotSpot, pixels);
+    const auto maskedKey = core::PointerShapeKey::make(masked, pixels);
+    const auto narrowKey = core::PointerShapeKey::make(narrow, pixels);
+    runner.check(
+        "pointer-shape-cache/key shape info",
+        key == core::PointerShapeKey::make(color, pixels) && !(key == hotSpotKey) && !(key == maskedKey) &&
+            !(key == narrowKey));
+
+    auto cache = core::LruCache<core::PointerShapeKey, int>{3};
+    cache.insert(key, 1);
+    cache.insert(hotSpotKey, 2);
+    cache.insert(maskedKey, 3);
+    const auto *hit = cache.find(key); // key becomes the most recently used, hotSpotKey the least
+    const auto isHit = hit != nullptr && *hit == 1;
+    cache.insert(narrowKey, 4);
+    const auto isEvicted = cache.size() == 3 && cache.find(hotSpotKey) == nullptr;
+    const auto isKept =
+        cache.find(key) != nullptr && cache.find(maskedKey) != nullptr && cache.find(narrowKey) != nullptr;
+    runner.check("pointer-shape-cache/hit", isHit);
+    runner.check("pointer-shape-cache/evicts least recently used", isEvicted && isKept);
+}
+
+void checkHash(Runner &runner) {
+    const auto hashText = [](std::string_view text) {
+        return core::hashBytes({reinterpret_cast<const uint8_t *>(text.data()), text.size()});
+    };
+    // reference values of xxHash64 with seed 0
+    runner.check(
+        "hash/xxhash64 reference",
+        hashText("") == 0xEF46DB3751D8E999ull && hashText("a") == 0xD24EC4F1A98C6E5Bull &&
+            hashText("abc") == 0x44BC2CF5AD770999ull);
+    // 32 bytes and more run through the 4 lane stripes and their merge
+    auto counting = std::array<uint8_t, 100>{};
+    for (auto i = size_t{}; i < counting.size(); ++i) counting[i] = static_cast<uint8_t>(i);
+    runner.check(
+        "hash/xxhash64 reference stripes",
+        hashText("The quick brown fox jumps over the lazy dog") == 0x0B242D361FDA71BCull &&
+            core::hashBytes(counting) == 0x6AC1E58032166597ull);
+}
+
+void measureCopies(Runner &runner) {
+    auto random = Random{3};
+    const auto full = Dimension{1920, 1080};
+    const auto from = randomSurface(random, full);
+    auto to = Surface{full};
+    runner.measure("pixel-copy/1080p frame", Work{.bytes = surfaceBytes(full)}, [&] {
+        core::copyRect(from.view(), Rect{{}, full}, to.span(), {});
+        keep(to.bytes().data());
+    });
+    const auto glyph = Rect{{100, 100}, {8, 16}};
+    runner.measure("pixel-copy/glyph 8x16", Work{.bytes = surfaceBytes(glyph.dimension)}, [&] {
+        core::copyRect(from.view(), glyph, to.span(), {200, 300});
+        keep(to.bytes().data());
+    });
+
+    auto surface = randomSurface(random, full);
+    auto temp = Surface{};
+    auto planner = core::MovePlanner{};
+    const auto measureMove = [&](std::string_view name, core::RectMove move) {
+        const auto moves = std::array{move};
+        runner.measure(name, Work{.bytes = surfaceBytes(move.source.dimension)}, [&] {
+            const auto &plan = planner.plan(moves);
+            if (temp.dimension().width < plan.tempDimension.width ||
+                temp.dimension().height < plan.tempDimension.height) {
+                temp = Surface{plan.tempDimension};
+            }
+            core::executeMovePlan(surface.span(), plan, temp.span());
+            keep(surface.bytes().data());
+        });
+    };
+    measureMove("move-planner/scroll 3 rows 1800x1000", {Rect{{60, 43}, {1800, 1000}}, {60, 40}});
+    measureMove("move-planner/scroll 3 columns 1800x1000", {Rect{{63, 40}, {1800, 1000}}, {60, 40}});
+    measureMove("move-planner/drag 800x600 by 5,7", {Rect{{300, 200}, {800, 600}}, {305, 207}});
+}
+
+void measureScaler(Runner &runner) {
+    auto random = Random{7};
+    auto scaler = core::SurfaceScaler{};
+    const auto measureScale = [&](std::string_view name, Dimension from, Dimension to, float zoom, Filter filter) {
+        const auto source = randomSurface(random, from);
+        auto target = Surface{to};
+        const auto args = core::SurfaceScaler::Args{.outputZoom = zoom, .filter = filter};
+        const auto pixels = static_cast<uint64_t>(to.width) * to.height;
+        runner.measure(name, Work{.items = pixels, .bytes = surfaceBytes(to)}, [&] {
+            scaler.scale(source.view(), target.span(), args);
+            keep(target.bytes().data());
+        });
+    };
+    measureScale("scaler/1080p to 4K nearest", {1920, 1080}, {3840, 2160}, 2.0f, Filter::Nearest);
+    measureScale("scaler/1080p to 4K bilinear", {1920, 1080}, {3840, 2160}, 2.0f, Filter::Bilinear);
+    measureScale("scaler/1080p to 4K integer", {1920, 1080}, {3840, 2160}, 2.0f, Filter::IntegerRatio);
+    measureScale("scaler/4K to 720p nearest", {3840, 2160}, {1280, 720}, 1.0f / 3.0f, Filter::Nearest);
+    measureScale("scaler/4K to 720p bilinear", {3840, 2160}, {1280, 720}, 1.0f / 3.0f, Filter::Bilinear);
+    measureScale("scaler/4K to 720p box", {3840, 2160}, {1280, 720}, 1.0f / 3.0f, Filter::IntegerRatio);
+}
+
+void measurePointerShapes(Runner &runner) {
+    auto random = Random{11};
+    auto converter = core::PointerShapeConverter{};
+    const auto monochrome = DXGI_OUTDUPL_POINTER_SHAPE_INFO{DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME, 32, 64, 4, {}};
+    auto masks = std::vector<uint8_t>(4 * 64);
+    random.fill(masks);
+    runner.measure("pointer-shape/monochrome 32x32", Work{.items = 32 * 32}, [&] {
+        keep(converter.convert(monochrome, masks));
+    });
+
+    const auto masked = DXGI_OUTDUPL_POINTER_SHAPE_INFO{DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR, 32, 32, 128, {}};
+    auto colors = std::vector<uint8_t>(128 * 32);
+    random.fill(colors);
+    runner.measure("pointer-shape/masked color 32x32", Work{.items = 32 * 32}, [&] {
+        keep(converter.convert(masked, colors));
+    });
+
+    const auto large = DXGI_OUTDUPL_POINTER_SHAPE_INFO{DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR, 256, 256, 1024, {}};
+    auto largePixels = std::vector<uint8_t>(1024 * 256);
+    random.fill(largePixels);
+    runner.measure("pointer-shape/key 256x256", Work{.bytes = largePixels.size()}, [&] {
+        keep(core::PointerShapeKey::make(large, largePixels));
+    });
+}
+
+void measureHash(Runner &runner) {
+    auto random = Random{13};
+    auto bytes = std::vector<uint8_t>(8 << 20);
+    random.fill(bytes);
+    runner.measure("hash/8 MiB", Work{.bytes = bytes.size()}, [&] { keep(core::hashBytes(bytes)); });
+    runner.measure("hash/64 bytes", Work{.bytes = 64}, [&] { keep(core::hashBytes({bytes.data(), 64})); });
+}
+
+} // namespace
+
+void runSurface(Runner &runner) {
+    checkCopyRect(runner);
+    checkMovePlanner(runner);
+    checkScaler(runner);
+    checkPointerShapes(runner);
+    checkPointerShapeCache(runner);
+    checkHash(runner);
+
+    measureCopies(runner);
+    measureScaler(runner);
+    measurePointerShapes(runner);
+    measureHash(runner);
+}
+
+} // namespace bench
@@ -0,0 +1,264 @@
+#include "Bench.h"
+
+#include "CapturedUpdate.h"
+
+#include "core/FrameTrace.h"
+#include "core/LatencyHistogram.h"
+#include "core/SpscRing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace bench {
+
+namespace {
+
+using core::FrameTrace;
+using core::LatencyHistogram;
+
+void checkHistogramBuckets(Runner &runner) {
+    auto success = LatencyHistogram::bucketIndex(LatencyHistogram::maxValue) == LatencyHistogram::bucketCount - 1;
+    for (auto value = uint64_t{}; value < 100'000'000; value += value < 1000 ? 1 : value / 64 + 1) {
+        const auto index = LatencyHistogram::bucketIndex(value);
+        success = success && index < LatencyHistogram::bucketCount && LatencyHistogram::bucketLow(index) <= value &&
+                  value <= LatencyHistogram::bucketHigh(index) &&
+                  LatencyHistogram::bucketHigh(index) - LatencyHistogram::bucketLow(index) <= value / 32;
+    }
+    runner.check("latency-histogram/buckets", success);
+}
+
+void checkHistogramPercentiles(Runner &runner) {
+    auto histogram = std::make_unique<LatencyHistogram>();
+    auto values = std::vector<uint64_t>{};
+    auto random = Random{3};
+    for (auto i = 0; i < 100'000; ++i) {
+        // long tail like real latencies
+        const auto value = static_cast<uint64_t>(random.uniform(500, 20'000)) *
+            static_cast<uint64_t>(random.uniform(0, 99) == 0 ? random.uniform(2, 50) : 1);
+        values.push_back(value);
+        histogram->record(value);
+    }
+    std::sort(values.begin(), values.end());
+    const auto summary = histogram->summary();
+    const auto isClose = [&](uint64_t actual, double percent) {
+        const auto expected = values[static_cast<size_t>(percent / 100.0 * static_cast<double>(values.size())) - 1];
+        return std::fabs(static_cast<double>(actual) - static_cast<double>(expected)) <=
+            static_cast<double>(expected) / 32.0 + 1.0;
+    };
+    runner.check(
+        "latency-histogram/percentiles",
+        summary.count == values.size() && summary.min == values.front() && summary.max == values.back() &&
+            isClose(summary.p50, 50.0) && isClose(summary.p90, 90.0) && isClose(summary.p99, 99.0));
+
+    histogram->reset();
+    runner.check("latency-histogram/reset", histogram->summary().count == 0 && histogram->percentile(50.0) == 0);
+}
+
+/// records written concurrently with the snapshots are never torn
+void checkFrameTrace(Runner &runner) {
+    constexpr auto stages = 7;
+    constexpr auto frames = uint64_t{200'000};
+    auto done = std::atomic<bool>{};
+    auto writer = std::thread{[&] {
+        FrameTrace::nameThread("bench writer");
+        for (auto frame = uint64_t{1}; frame <= frames; ++frame) {
+            FrameTrace::setFrame(frame);
+            // end - begin and stage are derived from the frame, so torn records are detected
+            const auto begin = static_cast<int64_t>(frame) * 1000;
+            const auto stage = static_cast<FrameTrace::Stage>(frame % stages);
+            FrameTrace::record(stage, begin, begin + static_cast<int64_t>(frame % 997));
+        }
+        done = true;
+    }};
+    const auto isWriter = [](FrameTrace::Record const &record, std::span<const std::string> names) {
+        return record.thread < names.size() && names[record.thread] == "bench writer";
+    };
+    auto torn = size_t{};
+    auto snapshots = size_t{};
+    while (!done || snapshots == 0) {
+        const auto records = FrameTrace::collect();
+        const auto names = FrameTrace::threadNames(); // includes all threads of the records
+        for (const auto &record : records) {
+            if (!isWriter(record, names)) continue;
+            const auto frame = record.frame;
+            if (record.begin != static_cast<int64_t>(frame) * 1000 ||
+                record.end - record.begin != static_cast<int64_t>(frame % 997) ||
+                record.stage != static_cast<FrameTrace::Stage>(frame % stages)) {
+                torn++;
+            }
+        }
+        snapshots++;
+    }
+    writer.join();
+
+    const auto names = FrameTrace::threadNames();
+    const auto kept = std::ranges::count_if(FrameTrace::collect(), [&](auto const &r) { return isWriter(r, names); });
+    runner.check("frame-trace/consistent snapshots", torn == 0, std::to_string(torn) + " torn records");
+    runner.check("frame-trace/ring capacity", static_cast<size_t>(kept) == FrameTrace::ringCapacity);
+
+    // restarted threads take over the rings of exited threads
+    const auto recordOnce = [] {
+        std::thread{[] { FrameTrace::record(FrameTrace::Stage::Acquire, 0, 1); }}.join();
+        return FrameTrace::threadNames().size();
+    };
+    const auto threads = recordOnce();
+    runner.check("frame-trace/reuses rings", recordOnce() == threads && recordOnce() == threads);
+
+    const auto records = std::vector<FrameTrace::Record>{{.frame = 42, .stage = FrameTrace::Stage::Render}};
+    const auto renderName = std::vector<std::string>{"render"};
+    const auto chrome = FrameTrace::toChromeTrace(records, renderName);
+    const auto csv = FrameTrace::toCsv(records, renderName);
+    runner.check(
+        "frame-trace/formats",
+        chrome.find("\"render\"") != std::string::npos && csv.find(",render,") != std::string::npos &&
+            csv.find("42") != std::string::npos);
+}
+
+/// ways to hand captured frames to the render thread
+/// note: Apc models the path before the FrameChannel - a heap allocated callback per frame in a locked queue
+enum class Handoff { SpscRing, Apc };
+
+struct HandoffItem {
+    CapturedUpdate update{};
+    int64_t pushedAt{}; // steady clock nanoseconds
+};
+
+auto nowNanos() -> int64_t {
+    const auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count();
+}
+
+/// hands frames from this thread to a consumer thread - returns true if all frames arrived in order
+/// note:
+/// * paced pushes the next frame only after the last one arrived (one frame in flight like the capture thread)
+/// * latencies records push to receive in nanoseconds
+bool runHandoff(Handoff handoff, uint64_t frames, bool isPaced, LatencyHistogram *latencies) {
+    auto received = std::atomic<uint64_t>{};
+    auto isOrdered = true; // only written by the consumer
+    const auto receive = [&](HandoffItem &item) {
+        if (latencies) latencies->record(static_cast<uint64_t>(nowNanos() - item.pushedAt));
+        const auto count = received.load(std::memory_order_relaxed) + 1;
+        isOrdered = isOrdered && item.update.frame.sequence == count;
+        received.store(count, std::memory_order_release);
+    };
+    const auto makeItem = [](uint64_t frame) {
+        auto item = HandoffItem{};
+        item.update.frame.sequence = frame;
+        item.pushedAt = nowNanos();
+        return item;
+    };
+    const auto awaitReceived = [&](uint64_t frame) {
+        while (received.load(std::memory_order_acquire) < frame) std::this_thread::yield();
+    };
+
+    if (handoff == Handoff::SpscRing) {
+        auto ring = std::make_unique<core::SpscRing<HandoffItem, 4>>(); // capacity of the FrameChannel
+        auto signal = core::WakeSignal{};
+        auto consumer = std::thread{[&] {
+            auto item = HandoffItem{};
+            while (received.load(std::memory_order_relaxed) < frames) {
+                signal.wait();
+                while (ring->tryPop(item)) receive(item);
+            }
+        }};
+        for (auto frame = uint64_t{1}; frame <= frames; ++frame) {
+            auto item = makeItem(frame);
+            while (!ring->tryPush(std::move(item))) std::this_thread::yield();
+            signal.notify();
+            if (isPaced) awaitReceived(frame);
+        }
+        consumer.join();
+    }
+    else {
+        auto mutex = std::mutex{};
+        auto wake = std::condition_variable{};
+        auto queue = std::vector<std::move_only_function<void()>>{};
+        auto consumer = std::thread{[&] {
+            auto callbacks = std::vector<std::move_only_function<void()>>{};
+            while (received.load(std::memory_order_relaxed) < frames) {
+                {
+                    auto lock = std::unique_lock{mutex};
+                    wake.wait(lock, [&] { return !queue.empty(); });
+                    std::swap(callbacks, queue);
+                }
+                for (auto &callback : callbacks) callback();
+                callbacks.clear();
+            }
+        }};
+        for (auto frame = uint64_t{1}; frame <= frames; ++frame) {
+            {
+                auto lock = std::lock_guard{mutex};
+                queue.emplace_back([&receive, item = makeItem(frame)]() mutable { receive(item); });
+            }
+            wake.notify_one();
+            if (isPaced) awaitReceived(frame);
+        }
+        consumer.join();
+    }
+    return isOrdered && received.load() == frames;
+}
+
+auto handoffName(Handoff handoff) -> std::string_view {
+    return handoff == Handoff::SpscRing ? "spsc ring" : "apc queue";
+}
+
+/// every frame arrives once and in order, streamed or one at a time
+void checkHandoff(Runner &runner) {
+    for (const auto handoff : {Handoff::SpscRing, Handoff::Apc}) {
+        const auto isComplete =
+            runHandoff(handoff, 10'000, false, nullptr) && runHandoff(handoff, 1'000, true, nullptr);
+        runner.check("handoff/" + std::string{handoffName(handoff)} + " in order", isComplete);
+    }
+}
+
+/// wake up latency with one frame in flight and streaming throughput of both handoffs
+void measureHandoff(Runner &runner) {
+    constexpr auto frames = uint64_t{10'000};
+    for (const auto handoff : {Handoff::SpscRing, Handoff::Apc}) {
+        auto latencies = std::make_unique<LatencyHistogram>();
+        runHandoff(handoff, runner.options().checkOnly ? 100 : frames, true, latencies.get());
+        const auto summary = latencies->summary();
+        const auto micros = [](uint64_t nanos) {
+            const auto tenths = (nanos + 50) / 100;
+            return std::to_string(tenths / 10) + "." + std::to_string(tenths % 10) + "us";
+        };
+        const auto name = "handoff/" + std::string{handoffName(handoff)} + " " + std::to_string(frames) +
+            " frames (p50 " + micros(summary.p50) + " p99 " + micros(summary.p99) + ")";
+        runner.measure(name, Work{.items = frames}, [&] { runHandoff(handoff, frames, false, nullptr); });
+    }
+}
+
+void measureTiming(Runner &runner) {
+    auto histogram = std::make_unique<LatencyHistogram>();
+    auto value = uint64_t{1};
+    runner.measure("latency-histogram/record", Work{.items = 1}, [&] {
+        value = value * 6364136223846793005ull + 1442695040888963407ull; // spread over all buckets
+        histogram->record(value >> 40);
+    });
+    runner.measure("latency-histogram/summary", Work{}, [&] { keep(histogram->summary()); });
+
+    runner.measure("frame-trace/record", Work{.items = 1}, [&] {
+        const auto begin = FrameTrace::now();
+        FrameTrace::record(FrameTrace::Stage::Update, begin, FrameTrace::now());
+    });
+    runner.measure("frame-trace/collect", Work{}, [&] { keep(FrameTrace::collect()); });
+}
+
+} // namespace
+
+void runTiming(Runner &runner) {
+    checkHistogramBuckets(runner);
+    checkHistogramPercentiles(runner);
+    checkFrameTrace(runner);
+    checkHandoff(runner);
+    measureTiming(runner);
+    measureHandoff(runner);
+}
+
+} // namespace bench
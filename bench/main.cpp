@@ -0,0 +1,50 @@
+#include "Bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string_view>
+
+namespace {
+
+void printUsage(const char *program) {
+    printf(
+        "usage: %s [--check] [--csv] [--filter <text>] [--min-time <ms>]\n"
+        "  --check     run all checks, measured operations run only once\n"
+        "  --csv       print the measurements as csv\n"
+        "  --filter    only run checks and measurements with names that contain the text\n"
+        "  --min-time  milliseconds spent measuring each operation (default 250)\n",
+        program);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    auto options = bench::Options{};
+    for (auto i = 1; i < argc; ++i) {
+        const auto arg = std::string_view{argv[i]};
+        const auto hasValue = i + 1 < argc;
+        if (arg == "--check") {
+            options.checkOnly = true;
+        }
+        else if (arg == "--csv") {
+            options.csv = true;
+        }
+        else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        }
+        else if (arg == "--min-time" && hasValue) {
+            options.minTime = std::chrono::milliseconds{atoi(argv[++i])};
+        }
+        else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    auto runner = bench::Runner{options};
+    bench::runGeometry(runner);
+    bench::runSurface(runner);
+    bench::runPipeline(runner);
+    bench::runTiming(runner);
+    return runner.finish();
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "core/RectTransform.h"
 #include "meta/comptr.h"
 
 #include <d3d11.h>
@@ -11,12 +12,7 @@ struct BaseRenderer {
         ComPtr<ID3D11Device> device{};
         ComPtr<ID3D11DeviceContext> deviceContext{};
     };
-    struct Vertex {
-        float x{};
-        float y{};
-        float u{};
-        float v{};
-    };
+    using Vertex = core::Vertex;
     using Color = std::array<float, 4>;
 
     BaseRenderer(InitArgs &&args);
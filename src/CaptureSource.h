@@ -0,0 +1,47 @@
+#pragma once
+#include "core/Surface.h"
+#include "win32/DxgiTypes.h"
+
+#include <chrono>
+#include <optional>
+
+struct CapturedUpdate;
+
+struct Unexpected {
+    const char *text{};
+};
+
+struct Expected {
+    const char *text{};
+};
+
+/// Provider of captured frames
+/// note: all methods are called from the CaptureThread
+struct CaptureSource {
+    using Milliseconds = std::chrono::milliseconds;
+
+    CaptureSource() = default;
+    CaptureSource(CaptureSource const &) = delete;
+    CaptureSource &operator=(CaptureSource const &) = delete;
+    virtual ~CaptureSource() = default;
+
+    /// prepare capturing and describe the captured output
+    virtual auto init() -> DXGI_OUTPUT_DESC = 0;
+
+    /// wait up to timeout for the next frame
+    /// note: the frame stays acquired until release() is called
+    virtual auto acquire(Milliseconds timeout) -> std::optional<CapturedUpdate> = 0;
+
+    /// allow the source to reuse the resources of the last acquired frame
+    virtual void release() = 0;
+
+    /// copy the changed content of update into memory owned by the source
+    /// returns true if update no longer depends on the acquired frame (release() may be called early)
+    /// note: staged content stays valid until the next but one frame is staged
+    virtual bool stage(CapturedUpdate &) { return false; }
+
+    /// read the changed content of update back into system memory (used to record sessions and detect changes)
+    /// returns an empty view if the content is not available
+    /// note: the view stays valid until readback is called twice more
+    virtual auto readback(CapturedUpdate const &) -> core::SurfaceView { return {}; }
+};
@@ -1,24 +1,9 @@
 #include "CaptureThread.h"
 
 #include "CapturedUpdate.h"
+#include "SessionRecorder.h"
 
-#include "meta/scope_guard.h"
-
-namespace {
-
-void setDesktop() {
-    const auto flags = 0;
-    const auto inherit = false;
-    const auto access = GENERIC_ALL;
-    auto desktop = OpenInputDesktop(flags, inherit, access);
-    if (!desktop) throw Expected{"Failed to open desktop"};
-    LATER(CloseDesktop(desktop));
-
-    const auto result = SetThreadDesktop(desktop);
-    if (!result) throw Expected{"Failed to set desktop"};
-}
-
-} // namespace
+#include "core/FrameTrace.h"
 
 auto GetCurrentThreadHandle() -> HANDLE {
     HANDLE output{};
@@ -38,46 +23,125 @@ CaptureThread::~CaptureThread() {
 
 void CaptureThread::start(StartArgs &&args) {
     if (m_stdThread) return; // already started
-    m_display = args.display;
-    m_device = std::move(args.device);
+    m_source = std::move(args.source);
     m_context.offset = args.offset;
+    m_visibleArea = args.visibleArea;
     m_keepRunning = true;
     m_doCapture = true;
+    m_queuedApcs = 0; // APCs of the last run are dropped with its thread
+    m_startedAt = std::chrono::steady_clock::now();
+    m_wakeups = 0;
+    m_frames = 0;
+    m_totalLatency = 0;
+    m_maxLatency = 0;
+    m_dirtyRectsIn = 0;
+    m_dirtyRectsOut = 0;
+    m_overdrawArea = 0;
+    m_culledArea = 0;
+    m_scrolls = 0;
+    m_scrolledArea = 0;
+    m_unchangedArea = 0;
+    m_detectTime = 0;
     m_stdThread.emplace([this] { run(); });
+    // note: APCs queued before run() starts are delivered at its first alertable wait
+    m_thread = Thread::fromHandle(m_stdThread->native_handle());
+}
+
+auto CaptureThread::stats() const -> Stats {
+    return {
+        .elapsed = std::chrono::steady_clock::now() - m_startedAt,
+        .wakeups = m_wakeups.load(std::memory_order_relaxed),
+        .frames = m_frames.load(std::memory_order_relaxed),
+        .totalLatency = std::chrono::nanoseconds{m_totalLatency.load(std::memory_order_relaxed)},
+        .maxLatency = std::chrono::nanoseconds{m_maxLatency.load(std::memory_order_relaxed)},
+        .dirtyRectsIn = m_dirtyRectsIn.load(std::memory_order_relaxed),
+        .dirtyRectsOut = m_dirtyRectsOut.load(std::memory_order_relaxed),
+        .overdrawArea = m_overdrawArea.load(std::memory_order_relaxed),
+        .culledArea = m_culledArea.load(std::memory_order_relaxed),
+        .scrolls = m_scrolls.load(std::memory_order_relaxed),
+        .scrolledArea = m_scrolledArea.load(std::memory_order_relaxed),
+        .unchangedArea = m_unchangedArea.load(std::memory_order_relaxed),
+        .detectTime = std::chrono::nanoseconds{m_detectTime.load(std::memory_order_relaxed)},
+    };
 }
 
 void CaptureThread::next() {
-    m_thread.queueUserApc([this]() { capture_next(); });
+    queueApc([this]() { capture_next(); });
+}
+
+void CaptureThread::updateVisibleArea(std::optional<win32::Rect> area) {
+    queueApc([this, area]() { capture_visibleArea(area); });
+}
+
+void CaptureThread::updateRecorder(std::shared_ptr<SessionRecorder> recorder) {
+    queueApc([this, recorder = std::move(recorder)]() { capture_recorder(recorder); });
 }
 
 void CaptureThread::stop() {
-    m_thread.queueUserApc([this]() { capture_stop(); });
+    queueApc([this]() { capture_stop(); });
     m_stdThread.reset();
+    m_source.reset();
 }
 
 void CaptureThread::capture_next() {
-    m_dupl->ReleaseFrame();
+    if (m_hasAcquired) {
+        m_source->release();
+        m_hasAcquired = false;
+    }
     m_doCapture = true;
 }
 
 void CaptureThread::capture_stop() { m_keepRunning = false; }
 
+void CaptureThread::capture_visibleArea(std::optional<win32::Rect> area) {
+    m_visibleArea = area;
+    // note: never update outside of the display
+    const auto display = win32::Rect{{}, win32::Rect::fromRECT(m_context.output_desc.DesktopCoordinates).dimension};
+    const auto visible = area ? core::intersect(*area, display).value_or(win32::Rect{}) : display;
+    m_culler.setVisibleArea(visible);
+    // note: shadow and tiles outside of the old visible area are stale
+    m_scrollDetector.setVisibleArea(visible);
+    m_changeDetector.reset(display.dimension, m_context.output_desc.Rotation);
+}
+
+void CaptureThread::capture_recorder(std::shared_ptr<SessionRecorder> recorder) {
+    m_recorder = std::move(recorder);
+    m_recordEntireDisplay = m_recorder != nullptr;
+}
+
 void CaptureThread::run() {
-    m_thread = Thread::fromCurrent();
+    FRAME_TRACE_THREAD("capture");
     try {
-        setDesktop();
-        initCapture();
+        m_context.output_desc = m_source->init();
+        m_culler = core::VisibleAreaCuller{};
+        m_hasAcquired = false;
+        m_staged.reset();
+        m_sequence = 0;
+        m_readback = {};
+        m_readbackSequence = 0;
+        m_recordEntireDisplay = m_recorder != nullptr; // output might have changed
+        m_acquireTimeout = core::AdaptiveTimeout{m_config.acquireTimeout};
+        if (m_config.coalesceDirty) m_coalescer = core::RectCoalescer{*m_config.coalesceDirty};
+        if (m_config.detectScrolls) {
+            const auto display = win32::Rect::fromRECT(m_context.output_desc.DesktopCoordinates);
+            m_scrollDetector = core::ScrollDetector{*m_config.detectScrolls};
+            m_scrollDetector.reset(display.dimension, m_context.output_desc.Rotation);
+        }
+        if (m_config.detectChanges) m_changeDetector = core::TileChangeDetector{*m_config.detectChanges};
+        capture_visibleArea(m_visibleArea);
         while (m_keepRunning) {
-            if (m_doCapture) {
-                auto frame = captureUpdate();
-                if (frame) {
-                    m_config.setFrameCallback(m_config.callbackPtr, std::move(*frame), m_context, m_config.threadIndex);
-                    m_doCapture = false;
-                }
+            if (m_config.pipelined) {
+                capturePipelined();
+            }
+            else if (m_doCapture) {
+                captureDirect();
             }
-            const auto timeout = m_doCapture ? 1 : INFINITE;
+            // note: blocking happens in acquire - otherwise we just run the queued APCs
+            const auto isWaiting = m_config.pipelined ? (m_staged || m_hasAcquired) && !m_doCapture : !m_doCapture;
+            const auto timeout = isWaiting ? INFINITE : 0;
             const auto alertable = true;
             SleepEx(timeout, alertable);
+            if (isWaiting) m_wakeups.fetch_add(1, std::memory_order_relaxed);
         }
     }
     catch (...) {
@@ -89,99 +153,144 @@ void CaptureThread::run() {
     }
 }
 
-void CaptureThread::initCapture() {
-    auto dxgiDevice = ComPtr<IDXGIDevice>{};
-    auto dxResult = m_device.As(&dxgiDevice);
-    if (IS_ERROR(dxResult)) throw Unexpected{"Failed to get IDXGIDevice from device"};
-
-    auto dxgiAdapter = ComPtr<IDXGIAdapter>{};
-    dxResult = dxgiDevice->GetParent(__uuidof(IDXGIAdapter), &dxgiAdapter);
-    const auto parentExpected = {DXGI_ERROR_ACCESS_LOST, HRESULT{WAIT_ABANDONED}};
-    if (IS_ERROR(dxResult)) handleDeviceError("Failed to get IDXGIAdapter from device", dxResult, parentExpected);
-
-    auto dxgiOutput = ComPtr<IDXGIOutput>{};
-    dxResult = dxgiAdapter->EnumOutputs(m_display, &dxgiOutput);
-    if (IS_ERROR(dxResult)) handleDeviceError("Failed to get ouput from adapter", dxResult, {DXGI_ERROR_NOT_FOUND});
-
-    dxResult = dxgiOutput->GetDesc(&m_context.output_desc);
-    if (IS_ERROR(dxResult)) handleDeviceError("Failed to get ouput description", dxResult, {});
-
-    auto dxgiOutput1 = ComPtr<IDXGIOutput1>{};
-    dxResult = dxgiOutput.As(&dxgiOutput1);
-    if (IS_ERROR(dxResult)) throw Unexpected{"Failed to get IDXGIOutput1 from dxgi_output"};
-
-    dxResult = dxgiOutput1->DuplicateOutput(m_device.Get(), &m_dupl);
-    if (IS_ERROR(dxResult)) {
-        if (DXGI_ERROR_NOT_CURRENTLY_AVAILABLE == dxResult)
-            throw Unexpected{"Maximum of desktop duplications reached!"};
-        const auto duplicateExpected = {
-            HRESULT{E_ACCESSDENIED},
-            DXGI_ERROR_UNSUPPORTED,
-            DXGI_ERROR_SESSION_DISCONNECTED,
-        };
-        handleDeviceError("Failed to get duplicate output from device", dxResult, duplicateExpected);
+auto CaptureThread::acquire() -> std::optional<CapturedUpdate> {
+    FRAME_TRACE_FRAME(m_sequence + 1);
+    // note: AcquireNextFrame is not alertable - already queued APCs (like stop) run first instead of waiting
+    const auto isInterrupted = m_queuedApcs.load(std::memory_order_acquire) != 0;
+    auto frame = m_source->acquire(isInterrupted ? std::chrono::milliseconds{} : m_acquireTimeout.current());
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    if (!frame) {
+        if (!isInterrupted) m_acquireTimeout.onTimeout();
+        return {};
     }
+    m_acquireTimeout.onResult();
+    frame->frame.sequence = ++m_sequence;
+    m_acquiredAt = std::chrono::steady_clock::now();
+    m_hasAcquired = true;
+    cullInvisible(frame->frame);
+    if (m_config.coalesceDirty) coalesceDirty(frame->frame);
+    // note: the detectors see the entire display, so it is read back only once
+    const auto isEntireDisplay = m_recordEntireDisplay && frame->frame.hasImage();
+    if (isEntireDisplay) recordEntireDisplay(frame->frame);
+    if (m_config.detectScrolls || m_config.detectChanges) detectContent(*frame);
+    if (isEntireDisplay) recordEntireDisplay(frame->frame); // detectors dropped unchanged parts
+    return frame;
 }
 
-void CaptureThread::handleDeviceError(const char *text, HRESULT result, std::initializer_list<HRESULT> expected) {
-    if (m_device) {
-        const auto reason = m_device->GetDeviceRemovedReason();
-        if (S_OK != reason) throw Expected{text};
-    }
-    for (const auto cand : expected) {
-        if (result == cand) throw Expected{text};
+void CaptureThread::cullInvisible(FrameUpdate &frame) {
+    m_dirtyRects.clear();
+    for (const auto &rect : frame.dirty()) m_dirtyRects.push_back(win32::Rect::fromRECT(rect));
+    const auto before = m_culler.stats();
+    m_culler.cull(frame.moved(), m_dirtyRects, frame.hasImage());
+    frame.replaceRects(m_culler.moved(), m_culler.dirty());
+
+    const auto &after = m_culler.stats();
+    const auto culled = (after.inputArea - before.inputArea) - (after.outputArea - before.outputArea);
+    m_culledArea.fetch_add(culled, std::memory_order_relaxed);
+}
+
+void CaptureThread::coalesceDirty(FrameUpdate &frame) {
+    const auto dirty = frame.dirty();
+    if (dirty.size() < 2) return;
+    m_dirtyRects.clear();
+    for (const auto &rect : dirty) m_dirtyRects.push_back(win32::Rect::fromRECT(rect));
+    frame.replaceDirty(m_coalescer.coalesce(m_dirtyRects));
+
+    const auto &stats = m_coalescer.lastStats();
+    m_dirtyRectsIn.fetch_add(stats.inputRects, std::memory_order_relaxed);
+    m_dirtyRectsOut.fetch_add(stats.outputRects, std::memory_order_relaxed);
+    m_overdrawArea.fetch_add(stats.overdrawArea, std::memory_order_relaxed);
+}
+
+void CaptureThread::detectContent(CapturedUpdate &update) {
+    auto &frame = update.frame;
+    if (frame.dirty().empty() && frame.moved().empty()) return;
+    const auto start = std::chrono::steady_clock::now();
+    m_dirtyRects.clear();
+    for (const auto &rect : frame.dirty()) m_dirtyRects.push_back(win32::Rect::fromRECT(rect));
+    m_moveRects.assign(frame.moved().begin(), frame.moved().end());
+    auto image = frame.cpuImage;
+    if (!image && frame.hasImage() && !m_dirtyRects.empty()) {
+        // note: whole tiles are hashed, so whole tiles are read back
+        if (m_config.detectChanges) frame.replaceDirty(m_changeDetector.tileRects(m_dirtyRects));
+        image = m_source->readback(update);
+        m_readback = image;
+        m_readbackSequence = frame.sequence;
     }
-    throw Unexpected{text};
-}
-
-auto CaptureThread::captureUpdate() -> std::optional<CapturedUpdate> {
-    auto result = std::optional<CapturedUpdate>{};
-    const auto time = 10;
-    auto resource = ComPtr<IDXGIResource>{};
-    auto frameInfo = DXGI_OUTDUPL_FRAME_INFO{};
-    auto dxResult = m_dupl->AcquireNextFrame(time, &frameInfo, &resource);
-    if (DXGI_ERROR_WAIT_TIMEOUT == dxResult) return {};
-    if (IS_ERROR(dxResult)) throw Expected{"Failed to acquire next frame in capture_thread"};
-
-    result.emplace();
-    auto &update = result.value();
-    update.frame.frames = frameInfo.AccumulatedFrames;
-    update.frame.present_time = frameInfo.LastPresentTime.QuadPart;
-    update.frame.rects_coalesced = frameInfo.RectsCoalesced;
-    update.frame.protected_content_masked_out = frameInfo.ProtectedContentMaskedOut;
-
-    if (0 != frameInfo.TotalMetadataBufferSize) {
-        update.frame.buffer.resize(frameInfo.TotalMetadataBufferSize);
-
-        auto movedPtr = update.frame.buffer.data();
-        dxResult = m_dupl->GetFrameMoveRects(
-            frameInfo.TotalMetadataBufferSize,
-            std::bit_cast<DXGI_OUTDUPL_MOVE_RECT *>(movedPtr),
-            &update.frame.moved_bytes);
-        if (IS_ERROR(dxResult)) throw Expected{"Failed to get frame moved rects in capture_thread"};
-
-        auto dirtyPtr = movedPtr + update.frame.moved_bytes;
-        const auto dirtySize = frameInfo.TotalMetadataBufferSize - update.frame.moved_bytes;
-        dxResult = m_dupl->GetFrameDirtyRects(dirtySize, std::bit_cast<RECT *>(dirtyPtr), &update.frame.dirty_bytes);
-        if (IS_ERROR(dxResult)) throw Expected{"Failed to get frame dirty rects in capture_thread"};
+    if (m_config.detectScrolls) {
+        const auto before = m_scrollDetector.stats();
+        m_scrollDetector.detect(image, m_moveRects, m_dirtyRects);
+        m_moveRects.assign(m_scrollDetector.moved().begin(), m_scrollDetector.moved().end());
+        m_dirtyRects.assign(m_scrollDetector.dirty().begin(), m_scrollDetector.dirty().end());
+
+        const auto &after = m_scrollDetector.stats();
+        const auto scrolled = (after.inputArea - before.inputArea) - (after.outputArea - before.outputArea);
+        m_scrolls.fetch_add(after.scrolls - before.scrolls, std::memory_order_relaxed);
+        m_scrolledArea.fetch_add(scrolled, std::memory_order_relaxed);
     }
-    if (!update.frame.dirty().empty()) {
-        dxResult = resource.As(&update.frame.image);
-        if (IS_ERROR(dxResult)) throw Unexpected{"Failed to get ID3D11Texture from resource in capture_thread"};
+    if (m_config.detectChanges) {
+        const auto before = m_changeDetector.stats();
+        m_changeDetector.detect(image, m_moveRects, m_dirtyRects);
+        m_dirtyRects.assign(m_changeDetector.dirty().begin(), m_changeDetector.dirty().end());
+
+        const auto &after = m_changeDetector.stats();
+        const auto unchanged = (after.inputArea - before.inputArea) - (after.outputArea - before.outputArea);
+        m_unchangedArea.fetch_add(unchanged, std::memory_order_relaxed);
     }
+    frame.replaceRects(m_moveRects, m_dirtyRects);
+    m_detectTime.fetch_add(
+        std::chrono::nanoseconds{std::chrono::steady_clock::now() - start}.count(), std::memory_order_relaxed);
+}
+
+void CaptureThread::recordEntireDisplay(FrameUpdate &frame) {
+    const auto display = win32::Rect{{}, win32::Rect::fromRECT(m_context.output_desc.DesktopCoordinates).dimension};
+    frame.replaceRects({}, {&display, 1});
+    m_recordEntireDisplay = false;
+}
 
-    update.pointer.update_time = frameInfo.LastMouseUpdateTime.QuadPart;
-    update.pointer.position = frameInfo.PointerPosition;
-    if (0 != frameInfo.PointerShapeBufferSize) {
-        update.pointer.shape_buffer.resize(frameInfo.PointerShapeBufferSize);
-
-        auto pointerPtr = update.pointer.shape_buffer.data();
-        const auto pointerSize = static_cast<uint32_t>(update.pointer.shape_buffer.size());
-        auto sizeRequiredDummy = UINT{};
-        dxResult =
-            m_dupl->GetFramePointerShape(pointerSize, pointerPtr, &sizeRequiredDummy, &update.pointer.shape_info);
-        if (IS_ERROR(dxResult)) throw Expected{"Failed to get frame pointer shape in capture_thread"};
-        // assert(size_required_dummy == frame.pointer_data.size());
+void CaptureThread::record(CapturedUpdate const &update) {
+    // note: the final rects of a detected frame are inside of the rects it was read back with
+    auto image = update.frame.cpuImage;
+    if (!image) image = m_readbackSequence == update.frame.sequence ? m_readback : m_source->readback(update);
+    // note: a dropped update leaves a gap in the recording, the next frame repairs it
+    if (!m_recorder->record(update, m_context, image)) m_recordEntireDisplay = true;
+}
+
+void CaptureThread::captureDirect() {
+    auto frame = acquire();
+    if (frame) deliver(std::move(*frame));
+}
+
+void CaptureThread::capturePipelined() {
+    if (!m_staged && !m_hasAcquired) {
+        auto frame = acquire();
+        if (frame) {
+            FRAME_TRACE_BEGIN(stagingStart);
+            const auto isStaged = m_source->stage(*frame);
+            FRAME_TRACE_END(stagingStart, Staging);
+            if (isStaged) {
+                m_source->release();
+                m_hasAcquired = false;
+            }
+            m_staged = std::move(frame);
+        }
+    }
+    if (m_staged && m_doCapture) {
+        deliver(std::move(*m_staged));
+        m_staged.reset();
     }
-    return update;
+}
+
+void CaptureThread::deliver(CapturedUpdate &&update) {
+    const auto latency = std::chrono::nanoseconds{std::chrono::steady_clock::now() - m_acquiredAt}.count();
+    FRAME_TRACE_FRAME(update.frame.sequence);
+    if (m_recorder) record(update);
+    FRAME_TRACE_BEGIN(deliverStart);
+    m_config.setFrameCallback(m_config.callbackPtr, std::move(update), m_context, m_config.threadIndex);
+    FRAME_TRACE_END(deliverStart, Deliver);
+    m_doCapture = false;
+
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_totalLatency.fetch_add(latency, std::memory_order_relaxed);
+    if (latency > m_maxLatency.load(std::memory_order_relaxed)) m_maxLatency.store(latency, std::memory_order_relaxed);
 }
@@ -1,29 +1,29 @@
 #pragma once
+#include "CaptureSource.h"
 #include "FrameContext.h"
 
-#include "meta/comptr.h"
+#include "core/AdaptiveTimeout.h"
+#include "core/RectCoalescer.h"
+#include "core/ScrollDetector.h"
+#include "core/TileChangeDetector.h"
+#include "core/VisibleAreaCuller.h"
 #include "win32/Geometry.h"
 #include "win32/Thread.h"
 
 #include <Windows.h>
-#include <d3d11.h>
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <optional>
 #include <thread>
-
-struct CapturedUpdate;
-
-struct Unexpected {
-    const char *text{};
-};
-
-struct Expected {
-    const char *text{};
-};
+#include <vector>
 
 /// returns the global thread handle (usable in any thread!)
 HANDLE GetCurrentThreadHandle();
 
+struct SessionRecorder;
+
 using win32::Point;
 using win32::Thread;
 
@@ -35,6 +35,16 @@ struct CaptureThread {
 
     struct Config {
         size_t threadIndex{}; // identifier to this thread
+        /// stage each frame and release it right away, the next frame is acquired while the last one is consumed
+        bool pipelined{};
+        /// short while frames arrive, long when idle
+        /// note: AcquireNextFrame is not alertable - APCs queued during an idle acquire wait up to the long timeout
+        core::AdaptiveTimeout::Config acquireTimeout{};
+        std::optional<core::RectCoalescer::CostModel> coalesceDirty{}; // merge dirty rects before staging
+        /// replace scrolled dirty content with moves (reads DXGI frames back into system memory!)
+        std::optional<core::ScrollDetector::Config> detectScrolls{};
+        /// drop dirty tiles with unchanged content (reads DXGI frames back into system memory!)
+        std::optional<core::TileChangeDetector::Config> detectChanges{};
 
         SetErrorFunc *setErrorCallback{&CaptureThread::noopSetErrorCallback};
         SetFrameFunc *setFrameCallback{&CaptureThread::noopSetFrameCallback};
@@ -61,40 +71,107 @@ struct CaptureThread {
     ~CaptureThread();
 
     struct StartArgs {
-        int display{}; // index of the display to capture
-        ComPtr<ID3D11Device> device; // device used for capturing
+        std::unique_ptr<CaptureSource> source; // provider of the captured frames
         Point offset{}; // offset from desktop to target coordinates
+        std::optional<win32::Rect> visibleArea{}; // only this part of the display is updated (desktop coordinates)
     };
     void start(StartArgs &&args); ///< start a stopped thread
 
     void next(); ///< thread starts to capture the next frame
     void stop(); ///< signal thread to stop and waits
+    void updateVisibleArea(std::optional<win32::Rect>); ///< nullopt updates everything
+    /// record all delivered updates (nullptr stops recording)
+    /// note: the first recorded frame updates the entire display, so the recording can be replayed
+    void updateRecorder(std::shared_ptr<SessionRecorder>);
+
+    struct Stats {
+        std::chrono::nanoseconds elapsed{}; ///< since start
+        uint64_t wakeups{}; ///< returns from blocking waits
+        uint64_t frames{}; ///< frames passed to the callback
+        std::chrono::nanoseconds totalLatency{}; ///< sum of acquire to callback latencies
+        std::chrono::nanoseconds maxLatency{};
+        uint64_t dirtyRectsIn{}; ///< dirty rects reported by the source
+        uint64_t dirtyRectsOut{}; ///< dirty rects after coalescing
+        int64_t overdrawArea{}; ///< pixels updated additionally because of coalescing
+        int64_t culledArea{}; ///< pixels not updated because they are not visible
+        uint64_t scrolls{}; ///< dirty rects replaced with moves
+        int64_t scrolledArea{}; ///< dirty pixels replaced with moves
+        int64_t unchangedArea{}; ///< dirty pixels not updated because their tiles did not change
+        std::chrono::nanoseconds detectTime{}; ///< spent to read back and search scrolls & changes
+    };
+    auto stats() const -> Stats; ///< note: thread safe
 
 private:
+    /// queues functor as APC, the next acquire does not block while APCs are queued
+    template<class Functor>
+    void queueApc(Functor &&functor) {
+        m_queuedApcs.fetch_add(1, std::memory_order_release);
+        const auto isQueued = m_thread.queueUserApc([this, functor = std::forward<Functor>(functor)]() mutable {
+            m_queuedApcs.fetch_sub(1, std::memory_order_relaxed);
+            functor();
+        });
+        if (!isQueued) m_queuedApcs.fetch_sub(1, std::memory_order_relaxed);
+    }
+
     void capture_next();
     void capture_stop();
 
     void run();
-
-    void initCapture();
-    void handleDeviceError(const char *text, HRESULT, std::initializer_list<HRESULT> expected);
-
-    auto captureUpdate() -> std::optional<CapturedUpdate>;
+    auto acquire() -> std::optional<CapturedUpdate>;
+    void cullInvisible(FrameUpdate &);
+    void coalesceDirty(FrameUpdate &);
+    void detectContent(CapturedUpdate &);
+    void capture_visibleArea(std::optional<win32::Rect>);
+    void capture_recorder(std::shared_ptr<SessionRecorder>);
+    void recordEntireDisplay(FrameUpdate &);
+    void record(CapturedUpdate const &);
+    void captureDirect();
+    void capturePipelined();
+    void deliver(CapturedUpdate &&);
 
     static void noopSetErrorCallback(void *, const std::exception_ptr &) {}
     static void noopSetFrameCallback(void *, CapturedUpdate &&, const FrameContext &, size_t /*threadIndex*/) {}
 
 private:
     Config m_config;
-    int m_display{};
+    std::unique_ptr<CaptureSource> m_source{};
 
     FrameContext m_context{};
-    ComPtr<ID3D11Device> m_device{};
     Thread m_thread{};
+    std::atomic<uint32_t> m_queuedApcs{}; // APCs that did not run yet
     bool m_keepRunning = true;
 
-    bool m_doCapture = true;
+    bool m_doCapture = true; // consumer is ready for the next frame
+    bool m_hasAcquired = false; // source holds an acquired frame
+    std::optional<CapturedUpdate> m_staged{}; // pipelined frame that waits for the consumer
+    core::AdaptiveTimeout m_acquireTimeout{};
+    std::chrono::steady_clock::time_point m_acquiredAt{};
+    uint64_t m_sequence{}; // frames acquired since start
+    std::optional<win32::Rect> m_visibleArea{};
+    core::VisibleAreaCuller m_culler{};
+    core::RectCoalescer m_coalescer{};
+    core::ScrollDetector m_scrollDetector{};
+    core::TileChangeDetector m_changeDetector{};
+    std::vector<win32::Rect> m_dirtyRects{};
+    std::vector<DXGI_OUTDUPL_MOVE_RECT> m_moveRects{};
+    core::SurfaceView m_readback{}; // image read back for the content detection (valid inside of the dirty rects)
+    uint64_t m_readbackSequence{}; // frame of m_readback
+    std::shared_ptr<SessionRecorder> m_recorder{};
+    bool m_recordEntireDisplay{}; // next frame with an image updates the entire display
+
+    std::chrono::steady_clock::time_point m_startedAt{}; // only used by main thread
+    std::atomic<uint64_t> m_wakeups{};
+    std::atomic<uint64_t> m_frames{};
+    std::atomic<int64_t> m_totalLatency{}; // nanoseconds
+    std::atomic<int64_t> m_maxLatency{}; // nanoseconds
+    std::atomic<uint64_t> m_dirtyRectsIn{};
+    std::atomic<uint64_t> m_dirtyRectsOut{};
+    std::atomic<int64_t> m_overdrawArea{};
+    std::atomic<int64_t> m_culledArea{};
+    std::atomic<uint64_t> m_scrolls{};
+    std::atomic<int64_t> m_scrolledArea{};
+    std::atomic<int64_t> m_unchangedArea{};
+    std::atomic<int64_t> m_detectTime{}; // nanoseconds
 
-    ComPtr<IDXGIOutputDuplication> m_dupl;
     std::optional<std::jthread> m_stdThread;
 };
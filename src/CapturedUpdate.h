@@ -1,22 +1,32 @@
 #pragma once
+#include "core/BufferPool.h"
+#include "core/Surface.h"
 #include "meta/fromByteSpan.h"
-#include "meta/comptr.h"
+#include "win32/DxgiTypes.h"
 
-#include <d3d11.h>
-#include <dxgi1_3.h>
+#ifdef _WIN32
+#    include "meta/comptr.h"
 
+#    include <d3d11.h>
+#endif
+
+#include <cstring>
 #include <vector>
 
 using moved_view = std::span<const DXGI_OUTDUPL_MOVE_RECT>;
 using dirty_view = std::span<const RECT>;
 
 struct FrameUpdate {
+    uint64_t sequence{}; // number of the frame since the capture started
     int64_t present_time{};
     uint32_t frames{};
     bool rects_coalesced{};
     bool protected_content_masked_out{};
 
+#ifdef _WIN32
     ComPtr<ID3D11Texture2D> image{}; // texture with the entire display (in display device)
+#endif
+    core::SurfaceView cpuImage{}; // entire display in system memory (only set by software sources)
 
     std::vector<uint8_t> buffer{}; // managed buffer with move & dirty data
     uint32_t moved_bytes{};
@@ -31,6 +41,41 @@ struct FrameUpdate {
         auto dirty_span = std::span<const uint8_t>{buffer.data() + moved_bytes, dirty_bytes};
         return fromByteSpan<dirty_view>(dirty_span);
     }
+
+    bool hasImage() const noexcept {
+#ifdef _WIN32
+        if (image) return true;
+#endif
+        return static_cast<bool>(cpuImage);
+    }
+
+    /// replace all move and dirty rects
+    void replaceRects(moved_view moved, std::span<const win32::Rect> dirty) {
+        moved_bytes = static_cast<uint32_t>(moved.size_bytes());
+        dirty_bytes = static_cast<uint32_t>(dirty.size() * sizeof(RECT));
+        buffer.resize(moved_bytes + dirty_bytes);
+        if (!moved.empty()) std::memcpy(buffer.data(), moved.data(), moved_bytes);
+        replaceDirty(dirty);
+    }
+
+    /// replace the dirty rects
+    /// note: the number of rects must not grow
+    void replaceDirty(std::span<const win32::Rect> rects) {
+#pragma warning(suppress : 26481)
+        auto *dirtyPtr = std::bit_cast<RECT *>(buffer.data() + moved_bytes);
+        for (const auto &rect : rects) *dirtyPtr++ = rect.toRECT();
+        dirty_bytes = static_cast<uint32_t>(rects.size() * sizeof(RECT));
+    }
+
+    /// replace the metadata with copies of the given rects
+    void assignRects(moved_view moved, dirty_view dirty) {
+        moved_bytes = static_cast<uint32_t>(moved.size_bytes());
+        dirty_bytes = static_cast<uint32_t>(dirty.size_bytes());
+        buffer.resize(moved_bytes + dirty_bytes);
+        if (!moved.empty()) std::memcpy(buffer.data(), moved.data(), moved_bytes);
+#pragma warning(suppress : 26481)
+        if (!dirty.empty()) std::memcpy(buffer.data() + moved_bytes, dirty.data(), dirty_bytes);
+    }
 };
 
 struct PointerUpdate {
@@ -45,3 +90,14 @@ struct CapturedUpdate {
     FrameUpdate frame{};
     PointerUpdate pointer{};
 };
+
+/// recycles the managed buffers of CapturedUpdates from the render thread back to the capture thread
+struct CapturedUpdatePool {
+    core::BufferPool metadata{4, 16 * 1024}; // move & dirty rects
+    core::BufferPool shapes{4, 64 * 1024}; // pointer shapes
+
+    void recycle(CapturedUpdate &update) noexcept {
+        metadata.give(std::move(update.frame.buffer));
+        shapes.give(std::move(update.pointer.shape_buffer));
+    }
+};
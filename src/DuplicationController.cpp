@@ -1,12 +1,20 @@
 #include "DuplicationController.h"
 #include "CapturedUpdate.h"
+#include "DxgiCaptureSource.h"
 #include "FrameUpdater.h"
 #include "Model.h"
 #include "renderer.h"
 
+#include "core/FrameTrace.h"
+
+#include <format>
+#include <fstream>
+
 namespace deskdup {
 namespace {
 
+constexpr auto visibleAreaMargin = 64; // pixels around the visible area that are kept updated for zoom & pan
+
 auto createRetryTimer() -> WaitableTimer {
     auto config = WaitableTimer::Config{};
     config.timerName = TEXT("Local:RetryTimer");
@@ -35,6 +43,9 @@ DuplicationController::DuplicationController(const Args &args)
     , m_captureThread{captureThreadConfig()}
     , m_retryTimer{createRetryTimer()} {
     m_renderWindow.setCustomHandler<&DuplicationController::forwardRenderMessage>(this);
+    // note: the loop is not running yet, so we can safely modify it here
+    m_renderThread.threadLoop().addAwaitableMember<&DuplicationController::receiveFrames>(
+        m_frameChannel.handle(), this);
     m_renderThread.start();
 }
 
@@ -50,6 +61,7 @@ void DuplicationController::updateDuplicationStatus(DuplicationStatus status) {
 
 void DuplicationController::updateOutputDimension(Dimension dimension) {
     m_renderWindow.moveClient(Rect{.topLeft = {}, .dimension = dimension});
+    m_captureThread.updateVisibleArea(visibleArea());
     m_renderThread.thread().queueUserApc([this, dimension]() {
         m_renderThread.windowRenderer().resize(dimension);
         m_renderThread.updated();
@@ -60,6 +72,7 @@ void DuplicationController::updateOutputDimension(Dimension dimension) {
 }
 
 void DuplicationController::updateOutputZoom(float zoom) {
+    m_captureThread.updateVisibleArea(visibleArea());
     m_renderThread.thread().queueUserApc([this, zoom]() {
         m_renderThread.windowRenderer().zoomOutput(zoom);
         m_renderThread.updated();
@@ -67,12 +80,19 @@ void DuplicationController::updateOutputZoom(float zoom) {
 }
 
 void DuplicationController::updateCaptureOffset(Vec2f offset) {
+    m_captureThread.updateVisibleArea(visibleArea());
     m_renderThread.thread().queueUserApc([this, offset]() { m_renderThread.windowRenderer().updateOffset(offset); });
     if (m_controller.state().duplicationStatus != DuplicationStatus::Live) {
         restart();
     }
 }
 
+void DuplicationController::updateScreenRect(Rect rect) {
+    // note: offset, visible area and content detectors of the capture thread are relative to the display
+    if (rect == m_displayRect || m_status == Status::Stopped) return;
+    restart();
+}
+
 void DuplicationController::restart() {
     stopOnMain();
     if (m_controller.state().duplicationStatus == DuplicationStatus::Live) {
@@ -80,6 +100,49 @@ void DuplicationController::restart() {
     }
 }
 
+auto DuplicationController::presentLatency() -> core::PresentLatency {
+    return m_renderThread.windowRenderer().presentLatency();
+}
+
+bool DuplicationController::exportPresentLatency(std::filesystem::path const &path) {
+    const auto csv = m_renderThread.windowRenderer().presentLatencyCsv();
+    auto file = std::ofstream{path, std::ios::binary | std::ios::trunc};
+    file.write(csv.data(), static_cast<std::streamsize>(csv.size()));
+    return file.good();
+}
+
+void DuplicationController::resetPresentLatency() {
+    m_renderThread.thread().queueUserApc([this]() { m_renderThread.windowRenderer().resetPresentLatency(); });
+}
+
+bool DuplicationController::startSessionRecording(std::filesystem::path const &path) {
+    auto frequency = LARGE_INTEGER{};
+    QueryPerformanceFrequency(&frequency); // unit of the DXGI present times
+    auto recorder = std::make_shared<SessionRecorder>(SessionRecorder::Config{
+        .path = path,
+        .ticksPerSecond = frequency.QuadPart,
+    });
+    if (!recorder->isOpen()) return false;
+    m_sessionRecorder = std::move(recorder);
+    m_captureThread.updateRecorder(m_sessionRecorder);
+    return true;
+}
+
+void DuplicationController::stopSessionRecording() {
+    if (!m_sessionRecorder) return;
+    const auto stats = m_sessionRecorder->stats();
+    auto text = std::format(
+        "session recorder: {} updates, {} dropped, {} keyframes, {} bytes{}\n",
+        stats.recorded,
+        stats.dropped,
+        stats.keyframes,
+        stats.bytes,
+        stats.failed ? ", writing failed" : "");
+    OutputDebugStringA(text.c_str());
+    m_captureThread.updateRecorder(nullptr);
+    m_sessionRecorder.reset();
+}
+
 auto DuplicationController::renderThreadConfig(OperationModeLens lens) -> RenderThread::Config {
     auto config = RenderThread::Config{
         .pointerBuffer = m_pointerUpdater.data(),
@@ -93,6 +156,8 @@ auto DuplicationController::renderThreadConfig(OperationModeLens lens) -> Render
 auto DuplicationController::captureThreadConfig() -> CaptureThread::Config {
     auto config = CaptureThread::Config{};
     config.threadIndex = 0;
+    config.pipelined = true;
+    config.coalesceDirty = core::RectCoalescer::CostModel{};
     config.setCallbacks(this);
     return config;
 }
@@ -126,8 +191,8 @@ void DuplicationController::startOnMain() {
             auto deviceContext = deviceValue.deviceContext;
 
             auto dimensionData = renderer::getDimensionData(device, {m_controller.operatonModeLens().captureMonitor()});
-            m_controller.updateScreenRect(dimensionData.rect);
             m_displayRect = dimensionData.rect;
+            m_controller.updateScreenRect(dimensionData.rect);
 
             m_targetTexture = renderer::createSharedTexture(device, dimensionData.rect.dimension);
             m_windowClass.recreateWindow(
@@ -185,6 +250,7 @@ void DuplicationController::stopOnMain() {
 void DuplicationController::resetOnMain() {
     try {
         m_captureThread.stop();
+        reportStats();
         // m_renderThread.stop();
         m_frameUpdater.reset();
         m_targetTexture.Reset();
@@ -197,6 +263,55 @@ void DuplicationController::resetOnMain() {
     }
 }
 
+void DuplicationController::reportStats() {
+    const auto reportPool = [](const char *name, core::BufferPool::Stats stats) {
+        auto text = std::format("{} pool: {} hits, {} misses\n", name, stats.hits, stats.misses);
+        OutputDebugStringA(text.c_str());
+    };
+    reportPool("metadata", m_updatePool.metadata.stats());
+    reportPool("pointer shape", m_updatePool.shapes.stats());
+    const auto rendered = m_renderThread.windowRenderer().renderStats();
+    auto renderText = std::format(
+        "render: {} full frames, {} partial frames ({} pointer only)\n",
+        rendered.fullFrames,
+        rendered.partialFrames,
+        rendered.pointerFrames);
+    OutputDebugStringA(renderText.c_str());
+    const auto shapes = m_renderThread.windowRenderer().pointerShapeStats();
+    auto shapeText = std::format("pointer shape cache: {} hits, {} misses\n", shapes.hits, shapes.misses);
+    OutputDebugStringA(shapeText.c_str());
+
+    using Seconds = std::chrono::duration<double>;
+    using Microseconds = std::chrono::duration<double, std::micro>;
+    const auto capture = m_captureThread.stats();
+    const auto seconds = std::chrono::duration_cast<Seconds>(capture.elapsed).count();
+    if (seconds <= 0 || capture.frames == 0) return;
+    auto text = std::format(
+        "capture: {:.1f} wakeups/s, {} frames, acquire to callback {:.1f}us avg {:.1f}us max\n",
+        static_cast<double>(capture.wakeups) / seconds,
+        capture.frames,
+        std::chrono::duration_cast<Microseconds>(capture.totalLatency).count() / static_cast<double>(capture.frames),
+        std::chrono::duration_cast<Microseconds>(capture.maxLatency).count());
+    OutputDebugStringA(text.c_str());
+
+    text = std::format(
+        "coalescing: {} dirty rects => {}, {} pixels overdrawn, {} pixels culled\n",
+        capture.dirtyRectsIn,
+        capture.dirtyRectsOut,
+        capture.overdrawArea,
+        capture.culledArea);
+    OutputDebugStringA(text.c_str());
+
+    if (capture.detectTime.count() == 0) return; // scroll & change detection are disabled
+    text = std::format(
+        "content detection: {} scrolls, {} pixels scrolled, {} bytes/frame unchanged, {:.1f}us/frame\n",
+        capture.scrolls,
+        capture.scrolledArea,
+        capture.unchangedArea * core::bytesPerPixel / static_cast<int64_t>(capture.frames),
+        std::chrono::duration_cast<Microseconds>(capture.detectTime).count() / static_cast<double>(capture.frames));
+    OutputDebugStringA(text.c_str());
+}
+
 void DuplicationController::updateStatusOnMain(Status status) {
     if (m_status.load() == status) return;
     m_status.store(status);
@@ -227,12 +342,30 @@ void DuplicationController::startCaptureThread(HANDLE targetHandle) {
     m_frameUpdater = FrameUpdater{std::move(updater_args)};
 
     auto threadArgs = CaptureThread::StartArgs{};
-    threadArgs.display = m_controller.operatonModeLens().captureMonitor();
-    threadArgs.device = device;
+    threadArgs.source = std::make_unique<DxgiCaptureSource>(DxgiCaptureSource::Args{
+        .display = m_controller.operatonModeLens().captureMonitor(),
+        .device = device,
+        .pool = m_updatePool,
+    });
     threadArgs.offset = m_displayRect.topLeft;
+    threadArgs.visibleArea = visibleArea();
     m_captureThread.start(std::move(threadArgs));
 }
 
+auto DuplicationController::visibleArea() const -> Rect {
+    const auto area = m_controller.operatonModeLens().captureAreaRect();
+    return Rect{
+        Point{
+            area.left() - m_displayRect.left() - visibleAreaMargin,
+            area.top() - m_displayRect.top() - visibleAreaMargin,
+        },
+        Dimension{
+            area.width() + 2 * visibleAreaMargin,
+            area.height() + 2 * visibleAreaMargin,
+        },
+    };
+}
+
 void DuplicationController::awaitRetry() {
     using namespace std::chrono_literals;
     auto timerArgs = WaitableTimer::SetArgs{};
@@ -263,18 +396,35 @@ void DuplicationController::setError(const std::exception_ptr &error) {
 }
 
 void DuplicationController::setFrame(CapturedUpdate &&update, const FrameContext &context, size_t threadIndex) {
-    m_renderThread.thread().queueUserApc([this, update = std::move(update), &context, threadIndex]() mutable {
-        setFrameOnRender(std::move(update), context, threadIndex);
+    auto item = FrameChannel::Item{std::move(update), &context, threadIndex};
+    if (m_frameChannel.push(std::move(item))) return;
+    // channel is full - should not happen as only one frame is in flight
+    m_renderThread.thread().queueUserApc([this, item = std::move(item)]() mutable {
+        setFrameOnRender(std::move(item.update), *item.context, item.threadIndex);
     });
 }
 
+auto DuplicationController::receiveFrames(HANDLE) -> ThreadLoop::Keep {
+    auto item = FrameChannel::Item{};
+    while (m_frameChannel.pop(item)) {
+        setFrameOnRender(std::move(item.update), *item.context, item.threadIndex);
+    }
+    return ThreadLoop::Keep::Yes;
+}
+
 void DuplicationController::setFrameOnRender(
     CapturedUpdate &&update, const FrameContext &context, size_t /*threadIndex*/) {
 
     // m_frameUpdaters[threadIndex].update(update.frame, context);
-    m_frameUpdater->update(update.frame, context);
-    m_pointerUpdater.update(update.pointer, context);
-    m_renderThread.renderFrame();
+    FRAME_TRACE_FRAME(update.frame.sequence);
+    const auto hasFrameChanges = !update.frame.moved().empty() || !update.frame.dirty().empty();
+    if (hasFrameChanges) {
+        m_frameUpdater->update(update.frame, context);
+        m_renderThread.windowRenderer().addFrameDamage(update.frame, context);
+    }
+    const auto hasPointerChanges = m_pointerUpdater.update(update.pointer, context);
+    if (hasFrameChanges || hasPointerChanges) m_renderThread.renderFrame();
+    m_updatePool.recycle(update);
 
     auto status = m_status.load();
     if (status == Status::Live) {
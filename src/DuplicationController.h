@@ -1,16 +1,21 @@
 #pragma once
 #include "CaptureThread.h"
+#include "CapturedUpdate.h"
+#include "FrameChannel.h"
 #include "FrameUpdater.h"
 #include "MainController.h"
 #include "Model.h"
 #include "PointerUpdater.h"
 #include "RenderThread.h"
+#include "SessionRecorder.h"
 
 #include "win32/Thread.h"
 #include "win32/ThreadLoop.h"
 #include "win32/WaitableTimer.h"
 #include "win32/Window.h"
 
+#include <filesystem>
+#include <memory>
 #include <optional>
 
 namespace deskdup {
@@ -42,8 +47,20 @@ struct DuplicationController {
     void updateOutputDimension(Dimension);
     void updateOutputZoom(float zoom);
     void updateCaptureOffset(Vec2f);
+    void updateScreenRect(Rect); ///< restarts the capture if the captured display moved or resized
     void restart();
 
+    auto presentLatency() -> core::PresentLatency;
+    /// writes all latency histograms to a csv file - returns false on errors
+    bool exportPresentLatency(std::filesystem::path const &);
+    void resetPresentLatency();
+
+    bool isRecordingSession() const { return m_sessionRecorder != nullptr; }
+    /// record all captured updates into a session trace file - returns false if the file cannot be written
+    bool startSessionRecording(std::filesystem::path const &);
+    /// note: the file is completed on the CaptureThread
+    void stopSessionRecording();
+
 private:
     enum class Status {
         Stopped, // from Stopping
@@ -65,8 +82,10 @@ private:
     void pauseOnMain();
     void stopOnMain();
     void resetOnMain();
+    void reportStats();
     void updateStatusOnMain(Status);
 
+    auto visibleArea() const -> Rect;
     void initCaptureThread();
     void updateCaptureStatus();
     void startCaptureThread(HANDLE targetHandle);
@@ -80,9 +99,10 @@ private:
     friend struct ::WindowRenderer;
     friend struct ::CaptureThread;
     void setError(const std::exception_ptr &); // called on CaptureThread or RenderThread
-    void setFrame(CapturedUpdate &&, const FrameContext &, size_t threadIndex); // called on RenderThread
+    void setFrame(CapturedUpdate &&, const FrameContext &, size_t threadIndex); // called on CaptureThread
 
 private:
+    auto receiveFrames(HANDLE) -> ThreadLoop::Keep; // called on RenderThread
     void setFrameOnRender(CapturedUpdate &&, const FrameContext &, size_t threadIndex);
 
 private:
@@ -95,8 +115,11 @@ private:
     WindowWithMessages &m_outputWindow;
     WindowWithMessages m_renderWindow;
 
+    CapturedUpdatePool m_updatePool; // used by both threads
+    FrameChannel m_frameChannel; // CaptureThread => RenderThread
     RenderThread m_renderThread;
     CaptureThread m_captureThread;
+    std::shared_ptr<SessionRecorder> m_sessionRecorder; // shared with the CaptureThread while recording
 
     ComPtr<ID3D11Texture2D> m_targetTexture;
     std::optional<FrameUpdater> m_frameUpdater;
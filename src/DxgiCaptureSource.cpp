@@ -0,0 +1,232 @@
+#include "DxgiCaptureSource.h"
+
+#include "CapturedUpdate.h"
+
+#include "core/FrameTrace.h"
+#include "core/Rotation.h"
+#include "meta/scope_guard.h"
+
+namespace {
+
+void setDesktop() {
+    const auto flags = 0;
+    const auto inherit = false;
+    const auto access = GENERIC_ALL;
+    auto desktop = OpenInputDesktop(flags, inherit, access);
+    if (!desktop) throw Expected{"Failed to open desktop"};
+    LATER(CloseDesktop(desktop));
+
+    const auto result = SetThreadDesktop(desktop);
+    if (!result) throw Expected{"Failed to set desktop"};
+}
+
+} // namespace
+
+auto DxgiCaptureSource::init() -> DXGI_OUTPUT_DESC {
+    setDesktop();
+
+    auto dxgiDevice = ComPtr<IDXGIDevice>{};
+    auto dxResult = m_device.As(&dxgiDevice);
+    if (IS_ERROR(dxResult)) throw Unexpected{"Failed to get IDXGIDevice from device"};
+
+    auto dxgiAdapter = ComPtr<IDXGIAdapter>{};
+    dxResult = dxgiDevice->GetParent(__uuidof(IDXGIAdapter), &dxgiAdapter);
+    const auto parentExpected = {DXGI_ERROR_ACCESS_LOST, HRESULT{WAIT_ABANDONED}};
+    if (IS_ERROR(dxResult)) handleDeviceError("Failed to get IDXGIAdapter from device", dxResult, parentExpected);
+
+    auto dxgiOutput = ComPtr<IDXGIOutput>{};
+    dxResult = dxgiAdapter->EnumOutputs(m_display, &dxgiOutput);
+    if (IS_ERROR(dxResult)) handleDeviceError("Failed to get ouput from adapter", dxResult, {DXGI_ERROR_NOT_FOUND});
+
+    auto outputDesc = DXGI_OUTPUT_DESC{};
+    dxResult = dxgiOutput->GetDesc(&outputDesc);
+    if (IS_ERROR(dxResult)) handleDeviceError("Failed to get ouput description", dxResult, {});
+
+    auto dxgiOutput1 = ComPtr<IDXGIOutput1>{};
+    dxResult = dxgiOutput.As(&dxgiOutput1);
+    if (IS_ERROR(dxResult)) throw Unexpected{"Failed to get IDXGIOutput1 from dxgi_output"};
+
+    dxResult = dxgiOutput1->DuplicateOutput(m_device.Get(), &m_dupl);
+    if (IS_ERROR(dxResult)) {
+        if (DXGI_ERROR_NOT_CURRENTLY_AVAILABLE == dxResult)
+            throw Unexpected{"Maximum of desktop duplications reached!"};
+        const auto duplicateExpected = {
+            HRESULT{E_ACCESSDENIED},
+            DXGI_ERROR_UNSUPPORTED,
+            DXGI_ERROR_SESSION_DISCONNECTED,
+        };
+        handleDeviceError("Failed to get duplicate output from device", dxResult, duplicateExpected);
+    }
+    m_outputDesc = outputDesc;
+
+    // stage() copies on the device context that the RenderThread uses as well
+    m_device->GetImmediateContext(&m_deviceContext);
+    auto multithread = ComPtr<ID3D11Multithread>{};
+    dxResult = m_deviceContext.As(&multithread);
+    if (IS_ERROR(dxResult)) throw Unexpected{"Failed to get ID3D11Multithread from device context"};
+    multithread->SetMultithreadProtected(TRUE);
+    return outputDesc;
+}
+
+auto DxgiCaptureSource::acquire(Milliseconds timeout) -> std::optional<CapturedUpdate> {
+    auto result = std::optional<CapturedUpdate>{};
+    const auto time = static_cast<UINT>(timeout.count());
+    auto resource = ComPtr<IDXGIResource>{};
+    auto frameInfo = DXGI_OUTDUPL_FRAME_INFO{};
+    FRAME_TRACE_BEGIN(acquireStart);
+    auto dxResult = m_dupl->AcquireNextFrame(time, &frameInfo, &resource);
+    if (DXGI_ERROR_WAIT_TIMEOUT == dxResult) return {};
+    if (IS_ERROR(dxResult)) throw Expected{"Failed to acquire next frame in capture_thread"};
+    FRAME_TRACE_END(acquireStart, Acquire);
+    FRAME_TRACE_SCOPE(Metadata);
+
+    result.emplace();
+    auto &update = result.value();
+    update.frame.frames = frameInfo.AccumulatedFrames;
+    update.frame.present_time = frameInfo.LastPresentTime.QuadPart;
+    update.frame.rects_coalesced = frameInfo.RectsCoalesced;
+    update.frame.protected_content_masked_out = frameInfo.ProtectedContentMaskedOut;
+
+    if (0 != frameInfo.TotalMetadataBufferSize) {
+        update.frame.buffer = m_pool.metadata.take(frameInfo.TotalMetadataBufferSize);
+
+        auto movedPtr = update.frame.buffer.data();
+        dxResult = m_dupl->GetFrameMoveRects(
+            frameInfo.TotalMetadataBufferSize,
+            std::bit_cast<DXGI_OUTDUPL_MOVE_RECT *>(movedPtr),
+            &update.frame.moved_bytes);
+        if (IS_ERROR(dxResult)) throw Expected{"Failed to get frame moved rects in capture_thread"};
+
+        auto dirtyPtr = movedPtr + update.frame.moved_bytes;
+        const auto dirtySize = frameInfo.TotalMetadataBufferSize - update.frame.moved_bytes;
+        dxResult = m_dupl->GetFrameDirtyRects(dirtySize, std::bit_cast<RECT *>(dirtyPtr), &update.frame.dirty_bytes);
+        if (IS_ERROR(dxResult)) throw Expected{"Failed to get frame dirty rects in capture_thread"};
+    }
+    if (resource) {
+        // note: also kept for frames without dirty rects - the VisibleAreaCuller might add some
+        dxResult = resource.As(&update.frame.image);
+        if (IS_ERROR(dxResult)) throw Unexpected{"Failed to get ID3D11Texture from resource in capture_thread"};
+    }
+
+    update.pointer.update_time = frameInfo.LastMouseUpdateTime.QuadPart;
+    update.pointer.position = frameInfo.PointerPosition;
+    if (0 != frameInfo.PointerShapeBufferSize) {
+        update.pointer.shape_buffer = m_pool.shapes.take(frameInfo.PointerShapeBufferSize);
+
+        auto pointerPtr = update.pointer.shape_buffer.data();
+        const auto pointerSize = static_cast<uint32_t>(update.pointer.shape_buffer.size());
+        auto sizeRequiredDummy = UINT{};
+        dxResult =
+            m_dupl->GetFramePointerShape(pointerSize, pointerPtr, &sizeRequiredDummy, &update.pointer.shape_info);
+        if (IS_ERROR(dxResult)) throw Expected{"Failed to get frame pointer shape in capture_thread"};
+        // assert(size_required_dummy == frame.pointer_data.size());
+    }
+    return update;
+}
+
+void DxgiCaptureSource::release() { m_dupl->ReleaseFrame(); }
+
+DxgiCaptureSource::~DxgiCaptureSource() {
+    for (auto i = size_t{}; i < m_readbackTextures.size(); ++i) {
+        if (m_isReadbackMapped[i]) m_deviceContext->Unmap(m_readbackTextures[i].Get(), 0);
+    }
+}
+
+bool DxgiCaptureSource::stage(CapturedUpdate &update) {
+    auto &image = update.frame.image;
+    if (!image) return true;
+    if (!m_stagingTextures[0]) createStagingTextures(image.Get());
+
+    auto &staging = m_stagingTextures[m_nextStaging];
+    m_nextStaging = (m_nextStaging + 1) % m_stagingTextures.size();
+
+    copyDirty(staging.Get(), image.Get(), update.frame);
+    image = staging;
+    return true;
+}
+
+auto DxgiCaptureSource::readback(CapturedUpdate const &update) -> core::SurfaceView {
+    const auto &image = update.frame.image;
+    if (!image) return {};
+    if (!m_readbackTextures[0]) createReadbackTextures(image.Get());
+
+    const auto index = m_nextReadback;
+    m_nextReadback = (m_nextReadback + 1) % m_readbackTextures.size();
+    auto &readback = m_readbackTextures[index];
+    if (m_isReadbackMapped[index]) {
+        m_deviceContext->Unmap(readback.Get(), 0);
+        m_isReadbackMapped[index] = false;
+    }
+
+    copyDirty(readback.Get(), image.Get(), update.frame);
+    // note: blocks the capture thread until the copy is done
+    auto mapped = D3D11_MAPPED_SUBRESOURCE{};
+    const auto dxResult = m_deviceContext->Map(readback.Get(), 0, D3D11_MAP_READ, 0, &mapped);
+    if (IS_ERROR(dxResult)) handleDeviceError("Failed to map readback texture", dxResult, {DXGI_ERROR_DEVICE_REMOVED});
+    m_isReadbackMapped[index] = true;
+
+    auto description = D3D11_TEXTURE2D_DESC{};
+    readback->GetDesc(&description);
+    return core::SurfaceView{
+        .data = static_cast<const uint8_t *>(mapped.pData),
+        .dimension = {static_cast<int>(description.Width), static_cast<int>(description.Height)},
+        .pitch = static_cast<int>(mapped.RowPitch),
+    };
+}
+
+void DxgiCaptureSource::copyDirty(ID3D11Texture2D *target, ID3D11Texture2D *image, FrameUpdate const &frame) {
+    const auto desktopDim = win32::Rect::fromRECT(m_outputDesc.DesktopCoordinates).dimension;
+    for (const auto &dirty : frame.dirty()) {
+        const auto rect = core::rotate(win32::Rect::fromRECT(dirty), m_outputDesc.Rotation, desktopDim);
+        const auto box = D3D11_BOX{
+            .left = static_cast<UINT>(rect.left()),
+            .top = static_cast<UINT>(rect.top()),
+            .front = 0,
+            .right = static_cast<UINT>(rect.right()),
+            .bottom = static_cast<UINT>(rect.bottom()),
+            .back = 1,
+        };
+        m_deviceContext->CopySubresourceRegion(target, 0, box.left, box.top, 0, image, 0, &box);
+    }
+}
+
+void DxgiCaptureSource::createStagingTextures(ID3D11Texture2D *image) {
+    auto description = D3D11_TEXTURE2D_DESC{};
+    image->GetDesc(&description);
+    description.MipLevels = 1;
+    description.ArraySize = 1;
+    description.Usage = D3D11_USAGE_DEFAULT;
+    description.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    description.CPUAccessFlags = 0;
+    description.MiscFlags = 0;
+    for (auto &texture : m_stagingTextures) {
+        const auto dxResult = m_device->CreateTexture2D(&description, nullptr, &texture);
+        if (IS_ERROR(dxResult)) handleDeviceError("Failed to create staging texture", dxResult, {E_OUTOFMEMORY});
+    }
+}
+
+void DxgiCaptureSource::createReadbackTextures(ID3D11Texture2D *image) {
+    auto description = D3D11_TEXTURE2D_DESC{};
+    image->GetDesc(&description);
+    description.MipLevels = 1;
+    description.ArraySize = 1;
+    description.Usage = D3D11_USAGE_STAGING;
+    description.BindFlags = 0;
+    description.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    description.MiscFlags = 0;
+    for (auto &texture : m_readbackTextures) {
+        const auto dxResult = m_device->CreateTexture2D(&description, nullptr, &texture);
+        if (IS_ERROR(dxResult)) handleDeviceError("Failed to create readback texture", dxResult, {E_OUTOFMEMORY});
+    }
+}
+
+void DxgiCaptureSource::handleDeviceError(const char *text, HRESULT result, std::initializer_list<HRESULT> expected) {
+    if (m_device) {
+        const auto reason = m_device->GetDeviceRemovedReason();
+        if (S_OK != reason) throw Expected{text};
+    }
+    for (const auto cand : expected) {
+        if (result == cand) throw Expected{text};
+    }
+    throw Unexpected{text};
+}
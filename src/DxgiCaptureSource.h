@@ -0,0 +1,55 @@
+#pragma once
+#include "CaptureSource.h"
+
+#include "meta/comptr.h"
+
+#include <d3d11.h>
+#include <dxgi1_3.h>
+
+#include <array>
+#include <initializer_list>
+
+struct CapturedUpdatePool;
+
+/// Captures a display with the DXGI Desktop Duplication API
+struct DxgiCaptureSource final : CaptureSource {
+    struct Args {
+        int display{}; // index of the display to capture
+        ComPtr<ID3D11Device> device; // device used for capturing
+        CapturedUpdatePool &pool; // provides the managed buffers
+    };
+    explicit DxgiCaptureSource(Args &&args) noexcept
+        : m_display{args.display}
+        , m_device{std::move(args.device)}
+        , m_pool{args.pool} {}
+    ~DxgiCaptureSource() override;
+
+    auto init() -> DXGI_OUTPUT_DESC override;
+    auto acquire(Milliseconds timeout) -> std::optional<CapturedUpdate> override;
+    void release() override;
+    bool stage(CapturedUpdate &) override;
+    auto readback(CapturedUpdate const &) -> core::SurfaceView override;
+
+private:
+    void handleDeviceError(const char *text, HRESULT, std::initializer_list<HRESULT> expected);
+    void createStagingTextures(ID3D11Texture2D *image);
+    void createReadbackTextures(ID3D11Texture2D *image);
+    void copyDirty(ID3D11Texture2D *target, ID3D11Texture2D *image, FrameUpdate const &);
+
+private:
+    int m_display{};
+    ComPtr<ID3D11Device> m_device{};
+    CapturedUpdatePool &m_pool;
+    ComPtr<IDXGIOutputDuplication> m_dupl;
+    DXGI_OUTPUT_DESC m_outputDesc{};
+
+    // note: the device context is shared with the FrameUpdater on the RenderThread
+    ComPtr<ID3D11DeviceContext> m_deviceContext{};
+    std::array<ComPtr<ID3D11Texture2D>, 2> m_stagingTextures{}; // used alternating
+    size_t m_nextStaging{};
+
+    // CPU readable copies of the frames while a session is recorded
+    std::array<ComPtr<ID3D11Texture2D>, 2> m_readbackTextures{}; // used alternating
+    std::array<bool, 2> m_isReadbackMapped{};
+    size_t m_nextReadback{};
+};
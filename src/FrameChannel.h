@@ -0,0 +1,37 @@
+#pragma once
+#include "CapturedUpdate.h"
+#include "FrameContext.h"
+
+#include "core/SpscRing.h"
+#include "win32/Event.h"
+
+#include <stddef.h>
+
+/// hands captured frames from the CaptureThread to the RenderThread
+/// note:
+/// * pushing and popping is wait free and does not allocate
+/// * the event handle is signaled after a push, so it can be awaited in a ThreadLoop
+struct FrameChannel {
+    struct Item {
+        CapturedUpdate update{};
+        const FrameContext *context{};
+        size_t threadIndex{};
+    };
+
+    /// called on CaptureThread - returns false if the channel is full
+    bool push(Item &&item) noexcept {
+        if (!m_ring.tryPush(std::move(item))) return false;
+        m_event.set();
+        return true;
+    }
+
+    /// called on RenderThread
+    bool pop(Item &item) noexcept { return m_ring.tryPop(item); }
+
+    auto handle() const -> HANDLE { return m_event.handle(); }
+
+private:
+    static constexpr auto capacity = size_t{4}; // one frame is in flight - the rest is headroom
+    core::SpscRing<Item, capacity> m_ring{};
+    win32::Event m_event{}; // auto reset
+};
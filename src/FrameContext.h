@@ -1,8 +1,7 @@
 #pragma once
+#include "win32/DxgiTypes.h"
 #include "win32/Geometry.h"
 
-#include <dxgi1_3.h>
-
 using win32::Point;
 
 struct FrameContext {
@@ -4,35 +4,26 @@
 
 #include "CapturedUpdate.h"
 #include "FrameContext.h"
+#include "QuadVertexShader.h"
+
+#include "core/FrameTrace.h"
+#include "core/Rotation.h"
+
+#include <algorithm>
 
 namespace {
 
+using core::rotate;
 using win32::Dimension;
 using win32::Point;
 using win32::Rect;
 
-auto rotate(Rect rect, DXGI_MODE_ROTATION rotation, Dimension spaceDim) noexcept -> Rect {
-    switch (rotation) {
-    case DXGI_MODE_ROTATION_UNSPECIFIED:
-    case DXGI_MODE_ROTATION_IDENTITY: return rect;
-    case DXGI_MODE_ROTATION_ROTATE90:
-        return {
-            Point{spaceDim.height - rect.bottom(), rect.left()},
-            Dimension{rect.height(), rect.width()},
-        };
-    case DXGI_MODE_ROTATION_ROTATE180:
-        return {
-            Point{spaceDim.width - rect.right(), spaceDim.height - rect.bottom()},
-            rect.dimension,
-        };
-    case DXGI_MODE_ROTATION_ROTATE270:
-        return {
-            Point{rect.top(), spaceDim.width - rect.right()},
-            Dimension{rect.height(), rect.width()},
-        };
-    default: return {};
-    }
-}
+/// constant buffer of the QuadVertexShader
+struct QuadTransformConstants {
+    core::VertexTransform transform{};
+    std::array<float, 2> padding{}; // constant buffers are multiples of 16 bytes
+};
+static_assert(sizeof(QuadTransformConstants) % 16 == 0);
 
 } // namespace
 
@@ -40,6 +31,7 @@ FrameUpdater::FrameUpdater(InitArgs &&args)
     : m_dx(std::move(args)) {}
 
 void FrameUpdater::update(const FrameUpdate &data, const FrameContext &context) {
+    FRAME_TRACE_SCOPE(Update);
     performMoves(data, context);
     updateDirty(data, context);
 }
@@ -50,58 +42,94 @@ void FrameUpdater::performMoves(const FrameUpdate &data, const FrameContext &con
 
     const auto desktopRect = Rect::fromRECT(context.output_desc.DesktopCoordinates);
     const auto &desktopDim = desktopRect.dimension;
-
-    if (!m_dx.moveTmp) {
-        auto target_description = D3D11_TEXTURE2D_DESC{};
-        m_dx.target->GetDesc(&target_description);
-
-        auto move_description = D3D11_TEXTURE2D_DESC{
-            .Width = static_cast<UINT>(desktopDim.width),
-            .Height = static_cast<UINT>(desktopDim.height),
-            .MipLevels = 1,
-            .ArraySize = target_description.ArraySize,
-            .Format = target_description.Format,
-            .SampleDesc = target_description.SampleDesc,
-            .Usage = target_description.Usage,
-            .BindFlags = D3D11_BIND_RENDER_TARGET,
-            .CPUAccessFlags = target_description.CPUAccessFlags,
-            .MiscFlags = 0,
-        };
-        const auto result = m_dx.device()->CreateTexture2D(&move_description, nullptr, &m_dx.moveTmp);
-        if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create move temporary texture");
-    }
-
-    const auto target_x = context.output_desc.DesktopCoordinates.left - context.offset.x;
-    const auto target_y = context.output_desc.DesktopCoordinates.top - context.offset.y;
+    const auto target = Point{
+        context.output_desc.DesktopCoordinates.left - context.offset.x,
+        context.output_desc.DesktopCoordinates.top - context.offset.y,
+    };
     const auto rotation = context.output_desc.Rotation;
 
+    m_moves.clear();
     for (auto &move : moved) {
         auto moveDestinationRect = Rect::fromRECT(move.DestinationRect);
         auto moveSourcePoint = Point::fromPOINT(move.SourcePoint);
 
         const auto sourceRect = rotate(Rect{moveSourcePoint, moveDestinationRect.dimension}, rotation, desktopDim);
         const auto dest = rotate(moveDestinationRect, rotation, desktopDim);
-
-        auto box = D3D11_BOX{
-            .left = static_cast<UINT>(sourceRect.left() + target_x),
-            .top = static_cast<UINT>(sourceRect.top() + target_y),
+        m_moves.push_back({
+            Rect{Point{sourceRect.left() + target.x, sourceRect.top() + target.y}, sourceRect.dimension},
+            Point{dest.left() + target.x, dest.top() + target.y},
+        });
+    }
+    const auto boxOf = [](Rect rect) {
+        return D3D11_BOX{
+            .left = static_cast<UINT>(rect.left()),
+            .top = static_cast<UINT>(rect.top()),
             .front = 0,
-            .right = static_cast<UINT>(sourceRect.right() + target_x),
-            .bottom = static_cast<UINT>(sourceRect.bottom() + target_y),
+            .right = static_cast<UINT>(rect.right()),
+            .bottom = static_cast<UINT>(rect.bottom()),
             .back = 1,
         };
+    };
+    const auto copyViaTemp = [&](Rect const &source, Point dest) {
+        const auto sourceBox = boxOf(source);
+        m_dx.deviceContext()->CopySubresourceRegion(m_dx.moveTmp.Get(), 0, 0, 0, 0, m_dx.target.Get(), 0, &sourceBox);
 
+        const auto tmpBox = boxOf(Rect{{}, source.dimension});
         m_dx.deviceContext()->CopySubresourceRegion(
-            m_dx.moveTmp.Get(), 0, sourceRect.left(), sourceRect.top(), 0, m_dx.target.Get(), 0, &box);
+            m_dx.target.Get(), 0, dest.x, dest.y, 0, m_dx.moveTmp.Get(), 0, &tmpBox);
+    };
+    if (!m_dx.overlapContext) {
+        // note: D3D11 drops copies with the same source and destination subresource
+        auto tempDimension = Dimension{};
+        for (const auto &move : m_moves) {
+            tempDimension.width = std::max(tempDimension.width, move.source.width());
+            tempDimension.height = std::max(tempDimension.height, move.source.height());
+        }
+        ensureMoveTmp(tempDimension);
+        for (const auto &move : m_moves) copyViaTemp(move.source, move.destination);
+        return;
+    }
+    const auto &plan = m_movePlanner.plan(m_moves);
+    ensureMoveTmp(plan.tempDimension);
+    for (const auto &copy : plan.copies) {
+        if (copy.viaTemp) {
+            copyViaTemp(copy.source, copy.destination);
+            continue;
+        }
+        // planner guarantees that source and destination do not overlap
+        const auto box = boxOf(copy.source);
+        const auto &dest = copy.destination;
+        m_dx.overlapContext->CopySubresourceRegion1(
+            m_dx.target.Get(), 0, dest.x, dest.y, 0, m_dx.target.Get(), 0, &box, 0);
+    }
+}
 
-        box.left = sourceRect.left();
-        box.top = sourceRect.top();
-        box.right = sourceRect.right();
-        box.bottom = sourceRect.bottom();
+/// temporary texture is used for overlapping moves (all moves without CopyWithOverlap) and grows to the largest one
+void FrameUpdater::ensureMoveTmp(Dimension dimension) {
+    if (dimension.width <= 0 || dimension.height <= 0) return;
+    const auto &current = m_dx.moveTmpDimension;
+    if (m_dx.moveTmp && current.width >= dimension.width && current.height >= dimension.height) return;
 
-        m_dx.deviceContext()->CopySubresourceRegion(
-            m_dx.target.Get(), 0, dest.left() + target_x, dest.top() + target_y, 0, m_dx.moveTmp.Get(), 0, &box);
-    }
+    auto target_description = D3D11_TEXTURE2D_DESC{};
+    m_dx.target->GetDesc(&target_description);
+
+    const auto size = Dimension{std::max(current.width, dimension.width), std::max(current.height, dimension.height)};
+    auto move_description = D3D11_TEXTURE2D_DESC{
+        .Width = static_cast<UINT>(size.width),
+        .Height = static_cast<UINT>(size.height),
+        .MipLevels = 1,
+        .ArraySize = target_description.ArraySize,
+        .Format = target_description.Format,
+        .SampleDesc = target_description.SampleDesc,
+        .Usage = target_description.Usage,
+        .BindFlags = D3D11_BIND_RENDER_TARGET,
+        .CPUAccessFlags = target_description.CPUAccessFlags,
+        .MiscFlags = 0,
+    };
+    m_dx.moveTmp.Reset();
+    const auto result = m_dx.device()->CreateTexture2D(&move_description, nullptr, &m_dx.moveTmp);
+    if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create move temporary texture");
+    m_dx.moveTmpDimension = size;
 }
 
 void FrameUpdater::updateDirty(const FrameUpdate &data, const FrameContext &context) {
@@ -119,63 +147,35 @@ void FrameUpdater::updateDirty(const FrameUpdate &data, const FrameContext &cont
     auto desktop_description = D3D11_TEXTURE2D_DESC{};
     desktop->GetDesc(&desktop_description);
 
-    const auto target_x = context.output_desc.DesktopCoordinates.left - context.offset.x;
-    const auto target_y = context.output_desc.DesktopCoordinates.top - context.offset.y;
+    const auto targetOffset = Point{
+        context.output_desc.DesktopCoordinates.left - context.offset.x,
+        context.output_desc.DesktopCoordinates.top - context.offset.y,
+    };
     const auto desktopRect = Rect::fromRECT(context.output_desc.DesktopCoordinates);
     const auto rotation = context.output_desc.Rotation;
 
-    const auto center_x = static_cast<long>(target_description.Width) / 2;
-    const auto center_y = static_cast<long>(target_description.Height) / 2;
+    const auto transform = core::VertexTransform::make(
+        Dimension{static_cast<int>(target_description.Width), static_cast<int>(target_description.Height)},
+        targetOffset,
+        Dimension{static_cast<int>(desktop_description.Width), static_cast<int>(desktop_description.Height)});
 
-    const auto make_vertex = [&](int x, int y) {
-        return Vertex{
-            (x + target_x - center_x) / static_cast<float>(center_x),
-            -1 * (y + target_y - center_y) / static_cast<float>(center_y),
-            x / static_cast<float>(desktop_description.Width),
-            y / static_cast<float>(desktop_description.Height)};
-    };
-
-    auto vertexBufferSize = static_cast<uint32_t>(sizeof(quad_vertices) * dirts.size());
-    if (m_dx.vertexBufferSize < vertexBufferSize) {
-        auto buffer_description = D3D11_BUFFER_DESC{
-            .ByteWidth = vertexBufferSize,
-            .Usage = D3D11_USAGE_DYNAMIC,
-            .BindFlags = D3D11_BIND_VERTEX_BUFFER,
-            .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
-            .MiscFlags = {},
-            .StructureByteStride = {},
-        };
-        const auto result = m_dx.device()->CreateBuffer(&buffer_description, nullptr, &m_dx.vertexBuffer);
-        if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create dirty vertex buffer");
-        m_dx.vertexBufferSize = vertexBufferSize;
-    }
+    m_dx.updateTransform(transform);
+    m_dx.ensureInstanceCapacity(dirts.size());
 
     auto mapped = D3D11_MAPPED_SUBRESOURCE{};
     const auto subresource = 0;
     const auto mapType = D3D11_MAP_WRITE_DISCARD;
     const unsigned mapFlags = 0;
-    m_dx.deviceContext()->Map(m_dx.vertexBuffer.Get(), subresource, mapType, mapFlags, &mapped);
-
-    auto *vertex_ptr = static_cast<quad_vertices *>(mapped.pData);
-
-    for (const auto &dirt : dirts) {
-        auto dirtRect = Rect::fromRECT(dirt);
-        const auto rotated = rotate(dirtRect, rotation, desktopRect.dimension);
-        auto &vertices = *vertex_ptr;
-
-        vertices[0] = make_vertex(rotated.left(), rotated.bottom());
-        vertices[1] = make_vertex(rotated.left(), rotated.top());
-        vertices[2] = make_vertex(rotated.right(), rotated.bottom());
-        vertices[3] = vertices[2];
-        vertices[4] = vertices[1];
-        vertices[5] = make_vertex(rotated.right(), rotated.top());
-        vertex_ptr++;
-    }
-    m_dx.deviceContext()->Unmap(m_dx.vertexBuffer.Get(), 0);
+    const auto mapResult =
+        m_dx.deviceContext()->Map(m_dx.instanceBuffer.Get(), subresource, mapType, mapFlags, &mapped);
+    if (IS_ERROR(mapResult)) throw RenderFailure(mapResult, "Failed to map dirty instance buffer");
+
+    auto *instance_ptr = static_cast<core::QuadInstance *>(mapped.pData);
+    core::emitQuadInstances(dirts, rotation, desktopRect.dimension, {instance_ptr, dirts.size()});
+    m_dx.deviceContext()->Unmap(m_dx.instanceBuffer.Get(), 0);
 
-    const uint32_t stride = sizeof(Vertex);
-    const uint32_t offset = 0;
-    m_dx.deviceContext()->IASetVertexBuffers(0, 1, m_dx.vertexBuffer.GetAddressOf(), &stride, &offset);
+    m_dx.activateQuadVertexShader();
+    m_dx.activateQuadBuffers();
 
     auto view_port = D3D11_VIEWPORT{
         .TopLeftX = 0.f,
@@ -189,7 +189,7 @@ void FrameUpdater::updateDirty(const FrameUpdate &data, const FrameContext &cont
 
     [[gsl::suppress("26472")]] // conversion required because of APIs
     m_dx.deviceContext()
-        ->Draw(static_cast<uint32_t>(6 * dirts.size()), 0);
+        ->DrawInstanced(static_cast<uint32_t>(core::unitQuadCorners.size()), static_cast<uint32_t>(dirts.size()), 0, 0);
 
     // dx_m.activateNoRenderTarget();
     ID3D11ShaderResourceView *noResource = nullptr;
@@ -199,11 +199,16 @@ void FrameUpdater::updateDirty(const FrameUpdate &data, const FrameContext &cont
 FrameUpdater::Resources::Resources(FrameUpdater::InitArgs &&args)
     : BaseRenderer(std::move(args)) {
     prepare(args.targetHandle);
+    queryCopyWithOverlap();
+
+    createQuadVertexShader();
+    createUnitQuadBuffer();
+    createTransformBuffer();
 
     activateRenderTarget();
     activateTriangleList();
 
-    activateVertexShader();
+    activateQuadVertexShader();
     activatePlainPixelShader();
     activateDiscreteSampler();
 }
@@ -212,3 +217,88 @@ void FrameUpdater::Resources::prepare(HANDLE targetHandle) {
     target = renderer::getTextureFromHandle(device(), targetHandle);
     renderTarget = renderer::renderToTexture(device(), target);
 }
+
+/// copies inside of one texture are only allowed with ID3D11DeviceContext1 and the CopyWithOverlap feature
+void FrameUpdater::Resources::queryCopyWithOverlap() {
+    auto options = D3D11_FEATURE_DATA_D3D11_OPTIONS{};
+    const auto result = device()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+    if (IS_ERROR(result) || !options.CopyWithOverlap) return;
+    deviceContext()->QueryInterface(__uuidof(ID3D11DeviceContext1), &overlapContext);
+}
+
+void FrameUpdater::Resources::updateTransform(const core::VertexTransform &value) {
+    if (transform == value) return;
+    transform = value;
+    const auto constants = QuadTransformConstants{transform};
+    deviceContext()->UpdateSubresource(transformBuffer.Get(), 0, nullptr, &constants, 0, 0);
+}
+
+/// instance buffer grows in steps (see core::instanceCapacityFor) and is reused for all later frames
+void FrameUpdater::Resources::ensureInstanceCapacity(size_t count) {
+    const auto capacity = core::instanceCapacityFor(count, instanceCapacity);
+    if (instanceBuffer && capacity == instanceCapacity) return;
+    auto buffer_description = D3D11_BUFFER_DESC{
+        .ByteWidth = static_cast<UINT>(capacity * sizeof(core::QuadInstance)),
+        .Usage = D3D11_USAGE_DYNAMIC,
+        .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+        .CPUAccessFlags = D3D11_CPU_ACCESS_WRITE,
+        .MiscFlags = {},
+        .StructureByteStride = {},
+    };
+    instanceBuffer.Reset();
+    const auto result = device()->CreateBuffer(&buffer_description, nullptr, &instanceBuffer);
+    if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create dirty instance buffer");
+    instanceCapacity = capacity;
+}
+
+void FrameUpdater::Resources::createQuadVertexShader() {
+    const auto size = ARRAYSIZE(g_QuadVertexShader);
+    auto shader = &g_QuadVertexShader[0];
+    static constexpr ID3D11ClassLinkage *noLinkage = nullptr;
+    auto result = device()->CreateVertexShader(shader, size, noLinkage, &quadVertexShader);
+    if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create quad vertex shader");
+
+    static const auto layout = std::array{
+        D3D11_INPUT_ELEMENT_DESC{"CORNER", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+        D3D11_INPUT_ELEMENT_DESC{"RECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1}};
+    const auto layout_size = static_cast<uint32_t>(layout.size());
+    result = device()->CreateInputLayout(layout.data(), layout_size, shader, size, &quadInputLayout);
+    if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create quad input layout");
+}
+
+void FrameUpdater::Resources::createUnitQuadBuffer() {
+    const auto buffer_description = D3D11_BUFFER_DESC{
+        .ByteWidth = static_cast<UINT>(sizeof(core::unitQuadCorners)),
+        .Usage = D3D11_USAGE_IMMUTABLE,
+        .BindFlags = D3D11_BIND_VERTEX_BUFFER,
+        .CPUAccessFlags = {},
+        .MiscFlags = {},
+        .StructureByteStride = {},
+    };
+    const auto data = D3D11_SUBRESOURCE_DATA{
+        .pSysMem = core::unitQuadCorners.data(),
+        .SysMemPitch = {},
+        .SysMemSlicePitch = {},
+    };
+    const auto result = device()->CreateBuffer(&buffer_description, &data, &unitQuadBuffer);
+    if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create unit quad buffer");
+}
+
+void FrameUpdater::Resources::createTransformBuffer() {
+    const auto buffer_description = D3D11_BUFFER_DESC{
+        .ByteWidth = static_cast<UINT>(sizeof(QuadTransformConstants)),
+        .Usage = D3D11_USAGE_DEFAULT,
+        .BindFlags = D3D11_BIND_CONSTANT_BUFFER,
+        .CPUAccessFlags = {},
+        .MiscFlags = {},
+        .StructureByteStride = {},
+    };
+    const auto constants = QuadTransformConstants{transform};
+    const auto data = D3D11_SUBRESOURCE_DATA{
+        .pSysMem = &constants,
+        .SysMemPitch = {},
+        .SysMemSlicePitch = {},
+    };
+    const auto result = device()->CreateBuffer(&buffer_description, &data, &transformBuffer);
+    if (IS_ERROR(result)) throw RenderFailure(result, "Failed to create quad transform buffer");
+}
@@ -1,8 +1,12 @@
 #pragma once
 #include "BaseRenderer.h"
 
+#include "core/MovePlanner.h"
+
 #include <array>
+#include <d3d11_1.h>
 #include <meta/comptr.h>
+#include <vector>
 
 struct FrameUpdate;
 struct FrameContext;
@@ -16,7 +20,6 @@ struct FrameUpdater {
         HANDLE targetHandle{}; // shared texture handle that should be updated
     };
     using Vertex = BaseRenderer::Vertex;
-    using quad_vertices = std::array<Vertex, 6>;
 
     FrameUpdater(InitArgs &&args);
 
@@ -25,6 +28,7 @@ struct FrameUpdater {
 private:
     void performMoves(const FrameUpdate &data, const FrameContext &context);
     void updateDirty(const FrameUpdate &data, const FrameContext &context);
+    void ensureMoveTmp(win32::Dimension);
 
 private:
     struct Resources : BaseRenderer {
@@ -33,13 +37,44 @@ private:
         void prepare(HANDLE targetHandle);
 
         void activateRenderTarget() { deviceContext()->OMSetRenderTargets(1, renderTarget.GetAddressOf(), nullptr); }
+        void activateQuadVertexShader() const {
+            deviceContext()->VSSetShader(quadVertexShader.Get(), nullptr, 0);
+            deviceContext()->VSSetConstantBuffers(0, 1, transformBuffer.GetAddressOf());
+            deviceContext()->IASetInputLayout(quadInputLayout.Get());
+        }
+        void activateQuadBuffers() {
+            const auto buffers = std::array{unitQuadBuffer.Get(), instanceBuffer.Get()};
+            const auto strides =
+                std::array{uint32_t{sizeof(core::unitQuadCorners[0])}, uint32_t{sizeof(core::QuadInstance)}};
+            const auto offsets = std::array{uint32_t{}, uint32_t{}};
+            deviceContext()->IASetVertexBuffers(0, 2, buffers.data(), strides.data(), offsets.data());
+        }
+
+        void updateTransform(const core::VertexTransform &);
+        void ensureInstanceCapacity(size_t count);
 
         ComPtr<ID3D11Texture2D> target;
         ComPtr<ID3D11RenderTargetView> renderTarget;
+        ComPtr<ID3D11DeviceContext1> overlapContext; // only set if copies inside of one texture are supported
 
         ComPtr<ID3D11Texture2D> moveTmp;
-        ComPtr<ID3D11Buffer> vertexBuffer;
-        uint32_t vertexBufferSize{};
+        win32::Dimension moveTmpDimension{};
+
+        ComPtr<ID3D11VertexShader> quadVertexShader;
+        ComPtr<ID3D11InputLayout> quadInputLayout;
+        ComPtr<ID3D11Buffer> unitQuadBuffer;
+        ComPtr<ID3D11Buffer> transformBuffer;
+        core::VertexTransform transform{};
+        ComPtr<ID3D11Buffer> instanceBuffer;
+        size_t instanceCapacity{};
+
+    private:
+        void createQuadVertexShader();
+        void createUnitQuadBuffer();
+        void createTransformBuffer();
+        void queryCopyWithOverlap();
     };
     Resources m_dx;
+    core::MovePlanner m_movePlanner;
+    std::vector<core::RectMove> m_moves;
 };
@@ -133,6 +133,7 @@ void MainApplication::updateScreenRect(Rect rect) {
             m_captureAreaWindow->updateRect(operatonModeLens().captureAreaRect());
         if (config().operationMode == OperationMode::CaptureArea && m_duplicationController)
             m_duplicationController->updateCaptureOffset(operatonModeLens().captureOffset());
+        if (m_duplicationController) m_duplicationController->updateScreenRect(rect);
     }
 }
 
@@ -293,14 +294,51 @@ void MainApplication::refreshMonitors() {
     }
 }
 
+auto MainApplication::presentLatency() -> core::PresentLatency {
+    if (!m_duplicationController) return {};
+    return m_duplicationController->presentLatency();
+}
+
+void MainApplication::exportPresentLatency() {
+    if (!m_duplicationController) return;
+    auto error = std::error_code{};
+    const auto path = std::filesystem::temp_directory_path(error) / "deskdupl-latency.csv";
+    const auto success = !error && m_duplicationController->exportPresentLatency(path);
+    OutputDebugStringA(success ? "latency exported to " : "failed to export latency to ");
+    OutputDebugStringW(path.c_str());
+    OutputDebugStringA("\n");
+}
+
+void MainApplication::resetPresentLatency() {
+    if (m_duplicationController) m_duplicationController->resetPresentLatency();
+}
+
+bool MainApplication::isRecordingSession() const {
+    return m_duplicationController && m_duplicationController->isRecordingSession();
+}
+
+void MainApplication::toggleSessionRecording() {
+    if (!m_duplicationController) return;
+    if (m_duplicationController->isRecordingSession()) {
+        m_duplicationController->stopSessionRecording();
+        return;
+    }
+    auto error = std::error_code{};
+    const auto path = std::filesystem::temp_directory_path(error) / "deskdupl-session.ddtrace";
+    const auto success = !error && m_duplicationController->startSessionRecording(path);
+    OutputDebugStringA(success ? "recording session to " : "failed to record session to ");
+    OutputDebugStringW(path.c_str());
+    OutputDebugStringA("\n");
+}
+
 bool MainApplication::updateCaptureAreaOutputScreen() {
     auto dm = DisplayMonitor::fromRect(m_state.config.outputRect());
     if (dm.handle() != m_state.monitors[m_state.outputMonitor].handle) {
         m_state.outputMonitor = m_state.computeIndexForMonitorHandle(dm.handle());
-        updateScreenRect(m_state.monitors[m_state.outputMonitor].info.monitorRect);
         if (m_duplicationController) {
             m_duplicationController->restart();
         }
+        updateScreenRect(m_state.monitors[m_state.outputMonitor].info.monitorRect);
         return true;
     }
     return false;
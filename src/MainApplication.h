@@ -36,6 +36,11 @@ private:
     void changeDuplicationStatus(DuplicationStatus) override;
     void toggleOutputMaximize() override;
     void refreshMonitors() override;
+    auto presentLatency() -> core::PresentLatency override;
+    void exportPresentLatency() override;
+    void resetPresentLatency() override;
+    bool isRecordingSession() const override;
+    void toggleSessionRecording() override;
 
 private:
     bool updateCaptureAreaOutputScreen();
@@ -1,6 +1,7 @@
 #pragma once
 #include "Model.h"
 
+#include "core/LatencyHistogram.h"
 #include "win32/Geometry.h"
 
 namespace deskdup {
@@ -34,6 +35,11 @@ struct MainController {
     virtual void changeDuplicationStatus(DuplicationStatus status) = 0;
     virtual void toggleOutputMaximize() = 0;
     virtual void refreshMonitors() = 0;
+    virtual auto presentLatency() -> core::PresentLatency = 0;
+    virtual void exportPresentLatency() = 0;
+    virtual void resetPresentLatency() = 0;
+    virtual bool isRecordingSession() const = 0;
+    virtual void toggleSessionRecording() = 0;
 
     void togglePause() {
         using enum DuplicationStatus;
@@ -1,10 +1,26 @@
 #include "OutputWindow.h"
 #include "Model.h"
 
+#include "core/FrameTrace.h"
+
+#include <format>
+
 namespace deskdup {
 
 namespace {
 
+#ifdef DESKDUP_FRAME_TRACE
+/// writes the frame trace as json & csv into the temp directory
+void writeFrameTrace() {
+    auto error = std::error_code{};
+    const auto path = std::filesystem::temp_directory_path(error) / "deskdupl-frames";
+    const auto success = !error && core::FrameTrace::writeFiles(path);
+    OutputDebugStringA(success ? "frame trace written to " : "failed to write frame trace to ");
+    OutputDebugStringW(path.c_str());
+    OutputDebugStringA(".json/.csv\n");
+}
+#endif
+
 void ShowWindowBorder(HWND windowHandle, bool shown) noexcept {
     auto style = GetWindowLong(windowHandle, GWL_STYLE);
     auto exstyle = GetWindowLong(windowHandle, GWL_EXSTYLE);
@@ -192,6 +208,9 @@ enum MenuCommands : int {
     Menu_ScreenMax = 299,
     Menu_ModePresentMirror = 300,
     Menu_ModeCaptureRegion = 301,
+    Menu_LatencyExport = 400,
+    Menu_LatencyReset = 401,
+    Menu_RecordSession = 500,
 };
 struct Resolution {
     win32::Dimension dim;
@@ -255,6 +274,36 @@ void OutputWindow::contextMenu(const Point &position) {
             m_controller.config().operationMode == OperationMode::CaptureArea ? UINT{MF_CHECKED} : UINT{MF_STRING};
         AppendMenu(hPopupMenu, flags, Menu_ModeCaptureRegion, L"Capture Region");
     }
+    AppendMenu(hPopupMenu, MF_SEPARATOR, 0, nullptr);
+    auto hLatencyMenu = CreatePopupMenu();
+    {
+        const auto latency = m_controller.presentLatency();
+        const auto appendSummary = [&](const wchar_t *name, core::LatencyHistogram::Summary const &summary) {
+            const auto ms = [](uint64_t micros) { return static_cast<double>(micros) / 1000.0; };
+            const auto label = summary.count == 0
+                ? std::format(L"{}: no samples", name)
+                : std::format(
+                      L"{}: p50 {:.1f}ms, p90 {:.1f}ms, p99 {:.1f}ms, max {:.1f}ms ({} samples)",
+                      name,
+                      ms(summary.p50),
+                      ms(summary.p90),
+                      ms(summary.p99),
+                      ms(summary.max),
+                      summary.count);
+            AppendMenu(hLatencyMenu, MF_STRING | MF_DISABLED, 0, label.data());
+        };
+        appendSummary(L"Capture to present", latency.capture);
+        appendSummary(L"Pointer to present", latency.pointer);
+        AppendMenu(hLatencyMenu, MF_SEPARATOR, 0, nullptr);
+        AppendMenu(hLatencyMenu, MF_STRING, Menu_LatencyExport, L"Export CSV to Temp Folder");
+        AppendMenu(hLatencyMenu, MF_STRING, Menu_LatencyReset, L"Reset");
+    }
+    AppendMenu(hPopupMenu, MF_POPUP, std::bit_cast<UINT_PTR>(hLatencyMenu), L"Latency");
+    {
+        auto flags = m_controller.isRecordingSession() ? UINT{MF_CHECKED} : UINT{MF_STRING};
+        AppendMenu(hPopupMenu, flags, Menu_RecordSession, L"Record Session to Temp Folder");
+    }
+
     auto const menuPos = [&]() {
         if (position.x < 0 || position.y < 0) {
             auto tmp = POINT{};
@@ -266,6 +315,7 @@ void OutputWindow::contextMenu(const Point &position) {
     TrackPopupMenuEx(hPopupMenu, 0, menuPos.x, menuPos.y, m_window.handle(), nullptr);
     DestroyMenu(hResolutionMenu);
     DestroyMenu(hScreenMenu);
+    DestroyMenu(hLatencyMenu);
     DestroyMenu(hPopupMenu);
 }
 
@@ -281,6 +331,9 @@ auto OutputWindow::menuCommand(uint16_t command) -> win32::OptLRESULT {
         m_controller.captureScreen(scr);
         return LRESULT{};
     }
+    if (command == Menu_LatencyExport) m_controller.exportPresentLatency();
+    if (command == Menu_LatencyReset) m_controller.resetPresentLatency();
+    if (command == Menu_RecordSession) m_controller.toggleSessionRecording();
     if (command == Menu_ModePresentMirror) {
         m_controller.changeOperationMode(OperationMode::PresentMirror);
     }
@@ -351,6 +404,11 @@ bool OutputWindow::inputKeyDown(uint32_t keyCode) {
                 m_controller.zoomOutputBy(-0.001f);
             }
             return true;
+#ifdef DESKDUP_FRAME_TRACE
+        case 'T': // Trace
+            if (mk == MK_CONTROL) writeFrameTrace();
+            return true;
+#endif
         case 'F': // Freeze
         case 'P': // Pause / Play
             if (mk == MK_CONTROL) {
@@ -5,11 +5,13 @@
 
 #include <utility>
 
-void PointerUpdater::update(PointerUpdate &update, const FrameContext &context) {
-    if (update.update_time == 0) return;
+bool PointerUpdater::update(PointerUpdate &update, const FrameContext &context) {
+    if (update.update_time == 0) return false;
+    auto changed = false;
     if (m_pointer_desktop == context.output_desc.DesktopCoordinates //
         || (update.position.Visible &&
             (!m_pointer.visible || update.update_time > m_pointer.position_timestamp))) {
+        changed = true;
         m_pointer_desktop = context.output_desc.DesktopCoordinates;
         m_pointer.position_timestamp = update.update_time;
         m_pointer.visible = update.position.Visible;
@@ -19,8 +21,13 @@ void PointerUpdater::update(PointerUpdate &update, const FrameContext &context)
                                context.output_desc.DesktopCoordinates.top - context.offset.y;
     }
     if (!update.shape_buffer.empty()) {
+        const auto key = core::PointerShapeKey::make(update.shape_info, update.shape_buffer);
+        if (key == m_pointer.shape_key) return changed; // same shape again
+        m_pointer.shape_key = key;
         m_pointer.shape_timestamp = update.update_time;
-        m_pointer.shape_data = std::move(update.shape_buffer);
+        std::swap(m_pointer.shape_data, update.shape_buffer); // previous shape can be recycled
         m_pointer.shape_info = update.shape_info;
+        changed = true;
     }
+    return changed;
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include "core/PointerShape.h"
+
 #include <dxgi1_3.h>
 
 #include <stdint.h>
@@ -14,11 +16,13 @@ struct PointerBuffer {
 
     uint64_t shape_timestamp = 0; // timestamp of last shape update
     DXGI_OUTDUPL_POINTER_SHAPE_INFO shape_info{};
+    core::PointerShapeKey shape_key{}; // identifies the shape content
     std::vector<uint8_t> shape_data{}; // buffer for with shape texture
 };
 
 struct PointerUpdater {
-    void update(PointerUpdate &update, const FrameContext &context);
+    /// returns true if position, visibility or shape changed
+    bool update(PointerUpdate &update, const FrameContext &context);
 
     auto data() const noexcept -> const PointerBuffer & { return m_pointer; }
 
@@ -0,0 +1,24 @@
+// draws one instance of the unit quad per rect (see core::QuadInstance)
+cbuffer QuadTransform : register(b0) {
+    float2 positionScale;
+    float2 positionOffset;
+    float2 textureScale;
+};
+
+struct VertexInput {
+    float2 corner : CORNER; // unit quad
+    float4 rect : RECT; // per instance: left, top, right, bottom
+};
+
+struct VertexOutput {
+    float4 position : SV_POSITION;
+	float2 texCoord : TEXCOORD0;
+};
+
+VertexOutput main(VertexInput input) {
+	float2 pixel = lerp(input.rect.xy, input.rect.zw, input.corner);
+	VertexOutput ret;
+	ret.position = float4(pixel * positionScale + positionOffset, 0, 1);
+	ret.texCoord = pixel * textureScale;
+	return ret;
+}
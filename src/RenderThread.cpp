@@ -1,5 +1,7 @@
 #include "RenderThread.h"
 
+#include "core/FrameTrace.h"
+
 namespace deskdup {
 
 RenderThread::RenderThread(Config const &config)
@@ -14,6 +16,7 @@ void RenderThread::start() {
     m_threadLoop.enableAwaitAlerts();
     m_stdThread.emplace([this] {
         m_thread = win32::Thread::fromCurrent();
+        FRAME_TRACE_THREAD("render");
         m_threadLoop.run();
     });
 }
@@ -37,7 +37,7 @@ private:
     WindowRenderer m_windowRenderer;
 
     bool m_hasFrameRendered{};
-    bool m_isDirty{};
+    bool m_isDirty{}; // damage is collected by the WindowRenderer until the next frame
     bool m_hasFrameHandle{};
     Handle m_waitFrameHandle{};
 
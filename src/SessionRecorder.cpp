@@ -0,0 +1,151 @@
+#include "SessionRecorder.h"
+
+#include "CapturedUpdate.h"
+#include "FrameContext.h"
+
+#include "core/Rotation.h"
+#include "core/VisibleAreaCuller.h"
+
+#include <cstring>
+
+namespace {
+
+using core::SessionTrace;
+using win32::Rect;
+
+} // namespace
+
+SessionRecorder::SessionRecorder(Config config)
+    : m_config{std::move(config)} {
+    m_isOpen = m_writer.open(m_config.path);
+    if (m_isOpen) m_thread = std::jthread{[this] { run(); }};
+}
+
+SessionRecorder::~SessionRecorder() {
+    if (!m_thread.joinable()) return;
+    m_stopping.store(true, std::memory_order_release);
+    m_wake.notify();
+    m_thread.join();
+}
+
+auto SessionRecorder::stats() const -> Stats {
+    return {
+        .recorded = m_recorded.load(std::memory_order_relaxed),
+        .dropped = m_dropped.load(std::memory_order_relaxed),
+        .bytes = m_bytes.load(std::memory_order_relaxed),
+        .keyframes = m_keyframes.load(std::memory_order_relaxed),
+        .failed = m_failed.load(std::memory_order_relaxed),
+    };
+}
+
+bool SessionRecorder::record(CapturedUpdate const &update, FrameContext const &context, core::SurfaceView image) {
+    if (!m_isOpen) return false;
+    const auto &desc = context.output_desc;
+    const auto isSameOutput = m_session && m_session->rotation == desc.Rotation &&
+        Rect::fromRECT(m_session->desktop) == Rect::fromRECT(desc.DesktopCoordinates);
+    if (!isSameOutput) {
+        const auto session = SessionTrace::Session{
+            .desktop = desc.DesktopCoordinates,
+            .rotation = desc.Rotation,
+            .ticksPerSecond = m_config.ticksPerSecond,
+        };
+        auto buffer = m_pool.take(SessionTrace::encodedSize(session));
+        SessionTrace::encode(session, buffer);
+        if (!push(std::move(buffer))) return false;
+        m_session = session;
+    }
+
+    const auto &frame = update.frame;
+    m_imageRects.clear();
+    if (frame.hasImage() && image) {
+        const auto desktopDim = Rect::fromRECT(desc.DesktopCoordinates).dimension;
+        const auto imageRect = Rect{{}, image.dimension};
+        for (const auto &dirty : frame.dirty()) {
+            const auto rotated = core::rotate(Rect::fromRECT(dirty), desc.Rotation, desktopDim);
+            const auto clipped = core::intersect(rotated, imageRect);
+            if (clipped) m_imageRects.push_back(clipped->toRECT());
+        }
+    }
+    const auto traceUpdate = SessionTrace::Update{
+        .sequence = frame.sequence,
+        .presentTime = frame.present_time,
+        .frames = frame.frames,
+        .rectsCoalesced = frame.rects_coalesced,
+        .protectedContentMaskedOut = frame.protected_content_masked_out,
+        .hasImage = frame.hasImage(),
+        .moved = frame.moved(),
+        .dirty = frame.dirty(),
+        .imageRects = m_imageRects,
+        .pointerUpdateTime = update.pointer.update_time,
+        .pointerPosition = update.pointer.position,
+        .shapeInfo = update.pointer.shape_info,
+        .shape = update.pointer.shape_buffer,
+    };
+    auto buffer = m_pool.take(SessionTrace::encodedSize(traceUpdate));
+    SessionTrace::encode(traceUpdate, image, buffer);
+    if (!push(std::move(buffer))) return false;
+    m_recorded.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool SessionRecorder::push(Buffer &&buffer) {
+    const auto bytes = buffer.size();
+    const auto pending = m_pendingBytes.load(std::memory_order_relaxed);
+    if (pending + bytes > m_config.maxPendingBytes || !m_ring.tryPush(std::move(buffer))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_pool.give(std::move(buffer));
+        return false;
+    }
+    m_pendingBytes.fetch_add(bytes, std::memory_order_relaxed);
+    m_wake.notify();
+    return true;
+}
+
+void SessionRecorder::run() {
+    auto buffer = Buffer{};
+    auto isStopping = false;
+    while (!isStopping) {
+        m_wake.wait();
+        // note: everything was pushed before stopping is signaled
+        isStopping = m_stopping.load(std::memory_order_acquire);
+        while (m_ring.tryPop(buffer)) {
+            write(buffer);
+            m_pendingBytes.fetch_sub(buffer.size(), std::memory_order_relaxed);
+            m_pool.give(std::move(buffer));
+        }
+    }
+    if (!m_writer.finish()) m_failed.store(true, std::memory_order_relaxed);
+    m_bytes.store(m_writer.bytesWritten(), std::memory_order_relaxed);
+}
+
+void SessionRecorder::write(Buffer const &record) {
+    if (!m_writer.append(record)) {
+        m_failed.store(true, std::memory_order_relaxed);
+        return;
+    }
+    auto header = SessionTrace::RecordHeader{};
+    std::memcpy(&header, record.data(), sizeof(header));
+    const auto payload = std::span{record}.subspan(sizeof(header), static_cast<size_t>(header.bytes));
+    if (header.type == SessionTrace::RecordType::Session) {
+        m_image.reset(*SessionTrace::decodeSession(payload));
+        m_updatesSinceKeyframe = 0;
+        m_pixelBytesSinceKeyframe = 0;
+    }
+    else if (header.type == SessionTrace::RecordType::Update) {
+        const auto update = *SessionTrace::decodeUpdate(payload);
+        m_image.apply(update);
+        m_updatesSinceKeyframe++;
+        m_pixelBytesSinceKeyframe += update.pixels.size();
+
+        const auto imageBytes = static_cast<size_t>(m_image.view().pitch) * m_image.view().dimension.height;
+        const auto isDue = m_updatesSinceKeyframe >= m_config.keyframeInterval ||
+            m_pixelBytesSinceKeyframe >= m_config.keyframeDeltaFactor * imageBytes;
+        if (isDue && m_pixelBytesSinceKeyframe != 0) {
+            if (!m_writer.appendKeyframe(m_image.view())) m_failed.store(true, std::memory_order_relaxed);
+            m_keyframes.fetch_add(1, std::memory_order_relaxed);
+            m_updatesSinceKeyframe = 0;
+            m_pixelBytesSinceKeyframe = 0;
+        }
+    }
+    m_bytes.store(m_writer.bytesWritten(), std::memory_order_relaxed);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "core/BufferPool.h"
+#include "core/SessionTrace.h"
+#include "core/SpscRing.h"
+#include "core/Surface.h"
+#include "win32/Geometry.h"
+
+#include <atomic>
+#include <filesystem>
+#include <optional>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+struct CapturedUpdate;
+struct FrameContext;
+
+/// Records captured updates into a session trace file (see core::SessionTrace)
+/// note:
+/// * record() is called by the CaptureThread - it only encodes the update into a pooled buffer
+/// * the recorder thread appends the buffers to the file and writes the index when the recorder is destroyed
+/// * the recorder thread also reconstructs the image and writes periodic keyframes, so replays can seek
+/// * updates are dropped while too many bytes are pending, the caller should record the entire display next
+struct SessionRecorder {
+    struct Config {
+        std::filesystem::path path{};
+        int64_t ticksPerSecond{10'000'000}; // unit of present & pointer update times
+        size_t maxPendingBytes{256 * 1024 * 1024}; // encoded updates waiting for the recorder thread
+        size_t keyframeInterval{300}; // updates between two keyframes (if any pixels changed)
+        size_t keyframeDeltaFactor{8}; // keyframe once the pixels since the last exceed this many images
+    };
+    struct Stats {
+        uint64_t recorded{}; ///< updates handed to the recorder thread
+        uint64_t dropped{}; ///< updates dropped because the recorder thread fell behind
+        uint64_t bytes{}; ///< bytes written to the file
+        uint64_t keyframes{}; ///< full images written to allow seeking
+        bool failed{}; ///< writing the file failed
+    };
+
+    /// opens the file and starts the recorder thread
+    explicit SessionRecorder(Config);
+    ~SessionRecorder();
+    SessionRecorder(SessionRecorder const &) = delete;
+    SessionRecorder &operator=(SessionRecorder const &) = delete;
+
+    bool isOpen() const { return m_isOpen; }
+
+    /// record update - returns false if it was dropped
+    /// note: image contains the display in system memory (only read for updates with an image)
+    bool record(CapturedUpdate const &, FrameContext const &, core::SurfaceView image);
+
+    auto stats() const -> Stats; ///< note: thread safe
+
+private:
+    using Buffer = core::BufferPool::Buffer;
+    bool push(Buffer &&);
+    void run();
+    void write(Buffer const &);
+
+private:
+    Config m_config;
+    core::SessionTraceWriter m_writer{};
+    bool m_isOpen{};
+
+    // used by the thread that calls record()
+    std::optional<core::SessionTrace::Session> m_session{};
+    std::vector<RECT> m_imageRects{};
+
+    core::BufferPool m_pool{8, 256 * 1024};
+    core::SpscRing<Buffer, 64> m_ring{};
+    core::WakeSignal m_wake{};
+    std::atomic<size_t> m_pendingBytes{};
+    std::atomic<bool> m_stopping{};
+
+    // used by the recorder thread
+    core::SessionTraceImage m_image{};
+    size_t m_updatesSinceKeyframe{};
+    size_t m_pixelBytesSinceKeyframe{};
+
+    std::atomic<uint64_t> m_recorded{};
+    std::atomic<uint64_t> m_dropped{};
+    std::atomic<uint64_t> m_bytes{};
+    std::atomic<uint64_t> m_keyframes{};
+    std::atomic<bool> m_failed{};
+
+    std::jthread m_thread{};
+};
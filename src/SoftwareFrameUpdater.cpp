@@ -0,0 +1,103 @@
+#include "SoftwareFrameUpdater.h"
+
+#include "CapturedUpdate.h"
+#include "FrameContext.h"
+
+#include "core/PixelCopy.h"
+#include "core/RectTransform.h"
+#include "core/Rotation.h"
+#include "core/VisibleAreaCuller.h"
+
+#include <algorithm>
+
+namespace {
+
+using core::containsRect;
+using core::intersect;
+using core::rotate;
+using win32::Dimension;
+using win32::Point;
+using win32::Rect;
+
+auto targetOffset(const FrameContext &context) -> Point {
+    return {
+        context.output_desc.DesktopCoordinates.left - context.offset.x,
+        context.output_desc.DesktopCoordinates.top - context.offset.y,
+    };
+}
+
+} // namespace
+
+SoftwareFrameUpdater::SoftwareFrameUpdater(Dimension targetDim)
+    : m_target{targetDim} {}
+
+void SoftwareFrameUpdater::update(const FrameUpdate &data, const FrameContext &context) {
+    performMoves(data, context);
+    updateDirty(data, context);
+    m_stats.frames++;
+}
+
+void SoftwareFrameUpdater::performMoves(const FrameUpdate &data, const FrameContext &context) {
+    const auto moved = data.moved();
+    if (moved.empty()) return;
+
+    const auto desktopDim = Rect::fromRECT(context.output_desc.DesktopCoordinates).dimension;
+    const auto target = targetOffset(context);
+    const auto targetRect = Rect{{}, m_target.dimension()};
+    const auto rotation = context.output_desc.Rotation;
+
+    m_moves.clear();
+    for (const auto &move : moved) {
+        const auto moveDestinationRect = Rect::fromRECT(move.DestinationRect);
+        const auto moveSourcePoint = Point::fromPOINT(move.SourcePoint);
+
+        const auto sourceRect = rotate(Rect{moveSourcePoint, moveDestinationRect.dimension}, rotation, desktopDim);
+        const auto dest = rotate(moveDestinationRect, rotation, desktopDim);
+        const auto source =
+            Rect{Point{sourceRect.left() + target.x, sourceRect.top() + target.y}, sourceRect.dimension};
+        const auto destination = Rect{Point{dest.left() + target.x, dest.top() + target.y}, dest.dimension};
+        // D3D drops copies with boxes outside of the texture
+        if (!containsRect(targetRect, source) || !containsRect(targetRect, destination)) continue;
+        m_moves.push_back({source, destination.topLeft});
+        m_stats.movedBytes += static_cast<uint64_t>(source.width()) * source.height() * core::bytesPerPixel;
+    }
+    const auto &plan = m_movePlanner.plan(m_moves);
+    const auto &tempDim = plan.tempDimension;
+    if (m_moveTmp.dimension().width < tempDim.width || m_moveTmp.dimension().height < tempDim.height) {
+        m_moveTmp = core::Surface{Dimension{
+            std::max(m_moveTmp.dimension().width, tempDim.width),
+            std::max(m_moveTmp.dimension().height, tempDim.height),
+        }};
+    }
+    core::executeMovePlan(m_target.span(), plan, m_moveTmp.span());
+}
+
+void SoftwareFrameUpdater::updateDirty(const FrameUpdate &data, const FrameContext &context) {
+    const auto dirts = data.dirty();
+    const auto image = data.cpuImage;
+    if (dirts.empty() || !image) return;
+
+    const auto desktopDim = Rect::fromRECT(context.output_desc.DesktopCoordinates).dimension;
+    const auto target = targetOffset(context);
+    const auto targetRect = Rect{{}, m_target.dimension()};
+    const auto imageRect = Rect{{}, image.dimension};
+
+    m_rotatedDirty.resize(dirts.size());
+    core::rotateRects(dirts, context.output_desc.Rotation, desktopDim, m_rotatedDirty);
+
+    for (const auto &rotated : m_rotatedDirty) {
+        // like the rasterizer only pixels inside of the target and the image are written
+        const auto source = intersect(Rect::fromRECT(rotated), imageRect);
+        if (!source) continue;
+        const auto destination =
+            intersect(Rect{Point{source->left() + target.x, source->top() + target.y}, source->dimension}, targetRect);
+        if (!destination) continue;
+        const auto clippedSource = Rect{
+            Point{destination->left() - target.x, destination->top() - target.y},
+            destination->dimension,
+        };
+        core::copyRect(image, clippedSource, m_target.span(), destination->topLeft);
+        m_stats.copiedBytes +=
+            static_cast<uint64_t>(destination->width()) * destination->height() * core::bytesPerPixel;
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "core/MovePlanner.h"
+#include "core/Surface.h"
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+#include <stdint.h>
+#include <vector>
+
+struct FrameUpdate;
+struct FrameContext;
+
+/// Applies frame updates to a BGRA surface in system memory
+/// note:
+/// * same semantics as FrameUpdater: moves first, then the dirty rects are copied from FrameUpdate::cpuImage
+/// * works on machines without GPU and is a bit exact reference for the D3D path
+struct SoftwareFrameUpdater {
+    struct Stats {
+        uint64_t frames{};
+        uint64_t movedBytes{};
+        uint64_t copiedBytes{};
+    };
+
+    explicit SoftwareFrameUpdater(win32::Dimension targetDim);
+
+    void update(const FrameUpdate &data, const FrameContext &context);
+
+    auto surface() const -> core::SurfaceView { return m_target.view(); }
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    void performMoves(const FrameUpdate &data, const FrameContext &context);
+    void updateDirty(const FrameUpdate &data, const FrameContext &context);
+
+private:
+    core::Surface m_target;
+    core::Surface m_moveTmp{};
+    core::MovePlanner m_movePlanner{};
+    std::vector<core::RectMove> m_moves{};
+    std::vector<RECT> m_rotatedDirty{};
+    Stats m_stats{};
+};
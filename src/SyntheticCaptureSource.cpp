@@ -0,0 +1,211 @@
+#include "SyntheticCaptureSource.h"
+
+#include "CapturedUpdate.h"
+
+#include "core/Rotation.h"
+
+#include <cstring>
+#include <span>
+#include <thread>
+
+namespace {
+
+using core::rotate;
+using core::SurfaceSpan;
+using win32::Rect;
+
+constexpr auto opaque = uint32_t{0xFF000000};
+
+void fillRect(SurfaceSpan surface, Rect rect, uint32_t seed) {
+    for (auto y = rect.top(); y < rect.bottom(); ++y) {
+        auto *pixels = std::bit_cast<uint32_t *>(surface.pixel({rect.left(), y}));
+        const auto rowSeed = seed ^ (static_cast<uint32_t>(y) << 12);
+        for (auto x = 0; x < rect.width(); ++x) pixels[x] = opaque | (rowSeed + static_cast<uint32_t>(x) * 0x010101u);
+    }
+}
+
+/// copy source rect to destination point, source and destination may overlap
+void moveRect(SurfaceSpan surface, Rect source, Point destination) {
+    const auto rowBytes = static_cast<size_t>(source.width()) * core::bytesPerPixel;
+    const auto copyRow = [&](int row) {
+        std::memmove(
+            surface.pixel({destination.x, destination.y + row}),
+            surface.pixel({source.left(), source.top() + row}),
+            rowBytes);
+    };
+    if (destination.y > source.top()) {
+        for (auto row = source.height() - 1; row >= 0; --row) copyRow(row);
+    }
+    else {
+        for (auto row = 0; row < source.height(); ++row) copyRow(row);
+    }
+}
+
+} // namespace
+
+SyntheticCaptureSource::SyntheticCaptureSource(Config config)
+    : m_config{std::move(config)} {}
+
+auto SyntheticCaptureSource::init() -> DXGI_OUTPUT_DESC {
+    m_surface = core::Surface{rotate(m_config.dimension, m_config.rotation)};
+    fillRect(m_surface.span(), Rect{{}, m_surface.dimension()}, 0x404040);
+    m_stepIndex = 0;
+    m_frameCount = 0;
+    m_clock = 0;
+    m_startTime = Clock::now();
+    m_consumedPresents = 0;
+
+    auto desc = DXGI_OUTPUT_DESC{};
+    std::memcpy(desc.DeviceName, L"Synthetic", sizeof(L"Synthetic"));
+    desc.DesktopCoordinates = Rect{m_config.desktopTopLeft, m_config.dimension}.toRECT();
+    desc.AttachedToDesktop = true;
+    desc.Rotation = m_config.rotation;
+    return desc;
+}
+
+auto SyntheticCaptureSource::acquire(Milliseconds timeout) -> std::optional<CapturedUpdate> {
+    if (m_stepIndex >= m_config.script.size()) {
+        if (!m_config.loop || m_config.script.empty()) {
+            std::this_thread::sleep_for(timeout); // nothing changes on this desktop anymore
+            return {};
+        }
+        m_stepIndex = 0;
+    }
+    const auto frames = m_config.presentInterval ? awaitPresents(timeout) : m_config.script[m_stepIndex].frames;
+    if (frames == 0) return {};
+
+    const auto &step = m_config.script[m_stepIndex++];
+    m_frameCount++;
+    m_clock += m_config.ticksPerFrame * frames;
+
+    applyMoves(step);
+    paintDirty(step);
+
+    auto result = std::optional<CapturedUpdate>{};
+    auto &update = result.emplace();
+    update.frame.frames = frames;
+    update.frame.rects_coalesced = step.rectsCoalesced;
+    auto reported = dirty_view{step.dirty};
+    if (!step.unchanged.empty()) {
+        m_reportedRects.assign(step.dirty.begin(), step.dirty.end());
+        m_reportedRects.insert(m_reportedRects.end(), step.unchanged.begin(), step.unchanged.end());
+        reported = m_reportedRects;
+    }
+    if (m_config.pool) {
+        const auto metadataSize = moved_view{step.moved}.size_bytes() + reported.size_bytes();
+        if (metadataSize != 0) update.frame.buffer = m_config.pool->metadata.take(metadataSize);
+    }
+    update.frame.assignRects(step.moved, reported);
+    if (!step.moved.empty() || !reported.empty()) update.frame.present_time = m_clock;
+    update.frame.cpuImage = m_surface.view();
+
+    const auto hasShape = step.pointerShape && *step.pointerShape < m_config.pointerShapes.size();
+    if (step.pointerPosition || hasShape) {
+        update.pointer.update_time = static_cast<uint64_t>(m_clock);
+        update.pointer.position.Visible = step.pointerVisible;
+        if (step.pointerPosition) update.pointer.position.Position = step.pointerPosition->toPOINT();
+    }
+    if (hasShape) {
+        const auto &shape = m_config.pointerShapes[*step.pointerShape];
+        update.pointer.shape_info = shape.info;
+        if (m_config.pool) update.pointer.shape_buffer = m_config.pool->shapes.take(shape.data.size());
+        update.pointer.shape_buffer.assign(shape.data.begin(), shape.data.end());
+    }
+    return result;
+}
+
+void SyntheticCaptureSource::release() {}
+
+bool SyntheticCaptureSource::stage(CapturedUpdate &update) {
+    if (!update.frame.cpuImage) return true;
+    m_stagingRects.clear();
+    for (const auto &dirty : update.frame.dirty()) {
+        m_stagingRects.push_back(rotate(Rect::fromRECT(dirty), m_config.rotation, m_config.dimension));
+    }
+    update.frame.cpuImage = m_staging.stage(update.frame.cpuImage, m_stagingRects);
+    return true;
+}
+
+auto SyntheticCaptureSource::awaitPresents(Milliseconds timeout) -> uint32_t {
+    const auto interval = *m_config.presentInterval;
+    const auto presentsAt = [&](Clock::time_point time) { return (time - m_startTime) / interval; };
+    auto presents = presentsAt(Clock::now());
+    if (presents == m_consumedPresents) {
+        const auto nextPresent = m_startTime + (m_consumedPresents + 1) * interval;
+        if (nextPresent > Clock::now() + timeout) return 0;
+        std::this_thread::sleep_until(nextPresent);
+        presents = presentsAt(Clock::now());
+    }
+    const auto frames = static_cast<uint32_t>(presents - m_consumedPresents);
+    m_consumedPresents = presents;
+    return frames;
+}
+
+void SyntheticCaptureSource::applyMoves(const Step &step) {
+    for (const auto &moves : {std::span{step.moved}, std::span{step.shifted}}) {
+        for (const auto &move : moves) {
+            const auto destination = Rect::fromRECT(move.DestinationRect);
+            const auto source = Rect{Point::fromPOINT(move.SourcePoint), destination.dimension};
+            const auto rotatedSource = rotate(source, m_config.rotation, m_config.dimension);
+            const auto rotatedDestination = rotate(destination, m_config.rotation, m_config.dimension);
+            moveRect(m_surface.span(), rotatedSource, rotatedDestination.topLeft);
+        }
+    }
+}
+
+void SyntheticCaptureSource::paintDirty(const Step &step) {
+    const auto seed = static_cast<uint32_t>(m_frameCount * 2654435761u);
+    for (const auto &dirty : step.dirty) {
+        fillRect(m_surface.span(), rotate(Rect::fromRECT(dirty), m_config.rotation, m_config.dimension), seed);
+    }
+}
+
+auto SyntheticCaptureSource::colorArrowShape() -> PointerShape {
+    constexpr auto size = 32u;
+    auto shape = PointerShape{
+        .info =
+            DXGI_OUTDUPL_POINTER_SHAPE_INFO{
+                .Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR,
+                .Width = size,
+                .Height = size,
+                .Pitch = size * core::bytesPerPixel,
+                .HotSpot = {0, 0},
+            },
+        .data = std::vector<uint8_t>(size * size * core::bytesPerPixel),
+    };
+    auto *pixels = std::bit_cast<uint32_t *>(shape.data.data());
+    for (auto y = 0u; y < size; ++y) {
+        for (auto x = 0u; x <= y / 2; ++x) {
+            const auto isBorder = x == 0 || x == y / 2 || y == size - 1;
+            pixels[y * size + x] = isBorder ? 0xFF000000 : 0xFFFFFFFF;
+        }
+    }
+    return shape;
+}
+
+auto SyntheticCaptureSource::monochromeBeamShape() -> PointerShape {
+    constexpr auto size = 32u;
+    constexpr auto pitch = size / 8;
+    auto shape = PointerShape{
+        .info =
+            DXGI_OUTDUPL_POINTER_SHAPE_INFO{
+                .Type = DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME,
+                .Width = size,
+                .Height = size * 2, // and mask followed by xor mask
+                .Pitch = pitch,
+                .HotSpot = {size / 2, size / 2},
+            },
+        .data = std::vector<uint8_t>(pitch * size * 2, 0xFF), // and mask keeps the screen
+    };
+    auto *xorMask = shape.data.data() + pitch * size;
+    std::memset(xorMask, 0, pitch * size);
+    for (auto y = 4u; y < size - 4; ++y) {
+        const auto isSerif = y < 6 || y >= size - 6;
+        const auto first = isSerif ? 12u : 15u;
+        const auto last = isSerif ? 19u : 16u;
+        for (auto x = first; x <= last; ++x) {
+            xorMask[y * pitch + x / 8] |= static_cast<uint8_t>(0x80 >> (x & 7)); // inverts the screen
+        }
+    }
+    return shape;
+}
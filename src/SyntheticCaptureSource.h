@@ -0,0 +1,82 @@
+#pragma once
+#include "CaptureSource.h"
+
+#include "core/CaptureStaging.h"
+#include "core/Surface.h"
+#include "win32/Geometry.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <vector>
+
+struct CapturedUpdatePool;
+
+using win32::Dimension;
+using win32::Point;
+
+/// Deterministic capture source that plays a script of updates on a CPU BGRA surface
+/// note: allows to drive and measure the pipeline without a live desktop (works on any platform)
+struct SyntheticCaptureSource final : CaptureSource {
+    struct PointerShape {
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO info{};
+        std::vector<uint8_t> data{};
+    };
+    struct Step {
+        std::vector<DXGI_OUTDUPL_MOVE_RECT> moved{}; // applied to the surface first
+        std::vector<DXGI_OUTDUPL_MOVE_RECT> shifted{}; // applied after moved, but never reported (app repainted it)
+        std::vector<RECT> dirty{}; // repainted with a pattern unique to the frame
+        std::vector<RECT> unchanged{}; // reported as dirty as well, but the content stays (like repainted windows)
+        std::optional<Point> pointerPosition{}; // pointer moved
+        bool pointerVisible = true;
+        std::optional<size_t> pointerShape{}; // index into Config::pointerShapes
+        uint32_t frames = 1; // accumulated frames reported
+        bool rectsCoalesced{};
+    };
+    struct Config {
+        Dimension dimension{1920, 1080}; // dimension of the desktop
+        Point desktopTopLeft{};
+        DXGI_MODE_ROTATION rotation{DXGI_MODE_ROTATION_IDENTITY};
+        int64_t ticksPerFrame{166'667}; // clock ticks (100ns) between two frames
+        /// if set, the desktop presents in this interval in real time
+        /// frames accumulate while no frame is acquired (Step::frames is ignored)
+        std::optional<std::chrono::microseconds> presentInterval{};
+        std::vector<Step> script{};
+        std::vector<PointerShape> pointerShapes{};
+        bool loop{}; // restart the script when it is done
+        CapturedUpdatePool *pool{}; // optional provider of the managed buffers
+    };
+    explicit SyntheticCaptureSource(Config config);
+
+    auto init() -> DXGI_OUTPUT_DESC override;
+    auto acquire(Milliseconds timeout) -> std::optional<CapturedUpdate> override;
+    void release() override;
+    bool stage(CapturedUpdate &) override;
+
+    auto stagingStats() const -> core::CaptureStaging::Stats const & { return m_staging.stats(); }
+    auto surface() const -> core::SurfaceView { return m_surface.view(); }
+    auto frameCount() const -> uint64_t { return m_frameCount; }
+    bool isDone() const { return !m_config.loop && m_stepIndex >= m_config.script.size(); }
+
+    /// 32×32 arrow with alpha channel
+    static auto colorArrowShape() -> PointerShape;
+    /// 32×32 I-beam with and & xor mask
+    static auto monochromeBeamShape() -> PointerShape;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    auto awaitPresents(Milliseconds timeout) -> uint32_t;
+    void applyMoves(const Step &);
+    void paintDirty(const Step &);
+
+private:
+    Config m_config;
+    core::Surface m_surface{};
+    size_t m_stepIndex{};
+    uint64_t m_frameCount{};
+    int64_t m_clock{};
+    Clock::time_point m_startTime{};
+    int64_t m_consumedPresents{};
+    core::CaptureStaging m_staging{};
+    std::vector<win32::Rect> m_stagingRects{};
+    std::vector<RECT> m_reportedRects{}; // dirty & unchanged rects of the step
+};
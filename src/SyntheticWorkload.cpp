@@ -0,0 +1,283 @@
+#include "SyntheticWorkload.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+using win32::Rect;
+using Kind = SyntheticWorkload::Kind;
+using Step = SyntheticCaptureSource::Step;
+
+constexpr auto glyph = Dimension{8, 16};
+constexpr auto lineHeight = 20;
+
+struct Random {
+    explicit Random(uint32_t seed)
+        : m_engine{seed} {}
+
+    /// uniform in [low, high]
+    auto uniform(int low, int high) -> int { return std::uniform_int_distribution<int>{low, high}(m_engine); }
+    bool chance(int percent) { return uniform(0, 99) < percent; }
+
+private:
+    std::mt19937 m_engine;
+};
+
+/// rect of an editor or video player with the given fractions of the desktop as margins
+auto insetRect(Dimension desktop, int leftDiv, int topDiv, int rightDiv, int bottomDiv) -> Rect {
+    const auto left = desktop.width / leftDiv;
+    const auto top = desktop.height / topDiv;
+    const auto right = desktop.width - desktop.width / rightDiv;
+    const auto bottom = desktop.height - desktop.height / bottomDiv;
+    return Rect{{left, top}, {std::max(right - left, 1), std::max(bottom - top, 1)}};
+}
+
+/// appends the part of rect inside of the desktop
+void addDirty(Step &step, Dimension desktop, Rect rect) {
+    const auto left = std::max(rect.left(), 0);
+    const auto top = std::max(rect.top(), 0);
+    const auto right = std::min(rect.right(), desktop.width);
+    const auto bottom = std::min(rect.bottom(), desktop.height);
+    if (left < right && top < bottom) step.dirty.push_back(RECT{left, top, right, bottom});
+}
+
+void addMove(Step &step, Point source, Rect destination) {
+    step.moved.push_back({source.toPOINT(), destination.toRECT()});
+}
+
+/// glyphs appear at the caret, the gutter and minimap follow, the line is rehighlighted now and then
+void typing(std::vector<Step> &script, SyntheticWorkload::Params const &params, Random &random) {
+    const auto desktop = params.dimension;
+    const auto editor = insetRect(desktop, 6, 14, 8, 30);
+    const auto columns = std::max(editor.width() / glyph.width, 1);
+    const auto lines = std::max(editor.height() / lineHeight, 1);
+    const auto gutter = Rect{{editor.left() - 5 * glyph.width, editor.top()}, {4 * glyph.width, editor.height()}};
+    const auto minimap = Rect{{editor.right() + 4, editor.top()}, {desktop.width / 16, editor.height()}};
+    auto column = 0;
+    auto line = 0;
+    script.front().pointerShape = 1; // I-beam
+    script.front().pointerPosition = Point{editor.left() + editor.width() / 2, editor.top() + editor.height() / 3};
+    for (auto frame = size_t{}; frame < params.frames; ++frame) {
+        auto &step = script.emplace_back();
+        const auto lineTop = editor.top() + line * lineHeight;
+        const auto typed = random.uniform(1, 2);
+        for (auto i = 0; i < typed && column < columns; ++i, ++column) {
+            addDirty(step, desktop, Rect{{editor.left() + column * glyph.width, lineTop}, glyph});
+        }
+        addDirty(step, desktop, Rect{{editor.left() + column * glyph.width, lineTop}, {2, glyph.height}}); // caret
+        addDirty(step, desktop, Rect{{gutter.left(), lineTop}, {gutter.width(), glyph.height}});
+        addDirty(step, desktop, Rect{{minimap.left(), minimap.top() + line * 2}, {std::min(column, 60), 2}});
+        if (random.chance(5)) {
+            // syntax highlighting repaints the words of the line
+            for (auto x = 0; x < column;) {
+                const auto word = std::min(random.uniform(2, 8), column - x);
+                const auto wordLeft = editor.left() + x * glyph.width;
+                addDirty(step, desktop, Rect{{wordLeft, lineTop}, {word * glyph.width, glyph.height}});
+                x += word + 1;
+            }
+        }
+        if (column >= columns || random.chance(2)) {
+            column = 0;
+            line = (line + 1) % lines;
+        }
+    }
+}
+
+/// wheel gestures of a few frames move the editor content by whole lines
+void scrolling(std::vector<Step> &script, SyntheticWorkload::Params const &params, Random &random) {
+    const auto desktop = params.dimension;
+    const auto editor = insetRect(desktop, 6, 14, 40, 30);
+    const auto scrollbar = Rect{{editor.right(), editor.top()}, {desktop.width / 80 + 1, editor.height()}};
+    const auto maxLines = std::max((editor.height() - 1) / lineHeight, 1);
+    auto isDown = true;
+    auto gestureFrames = 0;
+    auto lines = 1;
+    script.front().pointerShape = 0; // arrow
+    script.front().pointerPosition = Point{editor.left() + editor.width() / 2, editor.top() + editor.height() / 2};
+    for (auto frame = size_t{}; frame < params.frames; ++frame) {
+        if (gestureFrames == 0) {
+            gestureFrames = random.uniform(10, 30);
+            isDown = random.chance(80);
+            lines = std::min(random.uniform(1, 3), maxLines);
+        }
+        gestureFrames--;
+        auto &step = script.emplace_back();
+        const auto delta = lines * lineHeight;
+        const auto kept = Dimension{editor.width(), editor.height() - delta};
+        if (kept.height <= 0) {
+            addDirty(step, desktop, editor); // editor is smaller than the scrolled lines
+        }
+        else if (isDown) {
+            // content moves up, new lines appear at the bottom
+            addMove(step, Point{editor.left(), editor.top() + delta}, Rect{editor.topLeft, kept});
+            addDirty(step, desktop, Rect{{editor.left(), editor.bottom() - delta}, {editor.width(), delta}});
+        }
+        else {
+            addMove(step, editor.topLeft, Rect{{editor.left(), editor.top() + delta}, kept});
+            addDirty(step, desktop, Rect{editor.topLeft, {editor.width(), delta}});
+        }
+        addDirty(step, desktop, scrollbar);
+    }
+}
+
+/// a terminal prints lines, the new line scrolls the content up and the app repaints the entire terminal
+void repaintScrolling(std::vector<Step> &script, SyntheticWorkload::Params const &params, Random &random) {
+    const auto desktop = params.dimension;
+    const auto terminal = insetRect(desktop, 10, 10, 10, 8);
+    const auto columns = std::max(terminal.width() / glyph.width, 1);
+    auto column = 0;
+    script.front().pointerShape = 1; // I-beam
+    script.front().pointerPosition = Point{terminal.left() + terminal.width() / 2, terminal.top()};
+    for (auto frame = size_t{}; frame < params.frames; ++frame) {
+        auto &step = script.emplace_back();
+        const auto lastLine = Rect{{terminal.left(), terminal.bottom() - lineHeight}, {terminal.width(), lineHeight}};
+        if (column >= columns || random.chance(30)) {
+            column = 0;
+            const auto kept = Dimension{terminal.width(), terminal.height() - lineHeight};
+            if (kept.height > 0) {
+                const auto source = Point{terminal.left(), terminal.top() + lineHeight};
+                step.shifted.push_back({source.toPOINT(), Rect{terminal.topLeft, kept}.toRECT()});
+            }
+            addDirty(step, desktop, lastLine); // cleared line
+        }
+        const auto printed = std::min(random.uniform(4, 40), columns - column);
+        const auto textLeft = terminal.left() + column * glyph.width;
+        addDirty(step, desktop, Rect{{textLeft, lastLine.top()}, {printed * glyph.width, glyph.height}});
+        column += printed;
+        step.unchanged.push_back(terminal.toRECT()); // the app repaints everything
+    }
+}
+
+/// a 16:9 video in the center of the desktop presents every frame, the seek bar updates every second
+void video(std::vector<Step> &script, SyntheticWorkload::Params const &params, Random &) {
+    const auto desktop = params.dimension;
+    const auto width = std::max(desktop.width * 2 / 3, 1);
+    const auto height = std::max(std::min(width * 9 / 16, desktop.height * 5 / 6), 1);
+    const auto player = Rect{{(desktop.width - width) / 2, (desktop.height - height) / 2}, {width, height}};
+    const auto seekBar = Rect{{player.left(), player.bottom()}, {player.width(), glyph.height / 2}};
+    for (auto frame = size_t{}; frame < params.frames; ++frame) {
+        auto &step = script.emplace_back();
+        addDirty(step, desktop, player);
+        if (frame % 60 == 59) addDirty(step, desktop, seekBar);
+    }
+}
+
+/// a window is dragged around by its title bar, DWM reports the move and the uncovered background
+void windowDrag(std::vector<Step> &script, SyntheticWorkload::Params const &params, Random &random) {
+    const auto desktop = params.dimension;
+    const auto size = Dimension{std::max(desktop.width / 3, 2), std::max(desktop.height / 3, 2)};
+    auto window = Rect{{desktop.width / 8, desktop.height / 8}, size};
+    auto velocity = Point{random.uniform(4, 12), random.uniform(2, 8)};
+    const auto grab = Point{size.width / 2, std::min(10, size.height - 1)}; // title bar
+    script.front().pointerShape = 0; // arrow
+    for (auto frame = size_t{}; frame < params.frames; ++frame) {
+        // bounce at the desktop edges
+        const auto maxLeft = desktop.width - size.width;
+        const auto maxTop = desktop.height - size.height;
+        if (window.left() + velocity.x < 0 || window.left() + velocity.x > maxLeft) velocity.x = -velocity.x;
+        if (window.top() + velocity.y < 0 || window.top() + velocity.y > maxTop) velocity.y = -velocity.y;
+        const auto dx = std::clamp(velocity.x, -window.left(), maxLeft - window.left());
+        const auto dy = std::clamp(velocity.y, -window.top(), maxTop - window.top());
+        const auto moved = Rect{{window.left() + dx, window.top() + dy}, size};
+
+        auto &step = script.emplace_back();
+        step.pointerPosition = Point{moved.left() + grab.x, moved.top() + grab.y};
+        if (dx == 0 && dy == 0) continue;
+        addMove(step, window.topLeft, moved);
+        // uncovered background - a full width strip for the vertical move and the side strip of the other rows
+        const auto adx = std::min(std::abs(dx), size.width);
+        const auto ady = std::min(std::abs(dy), size.height);
+        const auto rowsTop = dy > 0 ? window.top() + ady : window.top();
+        const auto rowsHeight = size.height - ady;
+        if (ady != 0) {
+            const auto stripTop = dy > 0 ? window.top() : window.bottom() - ady;
+            addDirty(step, desktop, Rect{{window.left(), stripTop}, {size.width, ady}});
+        }
+        if (adx != 0 && rowsHeight > 0) {
+            const auto stripLeft = dx > 0 ? window.left() : window.right() - adx;
+            addDirty(step, desktop, Rect{{stripLeft, rowsTop}, {adx, rowsHeight}});
+        }
+        window = moved;
+    }
+}
+
+/// calm typing sized updates, interrupted by bursts where DXGI coalesced few changed glyphs into large rects
+void coalescedBurst(std::vector<Step> &script, SyntheticWorkload::Params const &params, Random &random) {
+    const auto desktop = params.dimension;
+    const auto randomRect = [&](Dimension minSize, Dimension maxSize) {
+        const auto width = std::min(random.uniform(minSize.width, maxSize.width), desktop.width);
+        const auto height = std::min(random.uniform(minSize.height, maxSize.height), desktop.height);
+        const auto left = random.uniform(0, desktop.width - width);
+        const auto top = random.uniform(0, desktop.height - height);
+        return Rect{{left, top}, {width, height}};
+    };
+    const auto large = Dimension{std::max(desktop.width * 2 / 3, 2), std::max(desktop.height * 2 / 3, 2)};
+    const auto largeMin = Dimension{large.width / 2, large.height / 2};
+    constexpr auto cycle = size_t{40};
+    constexpr auto burst = size_t{8};
+    for (auto frame = size_t{}; frame < params.frames; ++frame) {
+        auto &step = script.emplace_back();
+        if (frame % cycle < burst) {
+            // few glyphs changed inside of each reported rect
+            step.rectsCoalesced = true;
+            const auto count = random.uniform(2, 4);
+            for (auto i = 0; i < count; ++i) {
+                const auto reported = randomRect(largeMin, large);
+                const auto glyphs = random.uniform(1, 6);
+                for (auto g = 0; g < glyphs; ++g) {
+                    const auto left = reported.left() + random.uniform(0, std::max(reported.width() - glyph.width, 0));
+                    const auto top = reported.top() + random.uniform(0, std::max(reported.height() - glyph.height, 0));
+                    addDirty(step, desktop, Rect{{left, top}, glyph});
+                }
+                step.unchanged.push_back(reported.toRECT());
+            }
+        }
+        else {
+            const auto count = random.uniform(1, 3);
+            const auto word = Dimension{4 * glyph.width, glyph.height};
+            for (auto i = 0; i < count; ++i) addDirty(step, desktop, randomRect(glyph, word));
+        }
+    }
+}
+
+} // namespace
+
+auto SyntheticWorkload::name(Kind kind) -> std::string_view {
+    switch (kind) {
+    case Kind::Typing: return "typing";
+    case Kind::Scrolling: return "scrolling";
+    case Kind::RepaintScrolling: return "repaint scrolling";
+    case Kind::Video: return "video";
+    case Kind::WindowDrag: return "window drag";
+    case Kind::CoalescedBurst: return "coalesced burst";
+    }
+    return "unknown";
+}
+
+auto SyntheticWorkload::script(Params const &params) -> std::vector<SyntheticCaptureSource::Step> {
+    auto random = Random{params.seed * 0x9E3779B9u ^ static_cast<uint32_t>(params.kind)};
+    auto script = std::vector<Step>{};
+    script.reserve(params.frames + 1);
+    auto &first = script.emplace_back();
+    addDirty(first, params.dimension, Rect{{}, params.dimension});
+    switch (params.kind) {
+    case Kind::Typing: typing(script, params, random); break;
+    case Kind::Scrolling: scrolling(script, params, random); break;
+    case Kind::RepaintScrolling: repaintScrolling(script, params, random); break;
+    case Kind::Video: video(script, params, random); break;
+    case Kind::WindowDrag: windowDrag(script, params, random); break;
+    case Kind::CoalescedBurst: coalescedBurst(script, params, random); break;
+    }
+    return script;
+}
+
+auto SyntheticWorkload::config(Params const &params) -> SyntheticCaptureSource::Config {
+    return SyntheticCaptureSource::Config{
+        .dimension = params.dimension,
+        .rotation = params.rotation,
+        .script = script(params),
+        .pointerShapes = {SyntheticCaptureSource::colorArrowShape(), SyntheticCaptureSource::monochromeBeamShape()},
+    };
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "SyntheticCaptureSource.h"
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+/// Generates scripts of typical desktop activity for the SyntheticCaptureSource
+/// note:
+/// * the same parameters always generate the same script, so optimizations are compared on equal workloads
+/// * rects are in desktop coordinates, the source applies the rotation
+/// * the first step paints the entire desktop (like the first frame of a duplication)
+struct SyntheticWorkload {
+    enum class Kind {
+        Typing, ///< glyphs and the caret in an IDE, many tiny dirty rects
+        Scrolling, ///< editor scrolls by lines, a large move rect plus the uncovered strip
+        RepaintScrolling, ///< terminal scrolls by repainting, the entire terminal is dirty every frame
+        Video, ///< one large dirty rect every frame
+        WindowDrag, ///< a window follows the pointer, moved window plus the uncovered background
+        CoalescedBurst, ///< bursts of large RectsCoalesced rects with few changes inside between calm typing
+    };
+    static constexpr auto kinds = std::array{
+        Kind::Typing,
+        Kind::Scrolling,
+        Kind::RepaintScrolling,
+        Kind::Video,
+        Kind::WindowDrag,
+        Kind::CoalescedBurst,
+    };
+
+    struct Params {
+        Kind kind{Kind::Typing};
+        Dimension dimension{1920, 1080}; // of the desktop
+        DXGI_MODE_ROTATION rotation{DXGI_MODE_ROTATION_IDENTITY};
+        size_t frames{600}; // steps after the initial full paint (10s at 60 Hz)
+        uint32_t seed{1}; // varies the random parts of the workload
+    };
+
+    static auto name(Kind) -> std::string_view;
+
+    /// all steps of the workload
+    static auto script(Params const &) -> std::vector<SyntheticCaptureSource::Step>;
+
+    /// config of a SyntheticCaptureSource that plays the workload (with pointer shapes, without pool)
+    static auto config(Params const &) -> SyntheticCaptureSource::Config;
+};
@@ -0,0 +1,106 @@
+#include "TraceCaptureSource.h"
+
+#include "CapturedUpdate.h"
+
+#include <cstring>
+#include <thread>
+
+namespace {
+
+using core::SessionTrace;
+using win32::Rect;
+
+bool isSameOutput(SessionTrace::Session const &a, SessionTrace::Session const &b) {
+    return Rect::fromRECT(a.desktop) == Rect::fromRECT(b.desktop) && a.rotation == b.rotation;
+}
+
+} // namespace
+
+TraceCaptureSource::TraceCaptureSource(Config config)
+    : m_config{std::move(config)} {}
+
+auto TraceCaptureSource::init() -> DXGI_OUTPUT_DESC {
+    auto position = m_config.startPosition;
+    if (!m_isOpen) {
+        m_isOpen = m_replayer.open(m_config.path);
+        if (!m_isOpen) throw Expected{"Failed to open session trace"};
+        m_replayer.setPacing(m_config.pacing);
+    }
+    else {
+        // note: after a session change the replay continues with the next output
+        position = m_replayer.isDone() ? 0 : m_replayer.position();
+    }
+    if (updateCount() == 0) throw Expected{"Session trace has no updates"};
+    seek(position);
+    const auto &session = m_replayer.session();
+
+    auto desc = DXGI_OUTPUT_DESC{};
+    std::memcpy(desc.DeviceName, L"Session Trace", sizeof(L"Session Trace"));
+    desc.DesktopCoordinates = session.desktop;
+    desc.AttachedToDesktop = true;
+    desc.Rotation = session.rotation;
+    return desc;
+}
+
+void TraceCaptureSource::seek(size_t position) {
+    if (!m_replayer.seek(position)) throw Expected{"Session trace is damaged"};
+    m_deliverEntireDisplay = true;
+}
+
+auto TraceCaptureSource::acquire(Milliseconds timeout) -> std::optional<CapturedUpdate> {
+    if (m_replayer.isDone()) {
+        if (!m_config.loop) {
+            std::this_thread::sleep_for(timeout); // nothing changes in this trace anymore
+            return {};
+        }
+        const auto session = m_replayer.session();
+        seek(0);
+        if (!isSameOutput(m_replayer.session(), session)) throw Expected{"Session trace output changed"};
+    }
+    if (m_replayer.isSessionChange()) throw Expected{"Session trace output changed"};
+    const auto update = m_replayer.next(timeout);
+    if (!update) {
+        if (m_replayer.isDamaged()) throw Expected{"Session trace is damaged"};
+        return {}; // not due yet
+    }
+
+    auto result = std::optional<CapturedUpdate>{};
+    auto &captured = result.emplace();
+    auto &frame = captured.frame;
+    frame.present_time = update->presentTime;
+    frame.frames = update->frames;
+    frame.rects_coalesced = update->rectsCoalesced;
+    frame.protected_content_masked_out = update->protectedContentMaskedOut;
+    if (m_config.pool) {
+        const auto metadataSize = update->moved.size_bytes() + update->dirty.size_bytes();
+        if (metadataSize != 0) frame.buffer = m_config.pool->metadata.take(metadataSize);
+    }
+    if (m_deliverEntireDisplay) {
+        const auto display = Rect{{}, Rect::fromRECT(m_replayer.session().desktop).dimension};
+        frame.replaceRects({}, {&display, 1});
+    }
+    else {
+        frame.assignRects(update->moved, update->dirty);
+    }
+    if (update->hasImage || m_deliverEntireDisplay) frame.cpuImage = m_replayer.image();
+
+    auto &pointer = captured.pointer;
+    pointer.update_time = update->pointerUpdateTime;
+    pointer.position = update->pointerPosition;
+    const auto &replayed = m_replayer.pointer();
+    if (!update->shape.empty() || (m_deliverEntireDisplay && !replayed.shape.empty())) {
+        // note: after a seek the last recorded shape is delivered
+        const auto shape = update->shape.empty() ? replayed.shape : update->shape;
+        pointer.shape_info = update->shape.empty() ? replayed.shapeInfo : update->shapeInfo;
+        if (m_config.pool) pointer.shape_buffer = m_config.pool->shapes.take(shape.size());
+        pointer.shape_buffer.assign(shape.begin(), shape.end());
+    }
+    if (m_deliverEntireDisplay && pointer.update_time == 0) {
+        pointer.update_time = 1; // deliver the replayed position
+        pointer.position = replayed.position;
+    }
+    m_deliverEntireDisplay = false;
+    return result;
+}
+
+void TraceCaptureSource::release() {}
@@ -0,0 +1,47 @@
+#pragma once
+#include "CaptureSource.h"
+
+#include "core/SessionReplayer.h"
+#include "core/Surface.h"
+
+#include <filesystem>
+#include <stddef.h>
+
+struct CapturedUpdatePool;
+
+/// Capture source that replays a session trace recorded by the SessionRecorder
+/// note:
+/// * works on any platform, the replayed image is delivered as cpuImage
+/// * the first update after init() or seek() covers the entire display
+/// * if the recorded output changes acquire() throws Expected, the next init() continues with the new output
+struct TraceCaptureSource final : CaptureSource {
+    using Pacing = core::SessionReplayer::Pacing;
+    struct Config {
+        std::filesystem::path path{};
+        bool loop{}; // restart the replay when the trace is done
+        Pacing pacing{Pacing::AsFastAsPossible};
+        size_t startPosition{}; // index of the first replayed update
+        CapturedUpdatePool *pool{}; // optional provider of the managed buffers
+    };
+    explicit TraceCaptureSource(Config config);
+
+    auto init() -> DXGI_OUTPUT_DESC override;
+    auto acquire(Milliseconds timeout) -> std::optional<CapturedUpdate> override;
+    void release() override;
+
+    /// continue the replay at position (keyframes make this fast)
+    /// note: call from the thread that acquires
+    void seek(size_t position);
+
+    auto surface() const -> core::SurfaceView { return m_replayer.image(); }
+    auto updateCount() const -> size_t { return m_replayer.updateCount(); }
+    bool isComplete() const { return m_replayer.isComplete(); } ///< trace has an index (recording was finished)
+    bool isDone() const { return !m_config.loop && m_replayer.isDone(); }
+    auto replayer() const -> core::SessionReplayer const & { return m_replayer; }
+
+private:
+    Config m_config;
+    core::SessionReplayer m_replayer{};
+    bool m_isOpen{};
+    bool m_deliverEntireDisplay{};
+};
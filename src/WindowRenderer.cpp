@@ -3,22 +3,34 @@
 
 #include "renderer.h"
 
+#include "CapturedUpdate.h"
+#include "FrameContext.h"
 #include "MaskedPixelShader.h"
 
+#include "core/FrameTrace.h"
+
 #include <array>
+#include <utility>
 
 using Error = renderer::Error;
 using win32::Rect;
 
 WindowRenderer::WindowRenderer(const Args &config)
-    : m_args{config} {}
+    : m_args{config} {
+    auto frequency = LARGE_INTEGER{};
+    if (QueryPerformanceFrequency(&frequency)) m_ticksPerSecond = frequency.QuadPart;
+}
 
 void WindowRenderer::init(InitArgs &&args) {
     m_dx.emplace(std::move(args));
     m_size = args.windowDimension;
 }
 
-void WindowRenderer::reset() noexcept { m_dx.reset(); }
+void WindowRenderer::reset() noexcept {
+    m_dx.reset();
+    m_damage.invalidate();
+    m_pointerOutputRect = {};
+}
 
 auto WindowRenderer::frameLatencyWaitable() -> Handle {
     return Handle{m_dx->swapChain->GetFrameLatencyWaitableObject()};
@@ -35,12 +47,40 @@ void WindowRenderer::zoomOutput(float zoom) noexcept { m_args.outputZoom = zoom;
 
 void WindowRenderer::updateOffset(Vec2f offset) noexcept { m_args.captureOffset = offset; }
 
+void WindowRenderer::addFrameDamage(const FrameUpdate &update, const FrameContext &context) {
+    if (m_pendingPresentTime == 0) m_pendingPresentTime = update.present_time;
+    const auto mapping = core::CaptureMapping{
+        .rotation = context.output_desc.Rotation,
+        .desktop = Rect::fromRECT(context.output_desc.DesktopCoordinates),
+        .offset = context.offset,
+    };
+    m_damage.addCaptured(update.moved(), update.dirty(), mapping);
+    if (!update.moved().empty() || !update.dirty().empty()) m_hasFrameDamage = true;
+}
+
 void WindowRenderer::render() {
+    FRAME_TRACE_SCOPE(Render);
     try {
-        renderBlack();
-        renderFrame();
-        renderPointer();
-        swap();
+        m_damage.setOutputMapping({m_args.outputZoom, m_args.captureOffset, m_size});
+        if (m_pendingResizeBuffers) m_damage.invalidate();
+        addPointerDamage();
+
+        const auto present = m_damage.present();
+        if (present.isFull) {
+            renderBlack();
+            renderFrame();
+            renderPointer();
+            swap();
+            m_fullFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (!present.dirty.empty()) {
+            renderDamaged(present.redraw);
+            swapDamaged(present.dirty);
+            m_partialFrames.fetch_add(1, std::memory_order_relaxed);
+            if (!m_hasFrameDamage) m_pointerFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_hasFrameDamage = false;
+        recordPresentLatency(present.isFull || !present.dirty.empty());
     }
     catch (...) {
         m_args.setErrorCallback(m_args.callbackPtr, std::current_exception());
@@ -108,10 +148,98 @@ void WindowRenderer::swap() {
     auto const &dx = *m_dx;
     dx.activateNoRenderTarget();
 
+    FRAME_TRACE_SCOPE(Present);
     auto const result = dx.swapChain->Present(1, 0);
     if (IS_ERROR(result)) throw Error{result, "Failed to swap buffers"};
 }
 
+/// render background and pointer clipped to the rects
+void WindowRenderer::renderDamaged(std::span<const Rect> rects) {
+    auto &dx = *m_dx;
+    const auto black = BaseRenderer::Color{0, 0, 0, 0};
+    dx.activateScissorRasterizerState();
+    for (const auto &rect : rects) {
+        const auto scissor = rect.toRECT();
+        dx.deviceContext1->ClearView(dx.renderTarget.Get(), black.data(), &scissor, 1);
+        dx.deviceContext()->RSSetScissorRects(1, &scissor);
+        renderFrame();
+        renderPointer();
+    }
+    dx.activateDefaultRasterizerState();
+}
+
+/// present with the rects that changed since the last present
+void WindowRenderer::swapDamaged(std::span<const Rect> rects) {
+    auto const &dx = *m_dx;
+    dx.activateNoRenderTarget();
+
+    m_presentRects.clear();
+    for (const auto &rect : rects) m_presentRects.push_back(rect.toRECT());
+    auto parameters = DXGI_PRESENT_PARAMETERS{
+        .DirtyRectsCount = static_cast<UINT>(m_presentRects.size()),
+        .pDirtyRects = m_presentRects.data(),
+        .pScrollRect = nullptr,
+        .pScrollOffset = nullptr,
+    };
+    FRAME_TRACE_SCOPE(Present);
+    auto const result = dx.swapChain->Present1(1, 0, &parameters);
+    if (IS_ERROR(result)) throw Error{result, "Failed to swap buffers"};
+}
+
+/// old and new pointer footprints are damaged if the pointer moved or changed its shape
+void WindowRenderer::addPointerDamage() {
+    const auto &pointer = m_args.pointerBuffer;
+    if (pointer.position_timestamp != m_lastPointerTime) {
+        if (m_pendingPointerTime == 0) m_pendingPointerTime = pointer.position_timestamp;
+        m_lastPointerTime = pointer.position_timestamp;
+    }
+    const auto shapeChanged = pointer.shape_timestamp != m_lastPointerShapeUpdate;
+    const auto pointerRect = pointerOutputRect(pointer);
+    if (!shapeChanged && pointerRect == m_pointerOutputRect) return;
+    m_damage.addOutput(m_pointerOutputRect);
+    m_damage.addOutput(pointerRect);
+    m_pointerOutputRect = pointerRect;
+}
+
+/// latency from the DXGI timestamps to the return of Present (the frame is queued for the next vertical blank)
+/// note: changes that did not reach the window are dropped
+void WindowRenderer::recordPresentLatency(bool presented) {
+    const auto presentTime = std::exchange(m_pendingPresentTime, 0);
+    const auto pointerTime = static_cast<int64_t>(std::exchange(m_pendingPointerTime, 0));
+    if (!presented || m_ticksPerSecond <= 0) return;
+
+    auto now = LARGE_INTEGER{};
+    QueryPerformanceCounter(&now);
+    const auto record = [&](core::LatencyHistogram &histogram, int64_t time) {
+        if (time <= 0 || time > now.QuadPart) return;
+        histogram.record(static_cast<uint64_t>((now.QuadPart - time) * 1'000'000 / m_ticksPerSecond));
+    };
+    record(m_captureLatency, presentTime);
+    record(m_pointerLatency, pointerTime);
+}
+
+auto WindowRenderer::presentLatencyCsv() const -> std::string {
+    return "histogram,value_us,count,percentile\n" + m_captureLatency.toCsv("capture") +
+           m_pointerLatency.toCsv("pointer");
+}
+
+void WindowRenderer::resetPresentLatency() noexcept {
+    m_captureLatency.reset();
+    m_pointerLatency.reset();
+}
+
+/// footprint of the pointer in window coordinates (empty if the pointer is not rendered)
+auto WindowRenderer::pointerOutputRect(const PointerBuffer &pointer) const -> Rect {
+    if (pointer.position_timestamp == 0 || !pointer.visible) return {};
+    const auto isMonochrome = pointer.shape_info.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME;
+    const auto height = isMonochrome ? pointer.shape_info.Height / 2 : pointer.shape_info.Height;
+    const auto targetRect = Rect{
+        Point{pointer.position.x, pointer.position.y},
+        Dimension{static_cast<int>(pointer.shape_info.Width), static_cast<int>(height)},
+    };
+    return core::toOutputRect(targetRect, m_damage.outputMapping());
+}
+
 void WindowRenderer::resizeSwapBuffer() {
     auto const &dx = *m_dx;
     auto description = DXGI_SWAP_CHAIN_DESC{};
@@ -143,9 +271,21 @@ void WindowRenderer::updatePointerShape(const PointerBuffer &pointer) {
     if (pointer.shape_timestamp == m_lastPointerShapeUpdate) return;
     m_lastPointerShapeUpdate = pointer.shape_timestamp;
 
+    auto &dx = *m_dx;
+    if (const auto *cached = dx.pointerShapes.find(pointer.shape_key); cached) {
+        dx.pointerTexture = cached->texture;
+        dx.pointerTextureShaderResource = cached->shaderResource;
+        m_pointerShapeHits.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_pointerShapeMisses.fetch_add(1, std::memory_order_relaxed);
+
+    const auto shape = m_pointerShapeConverter.convert(pointer.shape_info, pointer.shape_data);
+    if (!shape) return; // keep the previous shape
+
     auto texture_description = D3D11_TEXTURE2D_DESC{
-        .Width = pointer.shape_info.Width,
-        .Height = pointer.shape_info.Height,
+        .Width = static_cast<UINT>(shape.dimension.width),
+        .Height = static_cast<UINT>(shape.dimension.height),
         .MipLevels = 1,
         .ArraySize = 1,
         .Format = DXGI_FORMAT_B8G8R8A8_UNORM,
@@ -160,37 +300,10 @@ void WindowRenderer::updatePointerShape(const PointerBuffer &pointer) {
         .MiscFlags = 0,
     };
     auto resource_data = D3D11_SUBRESOURCE_DATA{
-        .pSysMem = pointer.shape_data.data(),
-        .SysMemPitch = pointer.shape_info.Pitch,
+        .pSysMem = shape.data,
+        .SysMemPitch = static_cast<UINT>(shape.pitch),
         .SysMemSlicePitch = 0,
     };
-
-    // convert monochrome to masked colors
-    using Color = std::array<uint8_t, 4>;
-    auto tmpData = std::vector<Color>{};
-    if (pointer.shape_info.Type == DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME) {
-        auto const width = texture_description.Width;
-        auto const height = texture_description.Height >> 1;
-        auto const pitch = pointer.shape_info.Pitch;
-        auto const xor_offset = static_cast<size_t>(height) * pitch;
-        tmpData.resize(static_cast<size_t>(width) * height);
-        for (auto row = size_t{}; row < height; ++row) {
-            for (auto col = 0u; col < width; ++col) {
-                auto const mask = 0x80 >> (col & 7);
-                auto const addr = (col >> 3) + (row * pitch);
-                auto const and_mask = pointer.shape_data[addr] & mask;
-                auto const xor_mask = pointer.shape_data[addr + xor_offset] & mask;
-                auto const pixel = and_mask
-                                       ? (xor_mask ? Color{{0xFF, 0xFF, 0xFF, 0xFF}} : Color{{0x00, 0x00, 0x00, 0xFF}})
-                                       : (xor_mask ? Color{{0xFF, 0xFF, 0xFF, 0x00}} : Color{{0x00, 0x00, 0x00, 0x00}});
-                tmpData[row * width + col] = pixel;
-            }
-        }
-
-        texture_description.Height = height;
-        resource_data.pSysMem = tmpData.data();
-        resource_data.SysMemPitch = width * sizeof(Color);
-    }
     //{
     //	auto width = texture_description.Width;
     //	auto height = texture_description.Height;
@@ -215,7 +328,6 @@ void WindowRenderer::updatePointerShape(const PointerBuffer &pointer) {
     //	}
     //}
 
-    auto &dx = *m_dx;
     auto result = dx.device()->CreateTexture2D(&texture_description, &resource_data, &dx.pointerTexture);
     if (IS_ERROR(result)) throw Error{result, "Failed to create texture 2d"};
 
@@ -231,6 +343,8 @@ void WindowRenderer::updatePointerShape(const PointerBuffer &pointer) {
     result = dx.device()->CreateShaderResourceView(
         dx.pointerTexture.Get(), &shader_resource_description, &dx.pointerTextureShaderResource);
     if (IS_ERROR(result)) throw Error{result, "Failed to create pointer shader resource"};
+
+    dx.pointerShapes.insert(pointer.shape_key, {dx.pointerTexture, dx.pointerTextureShaderResource});
 }
 
 void WindowRenderer::updatePointerVertices(const PointerBuffer &pointer) {
@@ -287,6 +401,10 @@ WindowRenderer::Resources::Resources(WindowRenderer::InitArgs &&args)
     createMaskedPixelShader();
     createLinearSamplerState();
     createPointerVertexBuffer();
+    createScissorRasterizerState();
+
+    auto const result = deviceContext()->QueryInterface(__uuidof(ID3D11DeviceContext1), &deviceContext1);
+    if (IS_ERROR(result)) throw Error{result, "Failed to get device context 1"};
 }
 
 void WindowRenderer::Resources::createBackgroundTextureShaderResource() {
@@ -359,3 +477,20 @@ void WindowRenderer::Resources::createPointerVertexBuffer() {
     auto const result = device()->CreateBuffer(&buffer_description, nullptr, &pointerVertexBuffer);
     if (IS_ERROR(result)) throw Error{result, "Failed to create vertex buffer"};
 }
+
+void WindowRenderer::Resources::createScissorRasterizerState() {
+    auto const description = D3D11_RASTERIZER_DESC{
+        .FillMode = D3D11_FILL_SOLID,
+        .CullMode = D3D11_CULL_BACK,
+        .FrontCounterClockwise = FALSE,
+        .DepthBias = 0,
+        .DepthBiasClamp = 0.0f,
+        .SlopeScaledDepthBias = 0.0f,
+        .DepthClipEnable = TRUE,
+        .ScissorEnable = TRUE,
+        .MultisampleEnable = FALSE,
+        .AntialiasedLineEnable = FALSE,
+    };
+    auto const result = device()->CreateRasterizerState(&description, &scissorRasterizerState);
+    if (IS_ERROR(result)) throw Error{result, "Failed to create scissor rasterizer state"};
+}
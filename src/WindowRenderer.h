@@ -1,17 +1,29 @@
 #pragma once
 #include "BaseRenderer.h"
+#include "core/DamageTracker.h"
+#include "core/LatencyHistogram.h"
+#include "core/LruCache.h"
+#include "core/PointerShape.h"
 #include "win32/Geometry.h"
 #include "win32/Handle.h"
 
+#include <d3d11_1.h>
 #include <dxgi1_3.h>
 
+#include <atomic>
 #include <optional>
+#include <span>
+#include <string>
+#include <vector>
 
+struct FrameContext;
+struct FrameUpdate;
 struct PointerBuffer;
 
 using win32::Dimension;
 using win32::Handle;
 using win32::Point;
+using win32::Rect;
 using win32::Vec2f;
 
 // manages state how to render background & pointer to output window
@@ -42,6 +54,15 @@ struct WindowRenderer {
         ComPtr<ID3D11Texture2D> texture{}; // texture is rendered as quad
     };
     using Vertex = BaseRenderer::Vertex;
+    struct RenderStats {
+        uint64_t fullFrames{}; ///< everything was rendered and presented
+        uint64_t partialFrames{}; ///< only damaged rects were rendered and presented
+        uint64_t pointerFrames{}; ///< partial frames where only the pointer moved or changed its shape
+    };
+    struct PointerShapeStats {
+        uint64_t hits{}; ///< shape resources were taken from the cache
+        uint64_t misses{}; ///< shape was converted and resources created
+    };
 
     WindowRenderer(Args const &);
 
@@ -57,13 +78,46 @@ struct WindowRenderer {
     void updateOffset(Vec2f offset) noexcept;
     void updateHideFrame(bool) noexcept;
 
+    /// window rects changed by the frame update are rendered with the next render()
+    void addFrameDamage(const FrameUpdate &, const FrameContext &);
+    /// renders and presents everything damaged since the last render
     void render();
 
+    /// note: thread safe
+    auto renderStats() const noexcept -> RenderStats {
+        return {
+            m_fullFrames.load(std::memory_order_relaxed),
+            m_partialFrames.load(std::memory_order_relaxed),
+            m_pointerFrames.load(std::memory_order_relaxed),
+        };
+    }
+    /// note: thread safe
+    auto pointerShapeStats() const noexcept -> PointerShapeStats {
+        return {
+            m_pointerShapeHits.load(std::memory_order_relaxed),
+            m_pointerShapeMisses.load(std::memory_order_relaxed),
+        };
+    }
+    /// note: thread safe
+    auto presentLatency() const noexcept -> core::PresentLatency {
+        return {m_captureLatency.summary(), m_pointerLatency.summary()};
+    }
+    /// all latency histogram buckets as csv
+    /// note: thread safe
+    auto presentLatencyCsv() const -> std::string;
+    /// note: call on the render thread
+    void resetPresentLatency() noexcept;
+
 private:
     void renderBlack();
     void renderFrame();
     void renderPointer();
     void swap();
+    void renderDamaged(std::span<const Rect> rects);
+    void swapDamaged(std::span<const Rect> rects);
+    void addPointerDamage();
+    void recordPresentLatency(bool presented);
+    auto pointerOutputRect(const PointerBuffer &pointer) const -> Rect;
 
     void resizeSwapBuffer();
     void setViewPort();
@@ -78,7 +132,31 @@ private:
 
     bool m_pendingResizeBuffers = false;
 
+    core::DamageTracker m_damage{};
+    Rect m_pointerOutputRect{}; ///< footprint of the pointer in the last presented frame
+    std::vector<RECT> m_presentRects{};
+    bool m_hasFrameDamage = false; ///< captured frames were added since the last render
+    std::atomic<uint64_t> m_fullFrames{};
+    std::atomic<uint64_t> m_partialFrames{};
+    std::atomic<uint64_t> m_pointerFrames{};
+
+    int64_t m_ticksPerSecond{}; // of the performance counter used by DXGI timestamps
+    int64_t m_pendingPresentTime{}; // oldest desktop present that waits for the window present
+    uint64_t m_pendingPointerTime{}; // oldest pointer update that waits for the window present
+    uint64_t m_lastPointerTime{};
+    core::LatencyHistogram m_captureLatency{};
+    core::LatencyHistogram m_pointerLatency{};
+
     uint64_t m_lastPointerShapeUpdate = 0;
+    core::PointerShapeConverter m_pointerShapeConverter{};
+    std::atomic<uint64_t> m_pointerShapeHits{};
+    std::atomic<uint64_t> m_pointerShapeMisses{};
+
+    struct PointerShapeResources {
+        ComPtr<ID3D11Texture2D> texture{};
+        ComPtr<ID3D11ShaderResourceView> shaderResource{};
+    };
+    static constexpr auto pointerShapeCacheSize = size_t{8};
     uint64_t m_lastPointerPositionUpdate = 0;
 
     struct Resources : BaseRenderer {
@@ -91,6 +169,7 @@ private:
         void createMaskedPixelShader();
         void createLinearSamplerState();
         void createPointerVertexBuffer();
+        void createScissorRasterizerState();
 
     public:
         void createRenderTarget();
@@ -107,6 +186,9 @@ private:
             deviceContext()->IASetVertexBuffers(0, 1, backgroundVertexBuffer.GetAddressOf(), &stride, &offset);
         }
 
+        void activateScissorRasterizerState() const { deviceContext()->RSSetState(scissorRasterizerState.Get()); }
+        void activateDefaultRasterizerState() const { deviceContext()->RSSetState(nullptr); }
+
         void activateMaskedPixelShader() const { deviceContext()->PSSetShader(maskedPixelShader.Get(), nullptr, 0); }
         void activatePointerTexture(int index = 0) {
             deviceContext()->PSSetShaderResources(index, 1, pointerTextureShaderResource.GetAddressOf());
@@ -124,6 +206,8 @@ private:
         ComPtr<ID3D11ShaderResourceView> backgroundTextureShaderResource{};
         ComPtr<ID3D11Buffer> backgroundVertexBuffer{};
         ComPtr<IDXGISwapChain2> swapChain{};
+        ComPtr<ID3D11DeviceContext1> deviceContext1{}; // allows to clear rects
+        ComPtr<ID3D11RasterizerState> scissorRasterizerState{};
         ComPtr<ID3D11RenderTargetView> renderTarget{};
         ComPtr<ID3D11PixelShader> maskedPixelShader{};
         ComPtr<ID3D11SamplerState> linearSamplerState{};
@@ -131,6 +215,7 @@ private:
         ComPtr<ID3D11Texture2D> pointerTexture{};
         ComPtr<ID3D11ShaderResourceView> pointerTextureShaderResource{};
         ComPtr<ID3D11Buffer> pointerVertexBuffer{};
+        core::LruCache<core::PointerShapeKey, PointerShapeResources> pointerShapes{pointerShapeCacheSize};
     };
 
     std::optional<Resources> m_dx{};
@@ -0,0 +1,32 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+
+namespace core {
+
+/// timeout for blocking waits that adapts to activity
+/// * every result resets to the short timeout (bursts keep the thread responsive)
+/// * every timeout doubles the next timeout up to the long timeout (idle saves wakeups)
+struct AdaptiveTimeout {
+    using Milliseconds = std::chrono::milliseconds;
+    struct Config {
+        Milliseconds shortTimeout{8};
+        Milliseconds longTimeout{128};
+    };
+
+    AdaptiveTimeout() = default;
+    explicit AdaptiveTimeout(Config config)
+        : m_config{config}
+        , m_current{config.shortTimeout} {}
+
+    auto current() const -> Milliseconds { return m_current; }
+
+    void onResult() { m_current = m_config.shortTimeout; }
+    void onTimeout() { m_current = std::min(m_current * 2, m_config.longTimeout); }
+
+private:
+    Config m_config{};
+    Milliseconds m_current{m_config.shortTimeout};
+};
+
+} // namespace core
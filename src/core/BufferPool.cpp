@@ -0,0 +1,46 @@
+#include "BufferPool.h"
+
+#include <algorithm>
+
+namespace core {
+
+BufferPool::BufferPool(size_t capacity, size_t reserveBytes) {
+    m_free.reserve(capacity);
+    for (auto i = size_t{}; i < capacity; ++i) {
+        m_free.emplace_back().reserve(reserveBytes);
+    }
+}
+
+auto BufferPool::take(size_t size) -> Buffer {
+    auto buffer = Buffer{};
+    {
+        auto lock = std::lock_guard{m_mutex};
+        // prefer the smallest buffer that fits to keep big ones for big requests
+        auto best = m_free.end();
+        for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+            if (it->capacity() < size) continue;
+            if (best == m_free.end() || it->capacity() < best->capacity()) best = it;
+        }
+        if (best == m_free.end() && !m_free.empty()) {
+            const auto byCapacity = [](const Buffer &a, const Buffer &b) { return a.capacity() < b.capacity(); };
+            best = std::max_element(m_free.begin(), m_free.end(), byCapacity);
+        }
+        if (best != m_free.end()) {
+            std::swap(*best, m_free.back());
+            buffer = std::move(m_free.back());
+            m_free.pop_back();
+        }
+    }
+    (buffer.capacity() >= size ? m_hits : m_misses)++;
+    buffer.resize(size);
+    return buffer;
+}
+
+void BufferPool::give(Buffer &&buffer) noexcept {
+    if (buffer.capacity() == 0) return;
+    auto lock = std::lock_guard{m_mutex};
+    if (m_free.size() == m_free.capacity()) return; // full - buffer is freed by caller
+    m_free.push_back(std::move(buffer));
+}
+
+} // namespace core
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+/// Bounded pool of byte buffers that are handed from one thread to another and back
+/// note: after the warm up no heap allocations happen as long as the buffers are returned
+struct BufferPool {
+    using Buffer = std::vector<uint8_t>;
+    struct Stats {
+        uint64_t hits{}; ///< buffer was taken from the pool
+        uint64_t misses{}; ///< buffer had to be allocated
+    };
+
+    /// pool of capacity buffers that are all reserved with reserveBytes
+    explicit BufferPool(size_t capacity, size_t reserveBytes);
+
+    /// returns a buffer with size bytes
+    /// note: thread safe
+    auto take(size_t size) -> Buffer;
+
+    /// hand a buffer back to the pool (dropped if the pool is full)
+    /// note: thread safe
+    void give(Buffer &&) noexcept;
+
+    auto stats() const noexcept -> Stats { return {m_hits.load(), m_misses.load()}; }
+
+private:
+    std::mutex m_mutex;
+    std::vector<Buffer> m_free; // capacity is reserved up front
+    std::atomic<uint64_t> m_hits{};
+    std::atomic<uint64_t> m_misses{};
+};
+
+} // namespace core
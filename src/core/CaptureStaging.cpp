@@ -0,0 +1,26 @@
+#include "CaptureStaging.h"
+
+#include "PixelCopy.h"
+
+namespace core {
+
+auto CaptureStaging::stage(SurfaceView image, std::span<const Rect> dirty) -> SurfaceView {
+    const auto start = std::chrono::steady_clock::now();
+    auto &surface = m_surfaces[m_next];
+    m_next = (m_next + 1) % m_surfaces.size();
+    if (surface.dimension() != image.dimension) surface = Surface{image.dimension};
+
+    auto target = surface.span();
+    auto bytes = uint64_t{};
+    for (const auto &rect : dirty) {
+        copyRect(image, rect, target, rect.topLeft);
+        bytes += static_cast<uint64_t>(rect.width()) * rect.height() * bytesPerPixel;
+    }
+
+    m_stats.frames++;
+    m_stats.copiedBytes += bytes;
+    m_stats.copyTime += std::chrono::steady_clock::now() - start;
+    return surface.view();
+}
+
+} // namespace core
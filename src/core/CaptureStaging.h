@@ -0,0 +1,34 @@
+#pragma once
+#include "Surface.h"
+
+#include <array>
+#include <chrono>
+#include <span>
+#include <stdint.h>
+
+namespace core {
+
+/// Double buffered copy of the dirty regions of captured images
+/// note:
+/// * allows to release a captured frame before it is consumed
+/// * only the dirty regions of the returned view are valid (this is all a consumer reads)
+/// * the view stays valid until stage is called twice more
+struct CaptureStaging {
+    struct Stats {
+        uint64_t frames{};
+        uint64_t copiedBytes{};
+        std::chrono::nanoseconds copyTime{};
+    };
+
+    /// copy the dirty rects (in image coordinates) of image into the next staging surface
+    auto stage(SurfaceView image, std::span<const Rect> dirty) -> SurfaceView;
+
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    std::array<Surface, 2> m_surfaces{};
+    size_t m_next{};
+    Stats m_stats{};
+};
+
+} // namespace core
@@ -0,0 +1,96 @@
+#include "DamageTracker.h"
+
+#include "Rotation.h"
+#include "VisibleAreaCuller.h"
+
+#include <cmath>
+#include <utility>
+
+namespace core {
+
+namespace {
+
+bool isEmpty(Rect const &rect) { return rect.width() <= 0 || rect.height() <= 0; }
+
+} // namespace
+
+auto toTargetRect(Rect desktopRect, CaptureMapping const &mapping) -> Rect {
+    const auto rect = rotate(desktopRect, mapping.rotation, mapping.desktop.dimension);
+    return Rect{
+        Point{
+            rect.left() + mapping.desktop.left() - mapping.offset.x,
+            rect.top() + mapping.desktop.top() - mapping.offset.y,
+        },
+        rect.dimension,
+    };
+}
+
+auto toOutputRect(Rect targetRect, OutputMapping const &mapping) -> Rect {
+    const auto zoom = mapping.zoom;
+    const auto x = static_cast<float>(targetRect.left()) + mapping.offset.x;
+    const auto y = static_cast<float>(targetRect.top()) + mapping.offset.y;
+    const auto left = static_cast<int>(std::floor(x * zoom)) - 1;
+    const auto top = static_cast<int>(std::floor(y * zoom)) - 1;
+    const auto right = static_cast<int>(std::ceil((x + static_cast<float>(targetRect.width())) * zoom)) + 1;
+    const auto bottom = static_cast<int>(std::ceil((y + static_cast<float>(targetRect.height())) * zoom)) + 1;
+    const auto rect = Rect::fromPOINTS({left, top}, {right, bottom});
+    return intersect(rect, Rect{{}, mapping.window}).value_or(Rect{});
+}
+
+void DamageTracker::setOutputMapping(OutputMapping const &mapping) {
+    if (mapping == m_mapping) return;
+    m_mapping = mapping;
+    m_isFull = true;
+}
+
+void DamageTracker::addCaptured(
+    std::span<const MoveRect> moved, std::span<const RECT> dirty, CaptureMapping const &mapping) {
+    if (m_isFull) return; // everything is damaged anyways
+    for (const auto &move : moved) addTarget(toTargetRect(Rect::fromRECT(move.DestinationRect), mapping));
+    for (const auto &rect : dirty) addTarget(toTargetRect(Rect::fromRECT(rect), mapping));
+}
+
+void DamageTracker::addTarget(Rect targetRect) {
+    if (m_isFull || isEmpty(targetRect)) return;
+    addOutput(toOutputRect(targetRect, m_mapping));
+}
+
+void DamageTracker::addOutput(Rect outputRect) {
+    if (m_isFull || isEmpty(outputRect)) return;
+    m_damage.push_back(outputRect);
+}
+
+auto DamageTracker::present() -> Present {
+    if (!m_isFull && m_damage.empty()) return {}; // nothing to present
+
+    auto result = Present{.isFull = true};
+    if (!m_isFull && !m_wasFull) {
+        const auto dirty = m_dirtyCoalescer.coalesce(m_damage);
+        m_redraw.assign(dirty.begin(), dirty.end());
+        m_redraw.insert(m_redraw.end(), m_lastDamage.begin(), m_lastDamage.end());
+        const auto redraw = m_redrawCoalescer.coalesce(m_redraw);
+
+        auto redrawArea = int64_t{};
+        for (const auto &rect : redraw) redrawArea += area(rect);
+        const auto windowArea = area(Rect{{}, m_mapping.window});
+        if (redraw.size() <= m_config.maxRects && redrawArea * 100 <= windowArea * m_config.areaPercent) {
+            result = Present{.isFull = false, .redraw = redraw, .dirty = dirty};
+            m_stats.redrawArea += redrawArea;
+        }
+    }
+    if (result.isFull) {
+        m_stats.fullPresents++;
+    }
+    else {
+        m_stats.partialPresents++;
+    }
+
+    // the next back buffer misses the damage of this present
+    m_wasFull = m_isFull;
+    m_isFull = false;
+    std::swap(m_lastDamage, m_damage);
+    m_damage.clear();
+    return result;
+}
+
+} // namespace core
@@ -0,0 +1,104 @@
+#pragma once
+#include "RectCoalescer.h"
+
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+using win32::Dimension;
+using win32::Point;
+using win32::Rect;
+using win32::Vec2f;
+
+/// placement of a captured output inside the target texture
+struct CaptureMapping {
+    DXGI_MODE_ROTATION rotation{DXGI_MODE_ROTATION_IDENTITY};
+    Rect desktop{}; ///< desktop coordinates of the captured output
+    Point offset{}; ///< offset from desktop to target coordinates
+};
+
+/// placement of the target texture inside the output window
+struct OutputMapping {
+    float zoom{1.0f};
+    Vec2f offset{}; ///< capture offset in target pixels
+    Dimension window{};
+
+    bool operator==(OutputMapping const &o) const {
+        return zoom == o.zoom && offset.x == o.offset.x && offset.y == o.offset.y && window == o.window;
+    }
+};
+
+/// rect of the target texture that shows the desktop rect
+auto toTargetRect(Rect desktopRect, CaptureMapping const &) -> Rect;
+
+/// window rect that shows the target rect
+/// note: grows by one pixel for texture filtering and is clipped to the window (empty if invisible)
+auto toOutputRect(Rect targetRect, OutputMapping const &) -> Rect;
+
+/// Collects the rects of the output window that changed since the last present
+/// note:
+/// * damage accumulates over all updates until it is taken with present()
+/// * a flip model back buffer holds the frame before the last present, so the damage of the last present is
+///   redrawn as well
+/// * everything is redrawn when the damage gets too fragmented or too large
+struct DamageTracker {
+    using MoveRect = DXGI_OUTDUPL_MOVE_RECT;
+    struct Config {
+        size_t maxRects{16}; ///< more redraw rects are not worth the draw calls
+        int areaPercent{60}; ///< more redraw area is not worth the scissoring
+    };
+    struct Present {
+        bool isFull{}; ///< whole window has to be rendered and presented
+        std::span<const Rect> redraw{}; ///< window rects that have to be rendered
+        std::span<const Rect> dirty{}; ///< window rects that changed with this present
+    };
+    struct Stats {
+        uint64_t fullPresents{};
+        uint64_t partialPresents{};
+        int64_t redrawArea{}; ///< pixels rendered by partial presents
+    };
+
+    DamageTracker() = default;
+    explicit DamageTracker(Config config)
+        : m_config{config} {}
+
+    /// a different mapping damages the whole window
+    void setOutputMapping(OutputMapping const &);
+    auto outputMapping() const -> OutputMapping const & { return m_mapping; }
+
+    /// whole window is damaged
+    void invalidate() { m_isFull = true; }
+
+    /// damage of one captured frame
+    void addCaptured(std::span<const MoveRect> moved, std::span<const RECT> dirty, CaptureMapping const &);
+    /// damage in target coordinates
+    void addTarget(Rect targetRect);
+    /// damage in window coordinates
+    void addOutput(Rect outputRect);
+
+    /// takes all damage collected since the last present
+    /// note: result is valid until the next call
+    auto present() -> Present;
+
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    Config m_config{};
+    OutputMapping m_mapping{};
+    bool m_isFull{true}; // nothing was presented yet
+    bool m_wasFull{true};
+    std::vector<Rect> m_damage{};
+    std::vector<Rect> m_lastDamage{};
+    std::vector<Rect> m_redraw{};
+    RectCoalescer m_dirtyCoalescer{};
+    RectCoalescer m_redrawCoalescer{};
+    Stats m_stats{};
+};
+
+} // namespace core
@@ -0,0 +1,250 @@
+#include "FrameTrace.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+
+namespace core {
+
+namespace {
+
+struct ThreadEntry {
+    std::string name;
+    std::unique_ptr<FrameTraceRing> ring; // never released, the next new thread reuses it
+    bool isActive{}; // the thread is running and owns the ring
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadEntry> threads;
+};
+
+auto registry() -> Registry & {
+    static auto instance = Registry{};
+    return instance;
+}
+
+struct ThreadState {
+    FrameTraceRing *ring{};
+    uint32_t index{};
+    uint64_t frame{};
+
+    ThreadState() = default;
+    ThreadState(ThreadState const &) = delete;
+    ThreadState &operator=(ThreadState const &) = delete;
+    /// the ring of an exited thread keeps its records until another thread registers
+    ~ThreadState() {
+        if (!ring) return;
+        auto &reg = registry();
+        const auto lock = std::lock_guard{reg.mutex};
+        reg.threads[index].isActive = false;
+    }
+};
+thread_local auto t_state = ThreadState{};
+
+/// ring of the calling thread - registered on first use
+/// note: rings of exited threads are reused, so restarted threads do not grow the registry
+auto threadState() -> ThreadState & {
+    if (!t_state.ring) {
+        auto &reg = registry();
+        const auto lock = std::lock_guard{reg.mutex};
+        auto it = std::ranges::find_if(reg.threads, [](ThreadEntry const &entry) { return !entry.isActive; });
+        if (it == reg.threads.end()) {
+            reg.threads.push_back(ThreadEntry{{}, std::make_unique<FrameTraceRing>()});
+            it = std::prev(reg.threads.end());
+        }
+        else {
+            it->ring->clear();
+        }
+        t_state.index = static_cast<uint32_t>(it - reg.threads.begin());
+        it->name = "thread " + std::to_string(t_state.index);
+        it->isActive = true;
+        t_state.ring = it->ring.get();
+    }
+    return t_state;
+}
+
+/// minimal JSON string escaping for thread names
+auto jsonEscaped(std::string_view text) -> std::string {
+    auto result = std::string{};
+    for (const auto ch : text) {
+        if (ch == '"' || ch == '\\') result.push_back('\\');
+        if (static_cast<unsigned char>(ch) >= 0x20) result.push_back(ch);
+    }
+    return result;
+}
+
+auto threadName(std::span<const std::string> names, uint32_t thread) -> std::string {
+    return thread < names.size() ? names[thread] : std::string{};
+}
+
+auto micros(int64_t nanoseconds) -> double { return static_cast<double>(nanoseconds) / 1000.0; }
+
+/// append printf formatted text
+template<class... Args>
+void append(std::string &out, const char *format, Args... args) {
+    char buffer[256];
+    const auto length = std::snprintf(buffer, sizeof(buffer), format, args...);
+    if (length > 0) out.append(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1));
+}
+
+} // namespace
+
+void FrameTrace::nameThread(std::string_view name) {
+    auto &state = threadState();
+    auto &reg = registry();
+    const auto lock = std::lock_guard{reg.mutex};
+    reg.threads[state.index].name = name;
+}
+
+void FrameTrace::setFrame(uint64_t frame) noexcept { t_state.frame = frame; }
+
+void FrameTrace::record(Stage stage, int64_t begin, int64_t end) noexcept {
+    try {
+        auto &state = threadState();
+        state.ring->push({state.frame, stage, state.index, begin, end});
+    }
+    catch (...) {
+        // registration failed - the record is dropped
+    }
+}
+
+auto FrameTrace::collect() -> std::vector<Record> {
+    auto result = std::vector<Record>{};
+    auto &reg = registry();
+    {
+        const auto lock = std::lock_guard{reg.mutex};
+        result.reserve(reg.threads.size() * ringCapacity);
+        for (auto i = size_t{}; i < reg.threads.size(); ++i) {
+            reg.threads[i].ring->snapshot(result, static_cast<uint32_t>(i));
+        }
+    }
+    std::stable_sort(result.begin(), result.end(), [](Record const &a, Record const &b) { return a.begin < b.begin; });
+    return result;
+}
+
+auto FrameTrace::threadNames() -> std::vector<std::string> {
+    auto &reg = registry();
+    const auto lock = std::lock_guard{reg.mutex};
+    auto result = std::vector<std::string>{};
+    result.reserve(reg.threads.size());
+    for (const auto &thread : reg.threads) result.push_back(thread.name);
+    return result;
+}
+
+auto FrameTrace::stageName(Stage stage) -> std::string_view {
+    switch (stage) {
+    case Stage::Acquire: return "acquire";
+    case Stage::Metadata: return "metadata";
+    case Stage::Staging: return "staging";
+    case Stage::Deliver: return "deliver";
+    case Stage::Update: return "update";
+    case Stage::Render: return "render";
+    case Stage::Present: return "present";
+    }
+    return "unknown";
+}
+
+auto FrameTrace::toChromeTrace(std::span<const Record> records, std::span<const std::string> threadNames)
+    -> std::string {
+    const auto origin = records.empty() ? int64_t{} : records.front().begin;
+    auto result = std::string{"{\"traceEvents\":[\n"};
+    auto separator = "";
+    for (auto i = size_t{}; i < threadNames.size(); ++i) {
+        const auto name = jsonEscaped(threadNames[i]);
+        append(
+            result,
+            R"(%s{"name":"thread_name","ph":"M","pid":1,"tid":%zu,"args":{"name":"%s"}})",
+            separator,
+            i,
+            name.c_str());
+        separator = ",\n";
+    }
+    for (const auto &record : records) {
+        append(
+            result,
+            R"(%s{"name":"%s","cat":"frame","ph":"X","pid":1,"tid":%u,"ts":%.3f,"dur":%.3f,"args":{"frame":%)" PRIu64
+            "}}",
+            separator,
+            stageName(record.stage).data(),
+            record.thread,
+            micros(record.begin - origin),
+            micros(record.end - record.begin),
+            record.frame);
+        separator = ",\n";
+    }
+    result += "\n]}\n";
+    return result;
+}
+
+auto FrameTrace::toCsv(std::span<const Record> records, std::span<const std::string> threadNames) -> std::string {
+    const auto origin = records.empty() ? int64_t{} : records.front().begin;
+    auto result = std::string{"frame,stage,thread,begin_us,duration_us\n"};
+    for (const auto &record : records) {
+        const auto thread = threadName(threadNames, record.thread);
+        append(
+            result,
+            "%" PRIu64 ",%s,%s,%.3f,%.3f\n",
+            record.frame,
+            stageName(record.stage).data(),
+            thread.c_str(),
+            micros(record.begin - origin),
+            micros(record.end - record.begin));
+    }
+    return result;
+}
+
+bool FrameTrace::writeFiles(std::filesystem::path basePath) {
+    const auto records = collect();
+    const auto names = threadNames();
+    const auto write = [&](std::filesystem::path const &path, std::string const &content) {
+        auto file = std::ofstream{path, std::ios::binary | std::ios::trunc};
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        return file.good();
+    };
+    const auto jsonOk = write(basePath.replace_extension(".json"), toChromeTrace(records, names));
+    const auto csvOk = write(basePath.replace_extension(".csv"), toCsv(records, names));
+    return jsonOk && csvOk;
+}
+
+void FrameTraceRing::push(Record const &record) noexcept {
+    const auto index = m_written.load(std::memory_order_relaxed);
+    auto &slot = m_slots[index % m_slots.size()];
+    const auto version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.frame.store(record.frame, std::memory_order_relaxed);
+    slot.stage.store(static_cast<uint32_t>(record.stage), std::memory_order_relaxed);
+    slot.begin.store(record.begin, std::memory_order_relaxed);
+    slot.end.store(record.end, std::memory_order_relaxed);
+    slot.version.store(version + 2, std::memory_order_release);
+    m_written.store(index + 1, std::memory_order_release);
+}
+
+void FrameTraceRing::clear() noexcept { m_written.store(0, std::memory_order_release); }
+
+void FrameTraceRing::snapshot(std::vector<Record> &out, uint32_t thread) const {
+    const auto written = m_written.load(std::memory_order_acquire);
+    const auto first = written > m_slots.size() ? written - m_slots.size() : uint64_t{};
+    for (auto index = first; index < written; ++index) {
+        const auto &slot = m_slots[index % m_slots.size()];
+        const auto version = slot.version.load(std::memory_order_acquire);
+        if (version % 2 != 0) continue; // writer is busy with this slot
+        const auto record = Record{
+            .frame = slot.frame.load(std::memory_order_relaxed),
+            .stage = static_cast<FrameTrace::Stage>(slot.stage.load(std::memory_order_relaxed)),
+            .thread = thread,
+            .begin = slot.begin.load(std::memory_order_relaxed),
+            .end = slot.end.load(std::memory_order_relaxed),
+        };
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version) continue; // overwritten while reading
+        out.push_back(record);
+    }
+}
+
+} // namespace core
@@ -0,0 +1,128 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core {
+
+/// Timestamps of the pipeline stages of each frame
+/// note:
+/// * every thread records into its own wait free ring, old records are overwritten
+/// * the ring of an exited thread is reused by the next thread that records
+/// * records are correlated by the frame sequence number that is current for the recording thread
+/// * use the FRAME_TRACE_* macros - they compile to nothing unless DESKDUP_FRAME_TRACE is defined
+struct FrameTrace {
+    enum class Stage : uint32_t {
+        Acquire, ///< AcquireNextFrame returned a frame
+        Metadata, ///< move, dirty and pointer data fetched
+        Staging, ///< changed content copied out of the acquired frame
+        Deliver, ///< frame handed to the consumer (setFrame)
+        Update, ///< FrameUpdater::update
+        Render, ///< WindowRenderer::render
+        Present, ///< swap chain present
+    };
+    struct Record {
+        uint64_t frame{}; ///< sequence number of the frame
+        Stage stage{};
+        uint32_t thread{}; ///< index of the recording thread (see threadNames())
+        int64_t begin{}; ///< nanoseconds of steady clock
+        int64_t end{};
+
+        bool operator==(Record const &) const = default;
+    };
+    static constexpr auto ringCapacity = size_t{4096}; ///< records kept per thread
+
+    static auto now() noexcept -> int64_t {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /// name the calling thread in the output
+    static void nameThread(std::string_view name);
+    /// following records of the calling thread belong to this frame
+    static void setFrame(uint64_t frame) noexcept;
+    static void record(Stage, int64_t begin, int64_t end) noexcept;
+
+    /// snapshot of all records sorted by begin
+    /// note: thread safe, records written during the snapshot might be missing
+    static auto collect() -> std::vector<Record>;
+    static auto threadNames() -> std::vector<std::string>;
+
+    static auto stageName(Stage) -> std::string_view;
+    /// Chrome trace event format (load with chrome://tracing or ui.perfetto.dev)
+    static auto toChromeTrace(std::span<const Record>, std::span<const std::string> threadNames) -> std::string;
+    static auto toCsv(std::span<const Record>, std::span<const std::string> threadNames) -> std::string;
+
+    /// writes all records to basePath.json (Chrome trace) and basePath.csv - returns false on errors
+    static bool writeFiles(std::filesystem::path basePath);
+};
+
+/// records the lifetime of the scope as a stage of the current frame
+struct FrameTraceScope {
+    explicit FrameTraceScope(FrameTrace::Stage stage) noexcept
+        : m_stage{stage}
+        , m_begin{FrameTrace::now()} {}
+    ~FrameTraceScope() { FrameTrace::record(m_stage, m_begin, FrameTrace::now()); }
+
+    FrameTraceScope(FrameTraceScope const &) = delete;
+    FrameTraceScope &operator=(FrameTraceScope const &) = delete;
+
+private:
+    FrameTrace::Stage m_stage;
+    int64_t m_begin;
+};
+
+/// Records of one thread
+/// note: one writer thread, any number of reader threads
+struct FrameTraceRing {
+    using Record = FrameTrace::Record;
+
+    void push(Record const &) noexcept;
+    /// drops all records (only while no thread writes)
+    void clear() noexcept;
+    /// appends all completely written records
+    void snapshot(std::vector<Record> &out, uint32_t thread) const;
+
+private:
+    // every field is atomic, so readers never race with the writer
+    // the version is odd while the slot is written
+    struct Slot {
+        std::atomic<uint64_t> version{};
+        std::atomic<uint64_t> frame{};
+        std::atomic<uint32_t> stage{};
+        std::atomic<int64_t> begin{};
+        std::atomic<int64_t> end{};
+    };
+    std::atomic<uint64_t> m_written{};
+    std::array<Slot, FrameTrace::ringCapacity> m_slots{};
+};
+
+} // namespace core
+
+#ifdef DESKDUP_FRAME_TRACE
+#    define FRAME_TRACE_CONCAT_(a, b) a##b
+#    define FRAME_TRACE_CONCAT(a, b) FRAME_TRACE_CONCAT_(a, b)
+#    define FRAME_TRACE_THREAD(name) ::core::FrameTrace::nameThread(name)
+#    define FRAME_TRACE_FRAME(sequence) ::core::FrameTrace::setFrame(sequence)
+#    define FRAME_TRACE_SCOPE(stage)                                                                                  \
+        const auto FRAME_TRACE_CONCAT(frameTraceScope, __LINE__) = ::core::FrameTraceScope {                           \
+            ::core::FrameTrace::Stage::stage                                                                           \
+        }
+#    define FRAME_TRACE_BEGIN(name) const auto name = ::core::FrameTrace::now()
+#    define FRAME_TRACE_END(name, stage)                                                                               \
+        ::core::FrameTrace::record(::core::FrameTrace::Stage::stage, name, ::core::FrameTrace::now())
+#else
+#    define FRAME_TRACE_THREAD(name) (void)0
+#    define FRAME_TRACE_FRAME(sequence) (void)0
+#    define FRAME_TRACE_SCOPE(stage) (void)0
+#    define FRAME_TRACE_BEGIN(name) (void)0
+#    define FRAME_TRACE_END(name, stage) (void)0
+#endif
@@ -0,0 +1,84 @@
+#include "Hash.h"
+
+#include <bit>
+#include <cstring>
+
+namespace core {
+namespace {
+
+constexpr auto prime1 = uint64_t{0x9E3779B185EBCA87};
+constexpr auto prime2 = uint64_t{0xC2B2AE3D27D4EB4F};
+constexpr auto prime3 = uint64_t{0x165667B19E3779F9};
+constexpr auto prime4 = uint64_t{0x85EBCA77C2B2AE63};
+constexpr auto prime5 = uint64_t{0x27D4EB2F165667C5};
+
+auto read64(const uint8_t *p) -> uint64_t {
+    auto value = uint64_t{};
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+auto read32(const uint8_t *p) -> uint32_t {
+    auto value = uint32_t{};
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+auto round(uint64_t acc, uint64_t input) -> uint64_t {
+    acc += input * prime2;
+    return std::rotl(acc, 31) * prime1;
+}
+
+auto mergeRound(uint64_t acc, uint64_t value) -> uint64_t {
+    acc ^= round(0, value);
+    return acc * prime1 + prime4;
+}
+
+} // namespace
+
+auto hashBytes(std::span<const uint8_t> bytes, uint64_t seed) noexcept -> uint64_t {
+    const auto *p = bytes.data();
+    const auto *end = p + bytes.size();
+    auto hash = uint64_t{};
+    if (bytes.size() >= 32) {
+        auto v1 = seed + prime1 + prime2;
+        auto v2 = seed + prime2;
+        auto v3 = seed;
+        auto v4 = seed - prime1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        hash = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    }
+    else {
+        hash = seed + prime5;
+    }
+    hash += bytes.size();
+    for (; p + 8 <= end; p += 8) {
+        hash ^= round(0, read64(p));
+        hash = std::rotl(hash, 27) * prime1 + prime4;
+    }
+    if (p + 4 <= end) {
+        hash ^= uint64_t{read32(p)} * prime1;
+        hash = std::rotl(hash, 23) * prime2 + prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        hash ^= *p * prime5;
+        hash = std::rotl(hash, 11) * prime1;
+    }
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+} // namespace core
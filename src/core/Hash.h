@@ -0,0 +1,11 @@
+#pragma once
+#include <span>
+#include <stdint.h>
+
+namespace core {
+
+/// 64 bit hash of bytes (xxHash64)
+/// note: fast non cryptographic hash to detect identical content
+auto hashBytes(std::span<const uint8_t> bytes, uint64_t seed = 0) noexcept -> uint64_t;
+
+} // namespace core
@@ -0,0 +1,86 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace core {
+
+void LatencyHistogram::record(uint64_t micros) noexcept {
+    if (micros > maxValue) micros = maxValue;
+    m_buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(micros, std::memory_order_relaxed);
+    // single writer - no compare exchange required
+    if (micros < m_min.load(std::memory_order_relaxed)) m_min.store(micros, std::memory_order_relaxed);
+    if (micros > m_max.load(std::memory_order_relaxed)) m_max.store(micros, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_release);
+}
+
+void LatencyHistogram::reset() noexcept {
+    for (auto &bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(UINT64_MAX, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_release);
+}
+
+auto LatencyHistogram::percentile(double percent) const noexcept -> uint64_t {
+    // count the buckets, the total might be behind a concurrent record
+    auto total = uint64_t{};
+    for (const auto &bucket : m_buckets) total += bucket.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    const auto clamped = percent < 0.0 ? 0.0 : percent > 100.0 ? 100.0 : percent;
+    auto rank = static_cast<uint64_t>(clamped / 100.0 * static_cast<double>(total) + 0.5);
+    if (rank == 0) rank = 1;
+    auto seen = uint64_t{};
+    for (auto i = size_t{}; i < m_buckets.size(); ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            const auto max = m_max.load(std::memory_order_relaxed);
+            const auto high = bucketHigh(i);
+            return high < max ? high : max;
+        }
+    }
+    return m_max.load(std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::summary() const noexcept -> Summary {
+    const auto count = m_count.load(std::memory_order_acquire);
+    if (count == 0) return {};
+    return {
+        .count = count,
+        .min = m_min.load(std::memory_order_relaxed),
+        .max = m_max.load(std::memory_order_relaxed),
+        .mean = static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(count),
+        .p50 = percentile(50.0),
+        .p90 = percentile(90.0),
+        .p99 = percentile(99.0),
+        .p999 = percentile(99.9),
+    };
+}
+
+auto LatencyHistogram::toCsv(std::string_view name) const -> std::string {
+    auto total = uint64_t{};
+    for (const auto &bucket : m_buckets) total += bucket.load(std::memory_order_relaxed);
+    auto result = std::string{};
+    auto seen = uint64_t{};
+    const auto label = std::string{name};
+    for (auto i = size_t{}; i < m_buckets.size(); ++i) {
+        const auto count = m_buckets[i].load(std::memory_order_relaxed);
+        if (count == 0) continue;
+        seen += count;
+        char line[128];
+        const auto length = std::snprintf(
+            line,
+            sizeof(line),
+            "%s,%" PRIu64 ",%" PRIu64 ",%.3f\n",
+            label.c_str(),
+            bucketHigh(i),
+            count,
+            100.0 * static_cast<double>(seen) / static_cast<double>(total));
+        if (length > 0) result.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1));
+    }
+    return result;
+}
+
+} // namespace core
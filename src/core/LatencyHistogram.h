@@ -0,0 +1,81 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+namespace core {
+
+/// Histogram of latencies in microseconds with a bounded relative error (like HdrHistogram)
+/// note:
+/// * values below 32us are exact, above each power of two is split into 32 linear buckets (error < 3.2%)
+/// * values above maxValue are clamped
+/// * one thread records, any thread can read while recording goes on
+struct LatencyHistogram {
+    static constexpr auto subBucketBits = 5;
+    static constexpr auto subBuckets = size_t{1} << subBucketBits;
+    static constexpr auto maxValue = (uint64_t{1} << 32) - 1; ///< a bit over an hour
+    static constexpr auto bucketCount = subBuckets + (32 - subBucketBits) * subBuckets;
+
+    struct Summary {
+        uint64_t count{};
+        uint64_t min{};
+        uint64_t max{};
+        double mean{};
+        uint64_t p50{};
+        uint64_t p90{};
+        uint64_t p99{};
+        uint64_t p999{};
+    };
+
+    void record(uint64_t micros) noexcept;
+    /// note: not synchronized with record - call from the recording thread
+    void reset() noexcept;
+
+    auto count() const noexcept -> uint64_t { return m_count.load(std::memory_order_relaxed); }
+    /// highest value of the bucket that contains the given percentile (0..100) - 0 if empty
+    auto percentile(double percent) const noexcept -> uint64_t;
+    auto summary() const noexcept -> Summary;
+
+    /// non empty buckets as "name,value_us,count,percentile" lines
+    auto toCsv(std::string_view name) const -> std::string;
+
+    static constexpr auto bucketIndex(uint64_t value) noexcept -> size_t {
+        if (value > maxValue) value = maxValue;
+        if (value < subBuckets) return static_cast<size_t>(value);
+        auto magnitude = 0;
+        for (auto v = value; v > 1; v >>= 1) magnitude++;
+        const auto shift = magnitude - subBucketBits;
+        const auto sub = static_cast<size_t>(value >> shift) - subBuckets;
+        return subBuckets + static_cast<size_t>(shift) * subBuckets + sub;
+    }
+    /// lowest value that is counted in the bucket
+    static constexpr auto bucketLow(size_t index) noexcept -> uint64_t {
+        if (index < subBuckets) return index;
+        const auto shift = index / subBuckets - 1;
+        return static_cast<uint64_t>(subBuckets + index % subBuckets) << shift;
+    }
+    /// highest value that is counted in the bucket
+    static constexpr auto bucketHigh(size_t index) noexcept -> uint64_t {
+        if (index < subBuckets) return index;
+        const auto shift = index / subBuckets - 1;
+        return bucketLow(index) + (uint64_t{1} << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, bucketCount> m_buckets{};
+    std::atomic<uint64_t> m_count{};
+    std::atomic<uint64_t> m_sum{};
+    std::atomic<uint64_t> m_min{UINT64_MAX};
+    std::atomic<uint64_t> m_max{};
+};
+
+/// latencies until a captured change is presented in the output window
+struct PresentLatency {
+    LatencyHistogram::Summary capture{}; ///< desktop present time to window present
+    LatencyHistogram::Summary pointer{}; ///< pointer update time to window present
+};
+
+} // namespace core
@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+/// Small cache that evicts the least recently used entry
+/// note: entries are kept in recently used order and searched linearly (meant for a handful of entries)
+template<class Key, class Value>
+struct LruCache {
+    explicit LruCache(size_t capacity)
+        : m_capacity{capacity} {
+        m_entries.reserve(capacity + 1);
+    }
+
+    /// returns nullptr if key is not cached, otherwise the entry becomes the most recently used
+    auto find(const Key &key) -> Value * {
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->first == key) {
+                if (it != m_entries.begin()) std::rotate(m_entries.begin(), it, it + 1);
+                return &m_entries.front().second;
+            }
+        }
+        return nullptr;
+    }
+
+    /// insert as the most recently used entry (key must not be cached)
+    auto insert(Key key, Value value) -> Value & {
+        m_entries.emplace(m_entries.begin(), std::move(key), std::move(value));
+        if (m_entries.size() > m_capacity) m_entries.pop_back();
+        return m_entries.front().second;
+    }
+
+    void clear() noexcept { m_entries.clear(); }
+    auto size() const noexcept -> size_t { return m_entries.size(); }
+
+private:
+    size_t m_capacity{};
+    std::vector<std::pair<Key, Value>> m_entries{};
+};
+
+} // namespace core
@@ -0,0 +1,70 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#    include <Windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace core {
+
+#ifdef _WIN32
+
+bool MappedFile::open(std::filesystem::path const &path) {
+    close();
+    const auto file = CreateFileW(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    auto size = LARGE_INTEGER{};
+    const auto hasSize = GetFileSizeEx(file, &size) && size.QuadPart > 0;
+    // note: the mapping keeps the file open
+    m_mapping = hasSize ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (!m_mapping) return false;
+    m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data) {
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+}
+
+#else
+
+bool MappedFile::open(std::filesystem::path const &path) {
+    close();
+    const auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+    struct stat status {};
+    const auto hasSize = ::fstat(file, &status) == 0 && status.st_size > 0;
+    // note: the mapping keeps the file open
+    auto *data = hasSize ? ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0)
+                         : MAP_FAILED;
+    ::close(file);
+    if (data == MAP_FAILED) return false;
+    m_data = static_cast<const uint8_t *>(data);
+    m_size = static_cast<size_t>(status.st_size);
+    return true;
+}
+
+void MappedFile::close() noexcept {
+    if (m_data) ::munmap(const_cast<uint8_t *>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+} // namespace core
@@ -0,0 +1,32 @@
+#pragma once
+#include <filesystem>
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace core {
+
+/// Read only memory mapping of an entire file
+/// note: pages are loaded by the OS when they are touched, the mapping starts page aligned
+struct MappedFile {
+    MappedFile() = default;
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+    ~MappedFile() { close(); }
+
+    /// map the file - returns false if it cannot be opened or is empty
+    bool open(std::filesystem::path const &);
+    void close() noexcept;
+
+    bool isOpen() const { return m_data != nullptr; }
+    auto bytes() const -> std::span<const uint8_t> { return {m_data, m_size}; }
+
+private:
+    const uint8_t *m_data{};
+    size_t m_size{};
+#ifdef _WIN32
+    void *m_mapping{}; // HANDLE of the file mapping
+#endif
+};
+
+} // namespace core
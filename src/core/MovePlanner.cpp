@@ -0,0 +1,74 @@
+#include "MovePlanner.h"
+
+#include "PixelCopy.h"
+#include "VisibleAreaCuller.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+namespace core {
+
+auto MovePlanner::plan(std::span<const RectMove> moves) -> Plan const & {
+    m_plan.copies.clear();
+    m_plan.tempDimension = {};
+    for (auto const &move : moves) {
+        const auto &source = move.source;
+        const auto destination = Rect{move.destination, source.dimension};
+        if (source.width() <= 0 || source.height() <= 0) continue;
+        if (!intersect(source, destination)) {
+            m_plan.copies.push_back({source, move.destination});
+            m_stats.directMoves++;
+            continue;
+        }
+        const auto dx = move.destination.x - source.left();
+        const auto dy = move.destination.y - source.top();
+        if (dx == 0 && dy == 0) continue; // nothing moves
+
+        // bands of rows (for vertical moves) or columns (for horizontal moves) no longer than the shift
+        // never overlap themselves - start with the band that is overwritten first
+        const auto isVertical = dy != 0;
+        const auto shift = isVertical ? abs(dy) : abs(dx);
+        const auto length = isVertical ? source.height() : source.width();
+        const auto bands = (length + shift - 1) / shift;
+        if (bands > m_config.maxBands) {
+            m_plan.copies.push_back({source, move.destination, true});
+            m_plan.tempDimension.width = std::max(m_plan.tempDimension.width, source.width());
+            m_plan.tempDimension.height = std::max(m_plan.tempDimension.height, source.height());
+            m_stats.tempMoves++;
+            continue;
+        }
+        const auto forward = isVertical ? dy < 0 : dx < 0; // towards the origin => first band first
+        for (auto band = 0; band < bands; ++band) {
+            const auto index = forward ? band : bands - 1 - band;
+            const auto start = index * shift;
+            const auto size = std::min(shift, length - start);
+            auto bandSource = isVertical ? Rect{{source.left(), source.top() + start}, {source.width(), size}}
+                                         : Rect{{source.left() + start, source.top()}, {size, source.height()}};
+            m_plan.copies.push_back({bandSource, Point{bandSource.left() + dx, bandSource.top() + dy}});
+        }
+        m_stats.bandedMoves++;
+    }
+    return m_plan;
+}
+
+void executeMovePlan(SurfaceSpan surface, MovePlanner::Plan const &plan, SurfaceSpan temp) {
+    for (auto const &copy : plan.copies) {
+        if (copy.viaTemp) {
+            copyRect(surface, copy.source, temp, {});
+            copyRect(temp, Rect{{}, copy.source.dimension}, surface, copy.destination);
+        }
+        else {
+            copyRect(surface, copy.source, surface, copy.destination);
+        }
+    }
+}
+
+void applyMovesReference(SurfaceSpan surface, std::span<const RectMove> moves) {
+    auto temp = Surface{surface.dimension};
+    for (auto const &move : moves) {
+        copyRect(surface, move.source, temp.span(), move.source.topLeft);
+        copyRect(temp.view(), move.source, surface, move.destination);
+    }
+}
+
+} // namespace core
@@ -0,0 +1,68 @@
+#pragma once
+#include "Surface.h"
+#include "win32/Geometry.h"
+
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+using win32::Dimension;
+using win32::Point;
+using win32::Rect;
+
+/// content of source is copied to destination (moves are applied one after another)
+struct RectMove {
+    Rect source{};
+    Point destination{};
+};
+
+/// Plans the copies for a list of moves inside one surface
+/// note:
+/// * a copy must never read and write overlapping pixels
+/// * moves without overlap are copied directly
+/// * overlapping moves are split into bands that are copied in a safe order
+/// * only if this would need too many bands the move is copied through a temporary surface
+struct MovePlanner {
+    struct Copy {
+        Rect source{};
+        Point destination{};
+        bool viaTemp{}; ///< copy source to (0,0) of temp and from there to destination
+    };
+    struct Plan {
+        std::vector<Copy> copies{};
+        Dimension tempDimension{}; ///< minimal dimension of the temporary surface
+    };
+    struct Stats {
+        uint64_t directMoves{};
+        uint64_t bandedMoves{};
+        uint64_t tempMoves{};
+    };
+    struct Config {
+        int maxBands = 4; ///< more bands are slower than a copy through temp
+    };
+
+    MovePlanner() = default;
+    explicit MovePlanner(Config config)
+        : m_config{config} {}
+
+    /// note: result is valid until the next call
+    auto plan(std::span<const RectMove> moves) -> Plan const &;
+
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    Config m_config{};
+    Plan m_plan{};
+    Stats m_stats{};
+};
+
+/// execute the plan on a system memory surface
+/// note: temp has to be at least of plan.tempDimension
+void executeMovePlan(SurfaceSpan surface, MovePlanner::Plan const &plan, SurfaceSpan temp);
+
+/// reference implementation - copies every move through a full size temporary surface
+void applyMovesReference(SurfaceSpan surface, std::span<const RectMove> moves);
+
+} // namespace core
@@ -0,0 +1,49 @@
+#include "PixelCopy.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#    define CORE_PIXEL_COPY_SSE2
+#    include <emmintrin.h>
+#endif
+
+namespace core {
+
+void copyRow(uint8_t *destination, const uint8_t *source, size_t bytes) {
+#ifdef CORE_PIXEL_COPY_SSE2
+    // rows of dirty rects are short and unaligned, 64 bytes (16 pixels) per iteration keeps the loads in flight
+    while (bytes >= 64) {
+        const auto *from = reinterpret_cast<const __m128i *>(source);
+        auto *to = reinterpret_cast<__m128i *>(destination);
+        const auto a = _mm_loadu_si128(from + 0);
+        const auto b = _mm_loadu_si128(from + 1);
+        const auto c = _mm_loadu_si128(from + 2);
+        const auto d = _mm_loadu_si128(from + 3);
+        _mm_storeu_si128(to + 0, a);
+        _mm_storeu_si128(to + 1, b);
+        _mm_storeu_si128(to + 2, c);
+        _mm_storeu_si128(to + 3, d);
+        source += 64;
+        destination += 64;
+        bytes -= 64;
+    }
+    while (bytes >= 16) {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination), value);
+        source += 16;
+        destination += 16;
+        bytes -= 16;
+    }
+#endif
+    if (bytes != 0) std::memcpy(destination, source, bytes);
+}
+
+void copyRect(SurfaceView from, Rect source, SurfaceSpan to, Point destination) {
+    const auto rowBytes = static_cast<size_t>(source.width()) * bytesPerPixel;
+    for (auto row = 0; row < source.height(); ++row) {
+        copyRow(
+            to.pixel({destination.x, destination.y + row}), from.pixel({source.left(), source.top() + row}), rowBytes);
+    }
+}
+
+} // namespace core
@@ -0,0 +1,17 @@
+#pragma once
+#include "Surface.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace core {
+
+/// copy bytes of one row
+/// note: source and destination must not overlap
+void copyRow(uint8_t *destination, const uint8_t *source, size_t bytes);
+
+/// copy the source rect of from to destination in to
+/// note: rect has to be inside both surfaces, source and destination must not overlap
+void copyRect(SurfaceView from, Rect source, SurfaceSpan to, Point destination);
+
+} // namespace core
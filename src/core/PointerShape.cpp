@@ -0,0 +1,140 @@
+#include "PointerShape.h"
+
+#include "Hash.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#    define CORE_POINTER_SHAPE_SSE2
+#    include <emmintrin.h>
+#endif
+
+namespace core {
+namespace {
+
+constexpr auto andColor = uint32_t{0xFF000000}; // and bit set: xor with the screen (alpha)
+constexpr auto xorColor = uint32_t{0x00FFFFFF}; // xor bit set: white
+
+/// 8 pixels for every mask byte (most significant bit is the leftmost pixel)
+using PixelTable = std::array<std::array<uint32_t, 8>, 256>;
+
+constexpr auto makeTable(uint32_t color) -> PixelTable {
+    auto table = PixelTable{};
+    for (auto byte = 0; byte < 256; ++byte) {
+        for (auto bit = 0; bit < 8; ++bit) table[byte][bit] = (byte & (0x80 >> bit)) ? color : 0u;
+    }
+    return table;
+}
+
+alignas(16) constexpr auto andTable = makeTable(andColor);
+alignas(16) constexpr auto xorTable = makeTable(xorColor);
+
+void expandBytes(uint32_t *out, const uint8_t *andMask, const uint8_t *xorMask, size_t bytes) {
+    for (auto i = size_t{}; i < bytes; ++i, out += 8) {
+        const auto &andPixels = andTable[andMask[i]];
+        const auto &xorPixels = xorTable[xorMask[i]];
+#ifdef CORE_POINTER_SHAPE_SSE2
+        const auto *a = reinterpret_cast<const __m128i *>(andPixels.data());
+        const auto *x = reinterpret_cast<const __m128i *>(xorPixels.data());
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_or_si128(_mm_load_si128(a), _mm_load_si128(x)));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i *>(out + 4), _mm_or_si128(_mm_load_si128(a + 1), _mm_load_si128(x + 1)));
+#else
+        for (auto bit = 0; bit < 8; ++bit) out[bit] = andPixels[bit] | xorPixels[bit];
+#endif
+    }
+}
+
+} // namespace
+
+auto PointerShapeKey::make(const DXGI_OUTDUPL_POINTER_SHAPE_INFO &info, std::span<const uint8_t> data)
+    -> PointerShapeKey {
+    return {hashBytes(data), info};
+}
+
+bool PointerShapeKey::operator==(const PointerShapeKey &other) const noexcept {
+    return hash == other.hash && info.Type == other.info.Type && info.Width == other.info.Width &&
+        info.Height == other.info.Height && info.Pitch == other.info.Pitch && info.HotSpot.x == other.info.HotSpot.x &&
+        info.HotSpot.y == other.info.HotSpot.y;
+}
+
+auto PointerShapeConverter::convert(const DXGI_OUTDUPL_POINTER_SHAPE_INFO &info, std::span<const uint8_t> data)
+    -> SurfaceView {
+    switch (info.Type) {
+    case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MONOCHROME: return convertMonochrome(info, data);
+    case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_MASKED_COLOR: return convertMaskedColor(info, data);
+    case DXGI_OUTDUPL_POINTER_SHAPE_TYPE_COLOR:
+        if (data.size() < static_cast<size_t>(info.Pitch) * info.Height) return {};
+        return {
+            data.data(),
+            {static_cast<int>(info.Width), static_cast<int>(info.Height)},
+            static_cast<int>(info.Pitch),
+        };
+    default: return {};
+    }
+}
+
+auto PointerShapeConverter::convertMonochrome(
+    const DXGI_OUTDUPL_POINTER_SHAPE_INFO &info, std::span<const uint8_t> data) -> SurfaceView {
+    // and mask rows are followed by the xor mask rows
+    const auto width = static_cast<size_t>(info.Width);
+    const auto height = static_cast<size_t>(info.Height / 2);
+    const auto pitch = static_cast<size_t>(info.Pitch);
+    if (data.size() < 2 * height * pitch || pitch * 8 < width) return {};
+
+    const auto fullBytes = width / 8;
+    const auto restBits = width % 8;
+    m_pixels.resize(width * height);
+    for (auto row = size_t{}; row < height; ++row) {
+        const auto *andMask = data.data() + row * pitch;
+        const auto *xorMask = andMask + height * pitch;
+        auto *out = m_pixels.data() + row * width;
+        expandBytes(out, andMask, xorMask, fullBytes);
+        if (restBits != 0) {
+            const auto &andPixels = andTable[andMask[fullBytes]];
+            const auto &xorPixels = xorTable[xorMask[fullBytes]];
+            out += fullBytes * 8;
+            for (auto bit = size_t{}; bit < restBits; ++bit) out[bit] = andPixels[bit] | xorPixels[bit];
+        }
+    }
+    return {
+        reinterpret_cast<const uint8_t *>(m_pixels.data()),
+        {static_cast<int>(width), static_cast<int>(height)},
+        static_cast<int>(width * bytesPerPixel),
+    };
+}
+
+auto PointerShapeConverter::convertMaskedColor(
+    const DXGI_OUTDUPL_POINTER_SHAPE_INFO &info, std::span<const uint8_t> data) -> SurfaceView {
+    const auto width = static_cast<size_t>(info.Width);
+    const auto height = static_cast<size_t>(info.Height);
+    const auto pitch = static_cast<size_t>(info.Pitch);
+    if (data.size() < height * pitch || pitch < width * bytesPerPixel) return {};
+
+    m_pixels.resize(width * height);
+    for (auto row = size_t{}; row < height; ++row) {
+        auto *out = m_pixels.data() + row * width;
+        std::memcpy(out, data.data() + row * pitch, width * bytesPerPixel);
+        auto col = size_t{};
+#ifdef CORE_POINTER_SHAPE_SSE2
+        const auto alpha = _mm_set1_epi32(static_cast<int>(andColor));
+        const auto zero = _mm_setzero_si128();
+        for (; col + 4 <= width; col += 4) {
+            auto *pixels = reinterpret_cast<__m128i *>(out + col);
+            const auto value = _mm_loadu_si128(pixels);
+            // pixels with any alpha bit get full alpha
+            const auto masked = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(value, alpha), zero), alpha);
+            _mm_storeu_si128(pixels, _mm_or_si128(_mm_andnot_si128(alpha, value), masked));
+        }
+#endif
+        for (; col < width; ++col) out[col] = (out[col] & xorColor) | ((out[col] & andColor) ? andColor : 0u);
+    }
+    return {
+        reinterpret_cast<const uint8_t *>(m_pixels.data()),
+        {static_cast<int>(width), static_cast<int>(height)},
+        static_cast<int>(width * bytesPerPixel),
+    };
+}
+
+} // namespace core
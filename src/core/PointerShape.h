@@ -0,0 +1,39 @@
+#pragma once
+#include "Surface.h"
+#include "win32/DxgiTypes.h"
+
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+/// identifies the content of a pointer shape
+struct PointerShapeKey {
+    uint64_t hash{}; ///< hash of the shape data
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO info{};
+
+    static auto make(const DXGI_OUTDUPL_POINTER_SHAPE_INFO &, std::span<const uint8_t> data) -> PointerShapeKey;
+
+    bool operator==(const PointerShapeKey &) const noexcept;
+};
+
+/// Converts DXGI pointer shapes into BGRA images for rendering
+/// note:
+/// * COLOR - returned as is (straight alpha)
+/// * MONOCHROME - and & xor bit masks are expanded to masked colors
+/// * MASKED_COLOR - alpha is normalized to 0x00 (replace) or 0xFF (xor)
+/// Masked colors: alpha 0x00 replaces the screen with the color, alpha 0xFF xors the screen with the color.
+/// The result stays valid until the next call (the buffer is reused).
+struct PointerShapeConverter {
+    auto convert(const DXGI_OUTDUPL_POINTER_SHAPE_INFO &, std::span<const uint8_t> data) -> SurfaceView;
+
+private:
+    auto convertMonochrome(const DXGI_OUTDUPL_POINTER_SHAPE_INFO &, std::span<const uint8_t> data) -> SurfaceView;
+    auto convertMaskedColor(const DXGI_OUTDUPL_POINTER_SHAPE_INFO &, std::span<const uint8_t> data) -> SurfaceView;
+
+private:
+    std::vector<uint32_t> m_pixels{};
+};
+
+} // namespace core
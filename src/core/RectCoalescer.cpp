@@ -0,0 +1,102 @@
+#include "RectCoalescer.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace core {
+
+auto RectCoalescer::Stats::operator+=(Stats const &o) -> Stats & {
+    inputRects += o.inputRects;
+    outputRects += o.outputRects;
+    inputArea += o.inputArea;
+    outputArea += o.outputArea;
+    overdrawArea += o.overdrawArea;
+    return *this;
+}
+
+auto RectCoalescer::coalesce(std::span<const Rect> input) -> std::span<const Rect> {
+    m_output.assign(input.begin(), input.end());
+    std::sort(m_output.begin(), m_output.end(), [](Rect const &a, Rect const &b) {
+        return a.top() != b.top() ? a.top() < b.top() : a.left() < b.left();
+    });
+
+    // merge each rect into one of the recent results
+    // a merged rect grows and might be merged again, so repeat until nothing changes
+    auto count = m_output.size();
+    for (auto changed = true; changed;) {
+        changed = false;
+        auto kept = size_t{};
+        for (auto i = size_t{}; i < count; ++i) {
+            const auto rect = m_output[i];
+            const auto first = kept > m_model.window ? kept - m_model.window : size_t{};
+            auto merged = false;
+            for (auto k = kept; k > first; --k) {
+                if (shouldMerge(m_output[k - 1], rect)) {
+                    mergeInto(k - 1, rect);
+                    merged = changed = true;
+                    break;
+                }
+            }
+            if (!merged) m_output[kept++] = rect;
+        }
+        count = kept;
+    }
+    m_output.resize(count);
+
+    m_last = Stats{};
+    m_last.inputRects = input.size();
+    m_last.outputRects = m_output.size();
+    m_last.inputArea = unionArea(input);
+    for (auto const &r : m_output) m_last.outputArea += area(r);
+    m_last.overdrawArea = std::max(int64_t{}, m_last.outputArea - m_last.inputArea);
+    return m_output;
+}
+
+bool RectCoalescer::shouldMerge(Rect const &a, Rect const &b) const {
+    // separate: area(a) + area(b) + 2 rects / merged: area(bounding) + 1 rect
+    const auto separate = (area(a) + area(b)) * m_model.pixelCost + m_model.rectCost;
+    const auto merged = area(boundingRect(a, b)) * m_model.pixelCost;
+    return merged <= separate;
+}
+
+/// sweeps the bands between all distinct top and bottom edges and sums the merged spans of each band
+auto RectCoalescer::unionArea(std::span<const Rect> rects) -> int64_t {
+    m_sorted.clear();
+    m_edges.clear();
+    for (const auto &r : rects) {
+        if (r.width() <= 0 || r.height() <= 0) continue;
+        m_sorted.push_back(r);
+        m_edges.push_back(r.top());
+        m_edges.push_back(r.bottom());
+    }
+    std::sort(m_sorted.begin(), m_sorted.end(), [](Rect const &a, Rect const &b) { return a.top() < b.top(); });
+    std::sort(m_edges.begin(), m_edges.end());
+    m_edges.erase(std::unique(m_edges.begin(), m_edges.end()), m_edges.end());
+
+    auto result = int64_t{};
+    auto next = size_t{};
+    m_active.clear();
+    for (auto i = size_t{1}; i < m_edges.size(); ++i) {
+        const auto top = m_edges[i - 1];
+        const auto bottom = m_edges[i];
+        std::erase_if(m_active, [&](Rect const &r) { return r.bottom() <= top; });
+        while (next < m_sorted.size() && m_sorted[next].top() <= top) m_active.push_back(m_sorted[next++]);
+
+        m_spans.clear();
+        for (const auto &r : m_active) m_spans.emplace_back(r.left(), r.right());
+        std::sort(m_spans.begin(), m_spans.end());
+        auto width = int64_t{};
+        auto end = std::numeric_limits<int>::min();
+        for (const auto &[left, right] : m_spans) {
+            if (right <= end) continue;
+            width += right - std::max(left, end);
+            end = right;
+        }
+        result += width * (bottom - top);
+    }
+    return result;
+}
+
+void RectCoalescer::mergeInto(size_t index, Rect const &rect) { m_output[index] = boundingRect(m_output[index], rect); }
+
+} // namespace core
@@ -0,0 +1,69 @@
+#pragma once
+#include "win32/Geometry.h"
+
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+using win32::Rect;
+
+/// Merges many small, overlapping or adjacent rects into fewer bigger ones
+/// note: two rects are merged when drawing their bounding box is cheaper than drawing both
+struct RectCoalescer {
+    struct CostModel {
+        int64_t rectCost{4096}; ///< fixed cost of drawing one rect (in pixels)
+        int64_t pixelCost{1}; ///< cost of drawing one pixel
+        size_t window{16}; ///< number of recent rects that are candidates for a merge
+    };
+    struct Stats {
+        size_t inputRects{};
+        size_t outputRects{};
+        int64_t inputArea{}; ///< area covered by the input (overlaps are counted once)
+        int64_t outputArea{}; ///< sum of output areas (pixels that are drawn)
+        int64_t overdrawArea{}; ///< area drawn additionally because of merges
+
+        auto operator+=(Stats const &o) -> Stats &;
+    };
+
+    RectCoalescer() = default;
+    explicit RectCoalescer(CostModel model)
+        : m_model{model} {}
+
+    /// returns the coalesced rects
+    /// note: result is valid until the next call
+    auto coalesce(std::span<const Rect> input) -> std::span<const Rect>;
+
+    auto lastStats() const -> Stats const & { return m_last; }
+
+private:
+    bool shouldMerge(Rect const &a, Rect const &b) const;
+    void mergeInto(size_t index, Rect const &rect);
+    auto unionArea(std::span<const Rect> rects) -> int64_t;
+
+private:
+    CostModel m_model{};
+    std::vector<Rect> m_output{};
+    Stats m_last{};
+    // scratch of unionArea - reused to avoid allocations per frame
+    std::vector<Rect> m_sorted{};
+    std::vector<int> m_edges{};
+    std::vector<Rect> m_active{};
+    std::vector<std::pair<int, int>> m_spans{};
+};
+
+/// smallest rect that contains both rects
+constexpr auto boundingRect(Rect const &a, Rect const &b) -> Rect {
+    const auto left = a.left() < b.left() ? a.left() : b.left();
+    const auto top = a.top() < b.top() ? a.top() : b.top();
+    const auto right = a.right() > b.right() ? a.right() : b.right();
+    const auto bottom = a.bottom() > b.bottom() ? a.bottom() : b.bottom();
+    return Rect{{left, top}, {right - left, bottom - top}};
+}
+
+constexpr auto area(Rect const &r) -> int64_t { return static_cast<int64_t>(r.width()) * r.height(); }
+
+} // namespace core
@@ -0,0 +1,216 @@
+#include "RectTransform.h"
+
+#include <stddef.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#    define CORE_RECT_TRANSFORM_SSE2
+#    include <emmintrin.h>
+#endif
+
+namespace core {
+namespace {
+
+static_assert(sizeof(RECT) == 4 * sizeof(int32_t), "RECT has to be 4 packed 32 bit integers");
+static_assert(sizeof(Vertex) == 4 * sizeof(float), "Vertex has to be 4 packed floats");
+static_assert(sizeof(QuadInstance) == 16, "QuadInstance has to be 4 packed floats");
+
+/// A rotation maps (left, top, right, bottom) to
+///   out[i] = negate[i] ? offset[i] - in[order[i]] : in[order[i]]
+template<DXGI_MODE_ROTATION>
+struct Rotation;
+
+template<>
+struct Rotation<DXGI_MODE_ROTATION_IDENTITY> {
+    static constexpr auto order = std::array{0, 1, 2, 3};
+    static constexpr auto negate = std::array{false, false, false, false};
+    static constexpr auto offset(Dimension) { return std::array{0, 0, 0, 0}; }
+};
+template<>
+struct Rotation<DXGI_MODE_ROTATION_ROTATE90> {
+    static constexpr auto order = std::array{3, 0, 1, 2};
+    static constexpr auto negate = std::array{true, false, true, false};
+    static constexpr auto offset(Dimension dim) { return std::array{dim.height, 0, dim.height, 0}; }
+};
+template<>
+struct Rotation<DXGI_MODE_ROTATION_ROTATE180> {
+    static constexpr auto order = std::array{2, 3, 0, 1};
+    static constexpr auto negate = std::array{true, true, true, true};
+    static constexpr auto offset(Dimension dim) { return std::array{dim.width, dim.height, dim.width, dim.height}; }
+};
+template<>
+struct Rotation<DXGI_MODE_ROTATION_ROTATE270> {
+    static constexpr auto order = std::array{1, 2, 3, 0};
+    static constexpr auto negate = std::array{false, true, false, true};
+    static constexpr auto offset(Dimension dim) { return std::array{0, dim.width, 0, dim.width}; }
+};
+
+#ifdef CORE_RECT_TRANSFORM_SSE2
+
+template<class R>
+struct Kernel {
+    static constexpr auto shuffle = R::order[0] | (R::order[1] << 2) | (R::order[2] << 4) | (R::order[3] << 6);
+
+    explicit Kernel(Dimension spaceDim) {
+        const auto offsets = R::offset(spaceDim);
+        m_offset = _mm_setr_epi32(offsets[0], offsets[1], offsets[2], offsets[3]);
+        m_negate = _mm_setr_epi32(-int{R::negate[0]}, -int{R::negate[1]}, -int{R::negate[2]}, -int{R::negate[3]});
+    }
+
+    auto load(const RECT &rect) const -> __m128i {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&rect));
+        const auto ordered = _mm_shuffle_epi32(value, shuffle);
+        // (v ^ -1) - (-1) == -v
+        return _mm_add_epi32(_mm_sub_epi32(_mm_xor_si128(ordered, m_negate), m_negate), m_offset);
+    }
+
+private:
+    __m128i m_offset;
+    __m128i m_negate;
+};
+
+template<class R>
+void rotateRectsFor(std::span<const RECT> rects, Dimension spaceDim, RECT *out) {
+    const auto kernel = Kernel<R>{spaceDim};
+    for (const auto &rect : rects) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out++), kernel.load(rect));
+    }
+}
+
+template<class R>
+void emitQuadVerticesFor(
+    std::span<const RECT> rects, Dimension spaceDim, const VertexTransform &transform, QuadVertices *out) {
+    const auto kernel = Kernel<R>{spaceDim};
+    const auto &[psx, psy] = transform.positionScale;
+    const auto &[pox, poy] = transform.positionOffset;
+    const auto &[tsx, tsy] = transform.textureScale;
+    const auto positionScale = _mm_setr_ps(psx, psy, psx, psy);
+    const auto positionOffset = _mm_setr_ps(pox, poy, pox, poy);
+    const auto textureScale = _mm_setr_ps(tsx, tsy, tsx, tsy);
+    for (const auto &rect : rects) {
+        const auto coords = _mm_cvtepi32_ps(kernel.load(rect)); // left, top, right, bottom
+        const auto position = _mm_add_ps(_mm_mul_ps(coords, positionScale), positionOffset);
+        const auto texture = _mm_mul_ps(coords, textureScale);
+        // vertex of column x and row y is (position[x], position[y], texture[x], texture[y])
+        const auto leftBottom = _mm_shuffle_ps(position, texture, _MM_SHUFFLE(3, 0, 3, 0));
+        const auto leftTop = _mm_shuffle_ps(position, texture, _MM_SHUFFLE(1, 0, 1, 0));
+        const auto rightBottom = _mm_shuffle_ps(position, texture, _MM_SHUFFLE(3, 2, 3, 2));
+        const auto rightTop = _mm_shuffle_ps(position, texture, _MM_SHUFFLE(1, 2, 1, 2));
+        auto *vertices = reinterpret_cast<float *>(out++->data());
+        _mm_storeu_ps(vertices + 0, leftBottom);
+        _mm_storeu_ps(vertices + 4, leftTop);
+        _mm_storeu_ps(vertices + 8, rightBottom);
+        _mm_storeu_ps(vertices + 12, rightBottom);
+        _mm_storeu_ps(vertices + 16, leftTop);
+        _mm_storeu_ps(vertices + 20, rightTop);
+    }
+}
+
+template<class R>
+void emitQuadInstancesFor(std::span<const RECT> rects, Dimension spaceDim, QuadInstance *out) {
+    const auto kernel = Kernel<R>{spaceDim};
+    for (const auto &rect : rects) {
+        _mm_storeu_ps(&out++->left, _mm_cvtepi32_ps(kernel.load(rect)));
+    }
+}
+
+#else
+
+template<class R>
+auto rotateRect(const RECT &rect, const std::array<int, 4> &offset) -> std::array<int, 4> {
+    const auto in = std::array<int, 4>{rect.left, rect.top, rect.right, rect.bottom};
+    auto out = std::array<int, 4>{};
+    for (auto i = 0; i < 4; ++i) out[i] = R::negate[i] ? offset[i] - in[R::order[i]] : in[R::order[i]];
+    return out;
+}
+
+template<class R>
+void rotateRectsFor(std::span<const RECT> rects, Dimension spaceDim, RECT *out) {
+    const auto offset = R::offset(spaceDim);
+    for (const auto &rect : rects) {
+        const auto [left, top, right, bottom] = rotateRect<R>(rect, offset);
+        *out++ = RECT{left, top, right, bottom};
+    }
+}
+
+template<class R>
+void emitQuadVerticesFor(
+    std::span<const RECT> rects, Dimension spaceDim, const VertexTransform &transform, QuadVertices *out) {
+    const auto offset = R::offset(spaceDim);
+    for (const auto &rect : rects) {
+        const auto [left, top, right, bottom] = rotateRect<R>(rect, offset);
+        auto &vertices = *out++;
+        vertices[0] = transform.vertex(left, bottom);
+        vertices[1] = transform.vertex(left, top);
+        vertices[2] = transform.vertex(right, bottom);
+        vertices[3] = vertices[2];
+        vertices[4] = vertices[1];
+        vertices[5] = transform.vertex(right, top);
+    }
+}
+
+template<class R>
+void emitQuadInstancesFor(std::span<const RECT> rects, Dimension spaceDim, QuadInstance *out) {
+    const auto offset = R::offset(spaceDim);
+    for (const auto &rect : rects) {
+        const auto [left, top, right, bottom] = rotateRect<R>(rect, offset);
+        *out++ = QuadInstance{
+            static_cast<float>(left),
+            static_cast<float>(top),
+            static_cast<float>(right),
+            static_cast<float>(bottom),
+        };
+    }
+}
+
+#endif
+
+template<class Functor>
+void dispatch(DXGI_MODE_ROTATION rotation, Functor &&functor) {
+    switch (rotation) {
+    case DXGI_MODE_ROTATION_UNSPECIFIED:
+    case DXGI_MODE_ROTATION_IDENTITY: return functor(Rotation<DXGI_MODE_ROTATION_IDENTITY>{});
+    case DXGI_MODE_ROTATION_ROTATE90: return functor(Rotation<DXGI_MODE_ROTATION_ROTATE90>{});
+    case DXGI_MODE_ROTATION_ROTATE180: return functor(Rotation<DXGI_MODE_ROTATION_ROTATE180>{});
+    case DXGI_MODE_ROTATION_ROTATE270: return functor(Rotation<DXGI_MODE_ROTATION_ROTATE270>{});
+    default: return;
+    }
+}
+
+} // namespace
+
+auto VertexTransform::make(Dimension targetDim, Point targetOffset, Dimension textureDim) -> VertexTransform {
+    const auto center_x = targetDim.width / 2;
+    const auto center_y = targetDim.height / 2;
+    return {
+        .positionScale = {1.0f / static_cast<float>(center_x), -1.0f / static_cast<float>(center_y)},
+        .positionOffset =
+            {
+                static_cast<float>(targetOffset.x - center_x) / static_cast<float>(center_x),
+                static_cast<float>(center_y - targetOffset.y) / static_cast<float>(center_y),
+            },
+        .textureScale = {1.0f / static_cast<float>(textureDim.width), 1.0f / static_cast<float>(textureDim.height)},
+    };
+}
+
+void rotateRects(std::span<const RECT> rects, DXGI_MODE_ROTATION rotation, Dimension spaceDim, std::span<RECT> out) {
+    if (out.size() < rects.size()) return;
+    dispatch(rotation, [&]<class R>(R) { rotateRectsFor<R>(rects, spaceDim, out.data()); });
+}
+
+void emitQuadVertices(
+    std::span<const RECT> rects,
+    DXGI_MODE_ROTATION rotation,
+    Dimension spaceDim,
+    const VertexTransform &transform,
+    std::span<QuadVertices> out) {
+    if (out.size() < rects.size()) return;
+    dispatch(rotation, [&]<class R>(R) { emitQuadVerticesFor<R>(rects, spaceDim, transform, out.data()); });
+}
+
+void emitQuadInstances(
+    std::span<const RECT> rects, DXGI_MODE_ROTATION rotation, Dimension spaceDim, std::span<QuadInstance> out) {
+    if (out.size() < rects.size()) return;
+    dispatch(rotation, [&]<class R>(R) { emitQuadInstancesFor<R>(rects, spaceDim, out.data()); });
+}
+
+} // namespace core
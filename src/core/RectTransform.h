@@ -0,0 +1,98 @@
+#pragma once
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+#include <array>
+#include <span>
+#include <stddef.h>
+
+namespace core {
+
+using win32::Dimension;
+using win32::Point;
+
+/// vertex with position in normalized device coordinates and texture coordinates
+/// note: layout of the vertex shader input
+struct Vertex {
+    float x{};
+    float y{};
+    float u{};
+    float v{};
+};
+/// two triangles covering a rect
+using QuadVertices = std::array<Vertex, 6>;
+
+/// maps rotated image coordinates to vertices
+/// note: divisions are computed once (vertex = coordinate * scale + offset)
+struct VertexTransform {
+    std::array<float, 2> positionScale{};
+    std::array<float, 2> positionOffset{};
+    std::array<float, 2> textureScale{};
+
+    bool operator==(const VertexTransform &) const = default;
+
+    /// targetDim - render target the quads are drawn to
+    /// targetOffset - position of the image in the render target
+    /// textureDim - dimension of the sampled image
+    static auto make(Dimension targetDim, Point targetOffset, Dimension textureDim) -> VertexTransform;
+
+    auto vertex(int x, int y) const -> Vertex {
+        return {
+            static_cast<float>(x) * positionScale[0] + positionOffset[0],
+            static_cast<float>(y) * positionScale[1] + positionOffset[1],
+            static_cast<float>(x) * textureScale[0],
+            static_cast<float>(y) * textureScale[1],
+        };
+    }
+};
+
+/// per instance data to draw a rect with the shared unit quad
+/// note: coordinates of the rotated display image, the VertexTransform is applied by the vertex shader
+struct QuadInstance {
+    float left{};
+    float top{};
+    float right{};
+    float bottom{};
+};
+
+/// corners of the shared unit quad (two triangles like QuadVertices)
+constexpr auto unitQuadCorners = std::array<std::array<float, 2>, 6>{{
+    {0.0f, 1.0f},
+    {0.0f, 0.0f},
+    {1.0f, 1.0f},
+    {1.0f, 1.0f},
+    {0.0f, 0.0f},
+    {1.0f, 0.0f},
+}};
+
+/// capacity for a growing instance buffer that has to hold required instances
+/// note: grows in powers of two to avoid reallocation for every larger frame, never shrinks
+constexpr auto instanceCapacityFor(size_t required, size_t current) -> size_t {
+    if (required <= current) return current;
+    auto capacity = size_t{256};
+    while (capacity < required) capacity *= 2;
+    return capacity;
+}
+
+/// transform desktop rects into the coordinates of the rotated display image
+/// note:
+/// * same result as rotate(Rect, …) for each rect
+/// * the rotation is dispatched once for the whole batch
+/// * out has to be at least as large as rects
+void rotateRects(std::span<const RECT> rects, DXGI_MODE_ROTATION, Dimension spaceDim, std::span<RECT> out);
+
+/// emit the vertices for the rotated quads of all rects
+/// note: out has to be at least as large as rects
+void emitQuadVertices(
+    std::span<const RECT> rects,
+    DXGI_MODE_ROTATION,
+    Dimension spaceDim,
+    const VertexTransform &,
+    std::span<QuadVertices> out);
+
+/// emit one instance for the rotated quad of each rect
+/// note: out has to be at least as large as rects
+void emitQuadInstances(
+    std::span<const RECT> rects, DXGI_MODE_ROTATION, Dimension spaceDim, std::span<QuadInstance> out);
+
+} // namespace core
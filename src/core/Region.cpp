@@ -0,0 +1,338 @@
+#include "Region.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace core {
+
+namespace {
+
+using Rects = std::span<const Rect>;
+
+auto makeRect(int left, int top, int right, int bottom) -> Rect {
+    return Rect{Point{left, top}, win32::Dimension{right - left, bottom - top}};
+}
+
+bool overlaps(Rect const &a, Rect const &b) {
+    return a.left() < b.right() && b.left() < a.right() && a.top() < b.bottom() && b.top() < a.bottom();
+}
+
+bool isInside(Rect const &outer, Rect const &inner) {
+    return outer.left() <= inner.left() && outer.top() <= inner.top() && outer.right() >= inner.right() &&
+           outer.bottom() >= inner.bottom();
+}
+
+/// end of the band that starts at begin
+auto bandEnd(Rects rects, size_t begin) -> size_t {
+    auto end = begin + 1;
+    while (end < rects.size() && rects[end].top() == rects[begin].top()) end++;
+    return end;
+}
+
+/// appends bands and merges each band with the previous one if they are vertically adjacent and equal
+struct BandWriter {
+    std::vector<Rect> &out;
+    size_t previousBand{};
+    size_t currentBand{};
+    bool hasPrevious{};
+
+    void begin() { currentBand = out.size(); }
+    void add(int left, int right, int top, int bottom) {
+        if (currentBand < out.size() && out.back().right() == left) {
+            out.back().dimension.width = right - out.back().left(); // touching parts of one band
+            return;
+        }
+        out.push_back(makeRect(left, top, right, bottom));
+    }
+    void finish() {
+        const auto count = out.size() - currentBand;
+        if (count == 0) return;
+        if (hasPrevious && canMerge(count)) {
+            const auto bottom = out[currentBand].bottom();
+            for (auto i = previousBand; i < currentBand; ++i) {
+                out[i].dimension.height = bottom - out[i].top();
+            }
+            out.resize(currentBand);
+            return;
+        }
+        previousBand = currentBand;
+        hasPrevious = true;
+    }
+
+private:
+    bool canMerge(size_t count) const {
+        if (currentBand - previousBand != count) return false;
+        if (out[previousBand].bottom() != out[currentBand].top()) return false;
+        for (auto i = size_t{}; i < count; ++i) {
+            const auto &a = out[previousBand + i];
+            const auto &b = out[currentBand + i];
+            if (a.left() != b.left() || a.right() != b.right()) return false;
+        }
+        return true;
+    }
+};
+
+void appendBand(BandWriter &writer, Rects band, int top, int bottom) {
+    writer.begin();
+    for (const auto &rect : band) writer.add(rect.left(), rect.right(), top, bottom);
+    writer.finish();
+}
+
+void unionBand(BandWriter &writer, Rects a, Rects b, int top, int bottom) {
+    writer.begin();
+    auto i = size_t{};
+    auto j = size_t{};
+    auto left = 0;
+    auto right = 0;
+    auto hasPending = false;
+    while (i < a.size() || j < b.size()) {
+        const auto takeA = j == b.size() || (i < a.size() && a[i].left() < b[j].left());
+        const auto &next = takeA ? a[i++] : b[j++];
+        if (hasPending && next.left() <= right) {
+            right = std::max(right, next.right());
+            continue;
+        }
+        if (hasPending) writer.add(left, right, top, bottom);
+        left = next.left();
+        right = next.right();
+        hasPending = true;
+    }
+    if (hasPending) writer.add(left, right, top, bottom);
+    writer.finish();
+}
+
+void intersectBand(BandWriter &writer, Rects a, Rects b, int top, int bottom) {
+    writer.begin();
+    auto i = size_t{};
+    auto j = size_t{};
+    while (i < a.size() && j < b.size()) {
+        const auto left = std::max(a[i].left(), b[j].left());
+        const auto right = std::min(a[i].right(), b[j].right());
+        if (left < right) writer.add(left, right, top, bottom);
+        if (a[i].right() < b[j].right()) {
+            i++;
+        }
+        else {
+            j++;
+        }
+    }
+    writer.finish();
+}
+
+void subtractBand(BandWriter &writer, Rects a, Rects b, int top, int bottom) {
+    writer.begin();
+    auto j = size_t{};
+    for (const auto &rect : a) {
+        auto left = rect.left();
+        const auto right = rect.right();
+        while (j < b.size() && b[j].right() <= left) j++;
+        for (auto k = j; k < b.size() && b[k].left() < right; ++k) {
+            if (b[k].left() > left) writer.add(left, b[k].left(), top, bottom);
+            left = std::max(left, b[k].right());
+            if (left >= right) break;
+        }
+        if (left < right) writer.add(left, right, top, bottom);
+    }
+    writer.finish();
+}
+
+using BandOp = void (*)(BandWriter &, Rects, Rects, int, int);
+
+/// walks the bands of both regions and applies op where both overlap vertically
+/// note: appendA/appendB keep the parts of a/b that have no vertical counterpart
+void combine(Rects a, Rects b, BandOp op, bool appendA, bool appendB, std::vector<Rect> &out) {
+    out.clear();
+    auto writer = BandWriter{out};
+    auto i = size_t{};
+    auto j = size_t{};
+    auto bottom = std::min(a.front().top(), b.front().top()); // everything above is done
+    while (i < a.size() && j < b.size()) {
+        const auto aEnd = bandEnd(a, i);
+        const auto bEnd = bandEnd(b, j);
+        const auto aTop = std::max(a[i].top(), bottom);
+        const auto bTop = std::max(b[j].top(), bottom);
+        auto top = aTop;
+        if (aTop < bTop) {
+            const auto end = std::min(a[i].bottom(), bTop);
+            if (appendA) appendBand(writer, a.subspan(i, aEnd - i), aTop, end);
+            top = bTop;
+        }
+        else if (bTop < aTop) {
+            const auto end = std::min(b[j].bottom(), aTop);
+            if (appendB) appendBand(writer, b.subspan(j, bEnd - j), bTop, end);
+            top = aTop;
+        }
+        bottom = std::min(a[i].bottom(), b[j].bottom());
+        if (bottom > top) op(writer, a.subspan(i, aEnd - i), b.subspan(j, bEnd - j), top, bottom);
+        if (a[i].bottom() <= bottom) i = aEnd;
+        if (b[j].bottom() <= bottom) j = bEnd;
+    }
+    const auto appendRest = [&](Rects rects, size_t index) {
+        while (index < rects.size()) {
+            const auto end = bandEnd(rects, index);
+            const auto top = std::max(rects[index].top(), bottom);
+            appendBand(writer, rects.subspan(index, end - index), top, rects[index].bottom());
+            index = end;
+        }
+    };
+    if (appendA) appendRest(a, i);
+    if (appendB) appendRest(b, j);
+}
+
+/// scratch storage for results, swapped with the storage of the result region
+auto scratch() -> std::vector<Rect> & {
+    thread_local auto rects = std::vector<Rect>{};
+    return rects;
+}
+
+} // namespace
+
+Region::Region(Rect rect) {
+    if (rect.width() > 0 && rect.height() > 0) m_extents = rect;
+}
+
+auto Region::fromRects(std::span<const Rect> rects) -> Region {
+    auto parts = std::vector<Region>{};
+    parts.reserve(rects.size());
+    for (const auto &rect : rects) {
+        if (rect.width() > 0 && rect.height() > 0) parts.emplace_back(rect);
+    }
+    if (parts.empty()) return {};
+    // merge pairs of similar size to avoid quadratic costs
+    while (parts.size() > 1) {
+        const auto half = (parts.size() + 1) / 2;
+        for (auto i = size_t{}; i < parts.size() / 2; ++i) {
+            parts[i] = std::move(parts[2 * i]) | parts[2 * i + 1];
+        }
+        if (parts.size() % 2 != 0) parts[half - 1] = std::move(parts.back());
+        parts.resize(half);
+    }
+    return std::move(parts.front());
+}
+
+auto Region::rects() const -> std::span<const Rect> {
+    if (!m_rects.empty()) return m_rects;
+    if (isEmpty()) return {};
+    return {&m_extents, 1};
+}
+
+auto Region::area() const -> int64_t {
+    auto result = int64_t{};
+    for (const auto &rect : rects()) result += static_cast<int64_t>(rect.width()) * rect.height();
+    return result;
+}
+
+bool Region::contains(Point point) const {
+    if (!m_extents.contains(point)) return false;
+    const auto all = rects();
+    auto it = std::partition_point(all.begin(), all.end(), [&](Rect const &r) { return r.bottom() <= point.y; });
+    for (; it != all.end() && it->top() <= point.y; ++it) {
+        if (it->contains(point)) return true;
+    }
+    return false;
+}
+
+bool Region::contains(Rect const &rect) const {
+    if (rect.width() <= 0 || rect.height() <= 0) return true;
+    if (!isInside(m_extents, rect)) return false;
+    if (m_rects.empty()) return true;
+    return (Region{rect} -= *this).isEmpty();
+}
+
+bool Region::intersects(Rect const &rect) const {
+    if (rect.width() <= 0 || rect.height() <= 0 || !overlaps(m_extents, rect)) return false;
+    const auto all = rects();
+    auto it = std::partition_point(all.begin(), all.end(), [&](Rect const &r) { return r.bottom() <= rect.top(); });
+    for (; it != all.end() && it->top() < rect.bottom(); ++it) {
+        if (overlaps(*it, rect)) return true;
+    }
+    return false;
+}
+
+void Region::clear() {
+    m_extents = {};
+    m_rects.clear();
+}
+
+void Region::translate(Point delta) {
+    if (isEmpty()) return;
+    m_extents.topLeft = {m_extents.left() + delta.x, m_extents.top() + delta.y};
+    for (auto &rect : m_rects) rect.topLeft = {rect.left() + delta.x, rect.top() + delta.y};
+}
+
+auto Region::operator|=(Region const &other) -> Region & {
+    if (other.isEmpty() || this == &other) return *this;
+    if (isEmpty() || (other.m_rects.empty() && isInside(other.m_extents, m_extents))) return *this = other;
+    if (m_rects.empty() && isInside(m_extents, other.m_extents)) return *this;
+    auto &out = scratch();
+    combine(rects(), other.rects(), &unionBand, true, true, out);
+    assign(out);
+    return *this;
+}
+
+auto Region::operator&=(Region const &other) -> Region & {
+    if (this == &other) return *this;
+    if (isEmpty() || other.isEmpty() || !overlaps(m_extents, other.m_extents)) {
+        clear();
+        return *this;
+    }
+    if (m_rects.empty() && other.m_rects.empty()) {
+        const auto left = std::max(m_extents.left(), other.m_extents.left());
+        const auto top = std::max(m_extents.top(), other.m_extents.top());
+        const auto right = std::min(m_extents.right(), other.m_extents.right());
+        const auto bottom = std::min(m_extents.bottom(), other.m_extents.bottom());
+        m_extents = makeRect(left, top, right, bottom);
+        return *this;
+    }
+    if (other.m_rects.empty() && isInside(other.m_extents, m_extents)) return *this;
+    if (m_rects.empty() && isInside(m_extents, other.m_extents)) return *this = other;
+    auto &out = scratch();
+    combine(rects(), other.rects(), &intersectBand, false, false, out);
+    assign(out);
+    return *this;
+}
+
+auto Region::operator-=(Region const &other) -> Region & {
+    if (this == &other) {
+        clear();
+        return *this;
+    }
+    if (isEmpty() || other.isEmpty() || !overlaps(m_extents, other.m_extents)) return *this;
+    if (other.m_rects.empty() && isInside(other.m_extents, m_extents)) {
+        clear();
+        return *this;
+    }
+    auto &out = scratch();
+    combine(rects(), other.rects(), &subtractBand, true, false, out);
+    assign(out);
+    return *this;
+}
+
+bool Region::operator==(Region const &other) const {
+    const auto a = rects();
+    const auto b = other.rects();
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+/// takes the rects and leaves the previous storage in rects for reuse
+void Region::assign(std::vector<Rect> &rects) {
+    if (rects.empty()) {
+        clear();
+        return;
+    }
+    if (rects.size() == 1) {
+        m_extents = rects.front();
+        m_rects.clear();
+        return;
+    }
+    auto left = rects.front().left();
+    auto right = rects.front().right();
+    for (const auto &rect : rects) {
+        left = std::min(left, rect.left());
+        right = std::max(right, rect.right());
+    }
+    m_extents = makeRect(left, rects.front().top(), right, rects.back().bottom());
+    std::swap(m_rects, rects);
+}
+
+} // namespace core
@@ -0,0 +1,61 @@
+#pragma once
+#include "win32/Geometry.h"
+
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+using win32::Point;
+using win32::Rect;
+
+/// Set of pixels stored as y-x banded rects (like X11 or pixman regions)
+/// note:
+/// * rects are sorted by top, then left
+/// * rects of one band share top and bottom and neither overlap nor touch
+/// * vertically adjacent bands with identical rects are merged
+/// * a region of one rect does not allocate
+struct Region {
+    Region() = default;
+    explicit Region(Rect rect);
+
+    /// region covering all the rects (they may overlap)
+    static auto fromRects(std::span<const Rect> rects) -> Region;
+
+    bool isEmpty() const { return m_extents.width() <= 0; }
+    /// smallest rect that contains the whole region
+    auto extents() const -> Rect const & { return m_extents; }
+    auto rects() const -> std::span<const Rect>;
+    auto size() const -> size_t { return rects().size(); }
+    auto area() const -> int64_t;
+
+    bool contains(Point) const;
+    /// true if every pixel of rect is part of the region
+    bool contains(Rect const &) const;
+    /// true if any pixel of rect is part of the region
+    bool intersects(Rect const &) const;
+
+    void clear();
+    void translate(Point delta);
+
+    auto operator|=(Region const &) -> Region &; ///< union
+    auto operator&=(Region const &) -> Region &; ///< intersection
+    auto operator-=(Region const &) -> Region &; ///< subtraction
+
+    friend auto operator|(Region a, Region const &b) -> Region { return a |= b; }
+    friend auto operator&(Region a, Region const &b) -> Region { return a &= b; }
+    friend auto operator-(Region a, Region const &b) -> Region { return a -= b; }
+
+    bool operator==(Region const &) const;
+
+private:
+    void assign(std::vector<Rect> &rects);
+
+private:
+    Rect m_extents{};
+    std::vector<Rect> m_rects{}; // empty if the region is a single rect (m_extents)
+};
+
+} // namespace core
@@ -0,0 +1,55 @@
+#pragma once
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+namespace core {
+
+using win32::Dimension;
+using win32::Point;
+using win32::Rect;
+
+/// transform a rect from desktop coordinates into the coordinates of the rotated display image
+/// note: spaceDim is the dimension of the desktop (unrotated)
+constexpr auto rotate(Rect rect, DXGI_MODE_ROTATION rotation, Dimension spaceDim) noexcept -> Rect {
+    switch (rotation) {
+    case DXGI_MODE_ROTATION_UNSPECIFIED:
+    case DXGI_MODE_ROTATION_IDENTITY: return rect;
+    case DXGI_MODE_ROTATION_ROTATE90:
+        return {
+            Point{spaceDim.height - rect.bottom(), rect.left()},
+            Dimension{rect.height(), rect.width()},
+        };
+    case DXGI_MODE_ROTATION_ROTATE180:
+        return {
+            Point{spaceDim.width - rect.right(), spaceDim.height - rect.bottom()},
+            rect.dimension,
+        };
+    case DXGI_MODE_ROTATION_ROTATE270:
+        return {
+            Point{rect.top(), spaceDim.width - rect.right()},
+            Dimension{rect.height(), rect.width()},
+        };
+    default: return {};
+    }
+}
+
+/// dimension of the display image for a desktop of spaceDim
+constexpr auto rotate(Dimension spaceDim, DXGI_MODE_ROTATION rotation) noexcept -> Dimension {
+    switch (rotation) {
+    case DXGI_MODE_ROTATION_ROTATE90:
+    case DXGI_MODE_ROTATION_ROTATE270: return {spaceDim.height, spaceDim.width};
+    default: return spaceDim;
+    }
+}
+
+/// rotation that transforms rects of the display image back into desktop coordinates
+/// note: use the dimension of the image as spaceDim
+constexpr auto inverse(DXGI_MODE_ROTATION rotation) noexcept -> DXGI_MODE_ROTATION {
+    switch (rotation) {
+    case DXGI_MODE_ROTATION_ROTATE90: return DXGI_MODE_ROTATION_ROTATE270;
+    case DXGI_MODE_ROTATION_ROTATE270: return DXGI_MODE_ROTATION_ROTATE90;
+    default: return rotation;
+    }
+}
+
+} // namespace core
@@ -0,0 +1,215 @@
+#include "ScrollDetector.h"
+
+#include "Hash.h"
+#include "PixelCopy.h"
+#include "RectCoalescer.h"
+#include "Rotation.h"
+#include "VisibleAreaCuller.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <ranges>
+
+namespace core {
+namespace {
+
+void hashRows(SurfaceView surface, Rect const &rect, std::vector<uint64_t> &hashes) {
+    const auto rowBytes = static_cast<size_t>(rect.width()) * bytesPerPixel;
+    hashes.resize(static_cast<size_t>(rect.height()));
+    for (auto y = 0; y < rect.height(); ++y) {
+        hashes[y] = hashBytes({surface.pixel({rect.left(), rect.top() + y}), rowBytes});
+    }
+}
+
+/// columns are hashed row by row, so memory is read in order
+void hashColumns(SurfaceView surface, Rect const &rect, std::vector<uint64_t> &hashes) {
+    constexpr auto prime = uint64_t{0x9E3779B185EBCA87};
+    hashes.assign(static_cast<size_t>(rect.width()), prime);
+    for (auto y = rect.top(); y < rect.bottom(); ++y) {
+        const auto *pixels = surface.pixel({rect.left(), y});
+        for (auto x = 0; x < rect.width(); ++x) {
+            auto pixel = uint32_t{};
+            std::memcpy(&pixel, pixels + static_cast<ptrdiff_t>(x) * bytesPerPixel, sizeof(pixel));
+            hashes[x] = (std::rotl(hashes[x], 5) ^ pixel) * prime;
+        }
+    }
+}
+
+} // namespace
+
+void ScrollDetector::reset(Dimension desktop, DXGI_MODE_ROTATION rotation) {
+    m_desktop = desktop;
+    m_rotation = rotation;
+    m_shadow = Surface{rotate(desktop, rotation)};
+    m_shadowArea = Rect{{}, m_shadow.dimension()};
+    m_isShadowValid = false;
+}
+
+void ScrollDetector::setVisibleArea(Rect const &desktopRect) {
+    m_shadowArea = toImage(desktopRect).value_or(Rect{});
+    m_isShadowValid = false;
+}
+
+void ScrollDetector::detect(SurfaceView image, std::span<const MoveRect> moved, std::span<const Rect> dirty) {
+    m_stats.frames++;
+    m_moved.assign(moved.begin(), moved.end());
+    m_dirty.clear();
+    for (const auto &rect : dirty) m_stats.inputArea += area(rect);
+
+    const auto canSearch = image && image.dimension == m_shadow.dimension() && m_isShadowValid && moved.empty();
+    const auto searchStart = std::chrono::steady_clock::now();
+    m_isScrolled.assign(dirty.size(), false);
+    for (auto i = size_t{}; canSearch && i < dirty.size(); ++i) {
+        const auto &rect = dirty[i];
+        const auto imageRect = toImage(rect);
+        const auto isLarge = imageRect && std::min(imageRect->width(), imageRect->height()) >= m_config.minExtent &&
+            containsRect(m_shadowArea, *imageRect);
+        // note: moves run one after another - a searched rect must not overlap another move
+        const auto isSeparate = isLarge && std::ranges::none_of(dirty, [&](Rect const &other) {
+            return &other != &rect && intersect(other, rect).has_value() &&
+                (!containsRect(rect, other) || containsRect(other, rect));
+        });
+        if (!isSeparate) continue;
+        m_stats.searchedRects++;
+        m_isScrolled[i] = search(image, *imageRect);
+    }
+    if (std::ranges::find(m_isScrolled, true) == m_isScrolled.end()) {
+        m_dirty.assign(dirty.begin(), dirty.end());
+    }
+    else {
+        // rects inside of a scrolled rect are reproduced by the move and its strips
+        for (auto i = size_t{}; i < dirty.size(); ++i) {
+            const auto isCovered = [&](size_t j) { return m_isScrolled[j] && containsRect(dirty[j], dirty[i]); };
+            if (std::ranges::none_of(std::views::iota(size_t{}, dirty.size()), isCovered)) m_dirty.push_back(dirty[i]);
+        }
+    }
+    if (canSearch) m_stats.searchTime += std::chrono::steady_clock::now() - searchStart;
+    for (const auto &rect : m_dirty) m_stats.outputArea += area(rect);
+
+    updateShadow(image, moved, dirty);
+}
+
+auto ScrollDetector::toImage(Rect const &desktopRect) const -> std::optional<Rect> {
+    return intersect(rotate(desktopRect, m_rotation, m_desktop), Rect{{}, m_shadow.dimension()});
+}
+
+auto ScrollDetector::toDesktop(Rect const &imageRect) const -> Rect {
+    return rotate(imageRect, inverse(m_rotation), m_shadow.dimension());
+}
+
+bool ScrollDetector::search(SurfaceView image, Rect const &rect) {
+    const auto shadow = m_shadow.view();
+    hashRows(shadow, rect, m_before);
+    hashRows(image, rect, m_after);
+    if (const auto shift = findShift(m_before, m_after); shift) {
+        if (shift->offset == 0) return false; // most of the content stayed
+        const auto rows = Dimension{rect.width(), shift->end - shift->begin};
+        const auto destination = Rect{{rect.left(), rect.top() + shift->begin}, rows};
+        addScroll(rect, destination, Point{rect.left(), destination.top() - shift->offset});
+        return true;
+    }
+    hashColumns(shadow, rect, m_before);
+    hashColumns(image, rect, m_after);
+    if (const auto shift = findShift(m_before, m_after); shift && shift->offset != 0) {
+        const auto columns = Dimension{shift->end - shift->begin, rect.height()};
+        const auto destination = Rect{{rect.left() + shift->begin, rect.top()}, columns};
+        addScroll(rect, destination, Point{destination.left() - shift->offset, rect.top()});
+        return true;
+    }
+    return false;
+}
+
+auto ScrollDetector::findShift(std::span<const uint64_t> before, std::span<const uint64_t> after)
+    -> std::optional<Shift> {
+    const auto count = static_cast<int>(before.size());
+    m_sorted.clear();
+    for (auto i = 0; i < count; ++i) m_sorted.emplace_back(before[i], i);
+    std::ranges::sort(m_sorted);
+
+    // every row votes for the offsets to the equal old rows (offset 0 wins for unchanged content)
+    m_votes.assign(static_cast<size_t>(2 * count + 1), 0);
+    for (auto i = 0; i < count; ++i) {
+        const auto [first, last] = std::ranges::equal_range(m_sorted, after[i], {}, &std::pair<uint64_t, int>::first);
+        if (first == last || static_cast<size_t>(last - first) > m_config.maxCandidates) continue;
+        for (auto it = first; it != last; ++it) {
+            m_votes[i - it->second + count]++;
+        }
+    }
+    const auto best = std::ranges::max_element(m_votes);
+    if (*best == 0) return {};
+    const auto offset = static_cast<int>(best - m_votes.begin()) - count;
+
+    // longest run of rows that are shifted by offset
+    auto shift = Shift{.offset = offset};
+    for (auto i = std::max(offset, 0); i < std::min(count, count + offset);) {
+        if (after[i] != before[i - offset]) {
+            ++i;
+            continue;
+        }
+        auto end = i + 1;
+        while (end < count + std::min(offset, 0) && after[end] == before[end - offset]) ++end;
+        if (end - i > shift.end - shift.begin) {
+            shift.begin = i;
+            shift.end = end;
+        }
+        i = end;
+    }
+    if ((shift.end - shift.begin) * 100 < m_config.minShiftedPercent * count) return {};
+    return shift;
+}
+
+void ScrollDetector::addScroll(Rect const &rect, Rect const &destination, Point source) {
+    m_stats.scrolls++;
+    m_moved.push_back(MoveRect{
+        .SourcePoint = toDesktop(Rect{source, destination.dimension}).topLeft.toPOINT(),
+        .DestinationRect = toDesktop(destination).toRECT(),
+    });
+    // remaining strips of rect around the destination
+    const auto addDirty = [&](Point topLeft, Dimension dimension) {
+        if (dimension.width > 0 && dimension.height > 0) m_dirty.push_back(toDesktop(Rect{topLeft, dimension}));
+    };
+    addDirty(rect.topLeft, {rect.width(), destination.top() - rect.top()});
+    addDirty({rect.left(), destination.bottom()}, {rect.width(), rect.bottom() - destination.bottom()});
+    addDirty({rect.left(), destination.top()}, {destination.left() - rect.left(), destination.height()});
+    addDirty({destination.right(), destination.top()}, {rect.right() - destination.right(), destination.height()});
+}
+
+void ScrollDetector::updateShadow(SurfaceView image, std::span<const MoveRect> moved, std::span<const Rect> dirty) {
+    if (!image || image.dimension != m_shadow.dimension()) {
+        if (!moved.empty() || !dirty.empty()) m_isShadowValid = false;
+        return;
+    }
+    if (!moved.empty()) {
+        m_shadowMoves.clear();
+        for (const auto &move : moved) {
+            const auto destination = Rect::fromRECT(move.DestinationRect);
+            const auto source = Rect{Point::fromPOINT(move.SourcePoint), destination.dimension};
+            const auto imageSource = rotate(source, m_rotation, m_desktop);
+            const auto imageDestination = rotate(destination, m_rotation, m_desktop);
+            const auto bounds = Rect{{}, m_shadow.dimension()};
+            if (!containsRect(bounds, imageSource) || !containsRect(bounds, imageDestination)) {
+                m_isShadowValid = false;
+                continue;
+            }
+            m_shadowMoves.push_back({imageSource, imageDestination.topLeft});
+        }
+        const auto &plan = m_movePlanner.plan(m_shadowMoves);
+        const auto &tempDim = plan.tempDimension;
+        if (m_moveTmp.dimension().width < tempDim.width || m_moveTmp.dimension().height < tempDim.height) {
+            m_moveTmp = Surface{Dimension{
+                std::max(m_moveTmp.dimension().width, tempDim.width),
+                std::max(m_moveTmp.dimension().height, tempDim.height),
+            }};
+        }
+        executeMovePlan(m_shadow.span(), plan, m_moveTmp.span());
+    }
+    for (const auto &rect : dirty) {
+        const auto imageRect = toImage(rect);
+        if (!imageRect) continue;
+        copyRect(image, *imageRect, m_shadow.span(), imageRect->topLeft);
+        if (containsRect(*imageRect, m_shadowArea)) m_isShadowValid = true;
+    }
+}
+
+} // namespace core
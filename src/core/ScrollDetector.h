@@ -0,0 +1,95 @@
+#pragma once
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+#include "MovePlanner.h"
+#include "Surface.h"
+
+#include <chrono>
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+using win32::Dimension;
+using win32::Point;
+using win32::Rect;
+
+/// Turns large dirty rects with scrolled content into a move and the remaining dirty strips
+/// note:
+/// * all rects are in desktop coordinates, shifts are searched in the rows & columns of the (rotated) display image
+/// * keeps a shadow copy of the last image, so it has to see every frame (only the dirty rects are read)
+/// * searching starts after a frame updated the entire display (the shadow equals what consumers show)
+/// * frames with moves are passed unchanged, dirty rects that partially overlap others are never replaced
+struct ScrollDetector {
+    using MoveRect = DXGI_OUTDUPL_MOVE_RECT;
+    struct Config {
+        int minExtent{64}; ///< dirty rects with a smaller width or height are not searched
+        int minShiftedPercent{50}; ///< rows (or columns) of a dirty rect that have to be shifted
+        size_t maxCandidates{8}; ///< rows with more equal old rows do not vote for a shift (blank lines)
+    };
+    struct Stats {
+        uint64_t frames{};
+        uint64_t searchedRects{};
+        uint64_t scrolls{}; ///< dirty rects replaced with a move
+        int64_t inputArea{}; ///< dirty pixels reported
+        int64_t outputArea{}; ///< dirty pixels after moves were found
+        std::chrono::nanoseconds searchTime{};
+    };
+
+    ScrollDetector() = default;
+    explicit ScrollDetector(Config config)
+        : m_config{config} {}
+
+    /// start over for an output - the shadow is unknown
+    void reset(Dimension desktop, DXGI_MODE_ROTATION rotation);
+    /// only this part of the desktop is updated from now on - the shadow is unknown until it was refreshed
+    void setVisibleArea(Rect const &desktopRect);
+
+    /// replace dirty rects with moves where the content scrolled
+    /// note: image has to be valid inside of dirty (without an image the shadow becomes unknown)
+    void detect(SurfaceView image, std::span<const MoveRect> moved, std::span<const Rect> dirty);
+
+    // results of the last detect - valid until the next call
+    auto moved() const -> std::span<const MoveRect> { return m_moved; }
+    auto dirty() const -> std::span<const Rect> { return m_dirty; }
+
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    struct Shift {
+        int offset{}; // new index - old index
+        int begin{}; // first shifted new index
+        int end{}; // behind the last shifted new index
+    };
+    auto toImage(Rect const &desktopRect) const -> std::optional<Rect>;
+    auto toDesktop(Rect const &imageRect) const -> Rect;
+    bool search(SurfaceView image, Rect const &imageRect);
+    auto findShift(std::span<const uint64_t> before, std::span<const uint64_t> after) -> std::optional<Shift>;
+    void addScroll(Rect const &imageRect, Rect const &destination, Point source);
+    void updateShadow(SurfaceView image, std::span<const MoveRect> moved, std::span<const Rect> dirty);
+
+private:
+    Config m_config{};
+    Dimension m_desktop{};
+    DXGI_MODE_ROTATION m_rotation{DXGI_MODE_ROTATION_IDENTITY};
+    Surface m_shadow{};
+    bool m_isShadowValid{};
+    Rect m_shadowArea{}; // part of the shadow that is kept up to date (image coordinates)
+    Surface m_moveTmp{};
+    MovePlanner m_movePlanner{};
+    std::vector<RectMove> m_shadowMoves{};
+    std::vector<uint64_t> m_before{}; // hashes of the rows or columns in the shadow
+    std::vector<uint64_t> m_after{}; // hashes of the rows or columns in the image
+    std::vector<std::pair<uint64_t, int>> m_sorted{}; // before hashes with their index
+    std::vector<int> m_votes{};
+    std::vector<bool> m_isScrolled{}; // per dirty rect of the frame
+    std::vector<MoveRect> m_moved{};
+    std::vector<Rect> m_dirty{};
+    Stats m_stats{};
+};
+
+} // namespace core
@@ -0,0 +1,126 @@
+#include "SessionReplayer.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace core {
+
+bool SessionReplayer::open(std::filesystem::path const &path) {
+    m_stats = {};
+    m_pacing = Pacing::AsFastAsPossible;
+    if (!m_reader.open(path)) return false;
+    return seek(0);
+}
+
+bool SessionReplayer::seek(size_t position) {
+    const auto updates = m_reader.updates();
+    m_position = std::min(position, updates.size());
+    m_paceOrigin.reset();
+    m_isDamaged = false;
+    m_pointer = {};
+    if (m_position == updates.size()) return true;
+    m_stats.seeks++;
+
+    // note: images never cross sessions - replay starts at the first update or keyframe of the session
+    const auto sessionOffset = updates[m_position].sessionOffset;
+    const auto sessionStart = static_cast<size_t>(
+        std::ranges::lower_bound(updates, sessionOffset, {}, &SessionTrace::IndexEntry::sessionOffset) -
+        updates.begin());
+    if (!read(sessionStart)) return false;
+    m_session = m_reader.session();
+    m_sessionOffset = sessionOffset;
+    m_image.reset(m_session);
+
+    auto start = sessionStart;
+    const auto keyframes = m_reader.keyframes();
+    const auto keyframe = std::ranges::find_if(keyframes.rbegin(), keyframes.rend(), [&](auto const &entry) {
+        return entry.sessionOffset == sessionOffset && entry.position >= sessionStart && entry.position <= m_position;
+    });
+    if (keyframe != keyframes.rend()) {
+        const auto restored = m_reader.readKeyframe(static_cast<size_t>(keyframes.rend() - keyframe) - 1);
+        if (!restored) {
+            m_isDamaged = true;
+            return false;
+        }
+        m_image.restore(*restored);
+        start = static_cast<size_t>(restored->position);
+        m_stats.restoredKeyframes++;
+    }
+    for (auto i = start; i < m_position; ++i) {
+        const auto update = read(i);
+        if (!update) return false;
+        m_image.apply(*update);
+        m_stats.seekUpdates++;
+    }
+    restorePointer(sessionStart);
+    return !m_isDamaged;
+}
+
+bool SessionReplayer::isSessionChange() const {
+    return !isDone() && m_reader.updates()[m_position].sessionOffset != m_sessionOffset;
+}
+
+auto SessionReplayer::next(std::chrono::milliseconds timeout) -> std::optional<Update> {
+    if (isDone() || m_isDamaged || isSessionChange()) return {};
+    const auto update = read(m_position);
+    if (!update) return {};
+
+    const auto due = dueTime(*update);
+    if (due) {
+        if (*due > Clock::now() + timeout) {
+            std::this_thread::sleep_for(timeout);
+            return {};
+        }
+        std::this_thread::sleep_until(*due);
+    }
+    m_image.apply(*update);
+    trackPointer(*update);
+    m_position++;
+    return update;
+}
+
+auto SessionReplayer::read(size_t position) -> std::optional<Update> {
+    auto update = m_reader.read(position);
+    if (!update) m_isDamaged = true;
+    return update;
+}
+
+void SessionReplayer::restorePointer(size_t sessionStart) {
+    auto hasPosition = false;
+    for (auto i = m_position; i > sessionStart && !(hasPosition && !m_pointer.shape.empty()); --i) {
+        const auto update = read(i - 1);
+        if (!update) return;
+        if (!hasPosition && update->pointerUpdateTime != 0) {
+            m_pointer.position = update->pointerPosition;
+            hasPosition = true;
+        }
+        if (m_pointer.shape.empty() && !update->shape.empty()) {
+            m_pointer.shapeInfo = update->shapeInfo;
+            m_pointer.shape = update->shape;
+        }
+    }
+}
+
+void SessionReplayer::trackPointer(Update const &update) {
+    if (update.pointerUpdateTime != 0) m_pointer.position = update.pointerPosition;
+    if (!update.shape.empty()) {
+        m_pointer.shapeInfo = update.shapeInfo;
+        m_pointer.shape = update.shape;
+    }
+}
+
+auto SessionReplayer::dueTime(Update const &update) -> std::optional<Clock::time_point> {
+    if (m_pacing != Pacing::RealTime || m_session.ticksPerSecond <= 0) return {};
+    // note: updates with only pointer changes have no present time
+    const auto ticks = update.presentTime != 0 ? update.presentTime : static_cast<int64_t>(update.pointerUpdateTime);
+    if (ticks == 0) return {};
+    if (!m_paceOrigin) {
+        m_paceOrigin = PaceOrigin{Clock::now(), ticks};
+        return {};
+    }
+    const auto elapsed = std::chrono::duration<double>{
+        static_cast<double>(ticks - m_paceOrigin->ticks) / static_cast<double>(m_session.ticksPerSecond)};
+    return m_paceOrigin->time + std::chrono::duration_cast<Clock::duration>(elapsed);
+}
+
+} // namespace core
@@ -0,0 +1,90 @@
+#pragma once
+#include "SessionTrace.h"
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace core {
+
+/// Replays a memory mapped session trace
+/// note:
+/// * updates are views into the mapping, nothing is copied except the pixels into the reconstructed image
+/// * seek() restores the closest keyframe before the position and applies only the updates after it
+struct SessionReplayer {
+    using Clock = std::chrono::steady_clock;
+    using Session = SessionTrace::Session;
+    using Update = SessionTrace::Update;
+
+    enum class Pacing {
+        AsFastAsPossible, ///< every update is due right away (throughput benchmarks)
+        RealTime, ///< updates are due in the recorded intervals (latency benchmarks)
+    };
+    struct PointerState {
+        DXGI_OUTDUPL_POINTER_POSITION position{};
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO shapeInfo{};
+        std::span<const uint8_t> shape{}; ///< empty if no shape was recorded yet
+    };
+    struct Stats {
+        uint64_t seeks{};
+        uint64_t restoredKeyframes{};
+        uint64_t seekUpdates{}; ///< updates applied to reach the seek positions
+    };
+
+    /// map the trace and seek to the first update - false if it is no session trace
+    bool open(std::filesystem::path const &);
+
+    bool isComplete() const { return m_reader.isComplete(); } ///< see SessionTraceReader
+    auto updateCount() const -> size_t { return m_reader.updates().size(); }
+    auto keyframeCount() const -> size_t { return m_reader.keyframes().size(); }
+
+    auto pacing() const -> Pacing { return m_pacing; }
+    void setPacing(Pacing pacing) {
+        m_pacing = pacing;
+        m_paceOrigin.reset();
+    }
+
+    /// continue the replay with the update at position - false if the trace is damaged
+    /// note: restarts the real time pacing
+    bool seek(size_t position);
+    auto position() const -> size_t { return m_position; } ///< of the next update
+    bool isDone() const { return m_position >= updateCount(); }
+    bool isDamaged() const { return m_isDamaged; }
+    /// the next update belongs to another output (seek to the position to continue)
+    bool isSessionChange() const;
+
+    /// apply and return the next update - nullopt if replay is done, damaged or nothing is due within timeout
+    auto next(std::chrono::milliseconds timeout) -> std::optional<Update>;
+
+    auto session() const -> Session const & { return m_session; }
+    auto image() const -> SurfaceView { return m_image.view(); } ///< after all replayed updates
+    auto pointer() const -> PointerState const & { return m_pointer; } ///< after all replayed updates
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    auto read(size_t position) -> std::optional<Update>;
+    void restorePointer(size_t sessionStart);
+    void trackPointer(Update const &);
+    auto dueTime(Update const &) -> std::optional<Clock::time_point>;
+
+private:
+    SessionTraceReader m_reader{};
+    Pacing m_pacing{Pacing::AsFastAsPossible};
+    size_t m_position{};
+    bool m_isDamaged{};
+    Session m_session{};
+    uint64_t m_sessionOffset{}; // identifies m_session
+    SessionTraceImage m_image{};
+    PointerState m_pointer{};
+    struct PaceOrigin {
+        Clock::time_point time{};
+        int64_t ticks{};
+    };
+    std::optional<PaceOrigin> m_paceOrigin{}; // first timed update since the replay (re)started
+    Stats m_stats{};
+};
+
+} // namespace core
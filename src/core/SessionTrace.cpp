@@ -0,0 +1,498 @@
+#include "SessionTrace.h"
+
+#include "PixelCopy.h"
+#include "Rotation.h"
+#include "VisibleAreaCuller.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace core {
+
+namespace {
+
+using RecordType = SessionTrace::RecordType;
+using RecordHeader = SessionTrace::RecordHeader;
+using IndexEntry = SessionTrace::IndexEntry;
+using KeyframeEntry = SessionTrace::KeyframeEntry;
+
+static_assert(std::endian::native == std::endian::little, "traces are stored little endian");
+static_assert(sizeof(RECT) == 16 && sizeof(DXGI_OUTDUPL_MOVE_RECT) == 24);
+static_assert(sizeof(DXGI_OUTDUPL_POINTER_POSITION) == 12 && sizeof(DXGI_OUTDUPL_POINTER_SHAPE_INFO) == 24);
+static_assert(sizeof(IndexEntry) == 32 && sizeof(KeyframeEntry) == 24);
+
+struct SessionPayload {
+    RECT desktop{};
+    uint32_t rotation{};
+    uint32_t reserved{};
+    int64_t ticksPerSecond{};
+};
+static_assert(sizeof(SessionPayload) == 32);
+
+enum UpdateFlags : uint32_t {
+    RectsCoalesced = 1u << 0,
+    ProtectedContentMaskedOut = 1u << 1,
+    HasImage = 1u << 2,
+};
+
+/// fixed part of the Update payload, followed by the sections (each padded to 8 bytes):
+/// moved rects, dirty rects, image rects, pixels, pointer shape
+struct UpdatePayload {
+    uint64_t sequence{};
+    int64_t presentTime{};
+    uint64_t pointerUpdateTime{};
+    uint32_t frames{};
+    uint32_t flags{};
+    uint32_t movedCount{};
+    uint32_t dirtyCount{};
+    uint32_t imageRectCount{};
+    uint32_t shapeBytes{};
+    uint64_t pixelBytes{};
+    DXGI_OUTDUPL_POINTER_POSITION pointerPosition{};
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO shapeInfo{};
+    uint32_t reserved{};
+};
+static_assert(sizeof(UpdatePayload) == 96);
+
+/// fixed part of the Keyframe payload, followed by the tightly packed rows of the image
+struct KeyframePayload {
+    uint64_t position{};
+    int32_t width{};
+    int32_t height{};
+};
+static_assert(sizeof(KeyframePayload) == 16);
+
+/// fixed part of the Index payload, followed by all IndexEntries and all KeyframeEntries
+struct IndexPayload {
+    uint64_t updateCount{};
+    uint64_t keyframeCount{};
+};
+
+template<class T>
+auto asBytes(T const &value) -> std::span<const uint8_t> {
+    return {std::bit_cast<const uint8_t *>(&value), sizeof(T)};
+}
+
+constexpr auto padded(size_t bytes) -> size_t {
+    return (bytes + SessionTrace::alignment - 1) / SessionTrace::alignment * SessionTrace::alignment;
+}
+
+auto pixelBytes(std::span<const RECT> rects) -> size_t {
+    auto bytes = size_t{};
+    for (const auto &rect : rects) {
+        bytes += static_cast<size_t>(rect.right - rect.left) * static_cast<size_t>(rect.bottom - rect.top);
+    }
+    return bytes * bytesPerPixel;
+}
+
+auto updatePayloadSize(SessionTrace::Update const &update) -> size_t {
+    return sizeof(UpdatePayload) + padded(update.moved.size_bytes()) + padded(update.dirty.size_bytes()) +
+        padded(update.imageRects.size_bytes()) + padded(pixelBytes(update.imageRects)) + padded(update.shape.size());
+}
+
+/// writes sections one after the other
+struct Encoder {
+    std::span<uint8_t> out;
+    size_t offset{};
+
+    void header(RecordType type, size_t payloadBytes) {
+        put(RecordHeader{.type = type, .bytes = payloadBytes});
+    }
+    template<class T>
+    void put(T const &value) {
+        std::memcpy(out.data() + offset, &value, sizeof(T));
+        offset += sizeof(T);
+    }
+    void section(const void *data, size_t bytes) {
+        if (bytes != 0) std::memcpy(out.data() + offset, data, bytes);
+        pad(bytes);
+    }
+    void pad(size_t bytes) {
+        std::memset(out.data() + offset + bytes, 0, padded(bytes) - bytes);
+        offset += padded(bytes);
+    }
+};
+
+/// reads sections one after the other, fails if the payload is too short
+struct Decoder {
+    std::span<const uint8_t> payload;
+    size_t offset{};
+    bool failed{};
+
+    template<class T>
+    auto get() -> T {
+        auto value = T{};
+        if (!has(sizeof(T))) return value;
+        std::memcpy(&value, payload.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+    template<class T>
+    auto section(uint64_t count) -> std::span<const T> {
+        if (count > payload.size() / sizeof(T) || !has(padded(count * sizeof(T)))) return {};
+        // note: records start 8 byte aligned and all sections are padded
+        const auto *data = std::bit_cast<const T *>(payload.data() + offset);
+        offset += padded(count * sizeof(T));
+        return {data, static_cast<size_t>(count)};
+    }
+    bool has(size_t bytes) {
+        if (payload.size() - offset < bytes) failed = true;
+        return !failed;
+    }
+};
+
+} // namespace
+
+auto SessionTrace::encodedSize(Session const &) -> size_t { return recordSize(sizeof(SessionPayload)); }
+
+void SessionTrace::encode(Session const &session, std::span<uint8_t> out) {
+    auto encoder = Encoder{out};
+    encoder.header(RecordType::Session, sizeof(SessionPayload));
+    encoder.put(SessionPayload{
+        .desktop = session.desktop,
+        .rotation = static_cast<uint32_t>(session.rotation),
+        .ticksPerSecond = session.ticksPerSecond,
+    });
+}
+
+auto SessionTrace::encodedSize(Update const &update) -> size_t { return recordSize(updatePayloadSize(update)); }
+
+void SessionTrace::encode(Update const &update, SurfaceView image, std::span<uint8_t> out) {
+    const auto pixels = pixelBytes(update.imageRects);
+    auto encoder = Encoder{out};
+    encoder.header(RecordType::Update, updatePayloadSize(update));
+    encoder.put(UpdatePayload{
+        .sequence = update.sequence,
+        .presentTime = update.presentTime,
+        .pointerUpdateTime = update.pointerUpdateTime,
+        .frames = update.frames,
+        .flags = (update.rectsCoalesced ? RectsCoalesced : 0u) |
+            (update.protectedContentMaskedOut ? ProtectedContentMaskedOut : 0u) | (update.hasImage ? HasImage : 0u),
+        .movedCount = static_cast<uint32_t>(update.moved.size()),
+        .dirtyCount = static_cast<uint32_t>(update.dirty.size()),
+        .imageRectCount = static_cast<uint32_t>(update.imageRects.size()),
+        .shapeBytes = static_cast<uint32_t>(update.shape.size()),
+        .pixelBytes = pixels,
+        .pointerPosition = update.pointerPosition,
+        .shapeInfo = update.shapeInfo,
+    });
+    encoder.section(update.moved.data(), update.moved.size_bytes());
+    encoder.section(update.dirty.data(), update.dirty.size_bytes());
+    encoder.section(update.imageRects.data(), update.imageRects.size_bytes());
+    auto *pixelOut = out.data() + encoder.offset;
+    for (const auto &imageRect : update.imageRects) {
+        const auto rect = Rect::fromRECT(imageRect);
+        const auto rowBytes = static_cast<size_t>(rect.width()) * bytesPerPixel;
+        for (auto y = rect.top(); y < rect.bottom(); ++y) {
+            std::memcpy(pixelOut, image.pixel({rect.left(), y}), rowBytes);
+            pixelOut += rowBytes;
+        }
+    }
+    encoder.pad(pixels);
+    encoder.section(update.shape.data(), update.shape.size());
+}
+
+auto SessionTrace::decodeSession(std::span<const uint8_t> payload) -> std::optional<Session> {
+    auto decoder = Decoder{payload};
+    const auto session = decoder.get<SessionPayload>();
+    if (decoder.failed) return {};
+    return Session{
+        .desktop = session.desktop,
+        .rotation = static_cast<DXGI_MODE_ROTATION>(session.rotation),
+        .ticksPerSecond = session.ticksPerSecond,
+    };
+}
+
+auto SessionTrace::decodeUpdate(std::span<const uint8_t> payload) -> std::optional<Update> {
+    auto decoder = Decoder{payload};
+    const auto header = decoder.get<UpdatePayload>();
+    auto update = Update{
+        .sequence = header.sequence,
+        .presentTime = header.presentTime,
+        .frames = header.frames,
+        .rectsCoalesced = (header.flags & RectsCoalesced) != 0,
+        .protectedContentMaskedOut = (header.flags & ProtectedContentMaskedOut) != 0,
+        .hasImage = (header.flags & HasImage) != 0,
+        .moved = decoder.section<DXGI_OUTDUPL_MOVE_RECT>(header.movedCount),
+        .dirty = decoder.section<RECT>(header.dirtyCount),
+        .imageRects = decoder.section<RECT>(header.imageRectCount),
+        .pixels = decoder.section<uint8_t>(header.pixelBytes),
+        .pointerUpdateTime = header.pointerUpdateTime,
+        .pointerPosition = header.pointerPosition,
+        .shapeInfo = header.shapeInfo,
+        .shape = decoder.section<uint8_t>(header.shapeBytes),
+    };
+    if (decoder.failed) return {};
+    for (const auto &rect : update.imageRects) {
+        if (rect.left < 0 || rect.top < 0 || rect.right < rect.left || rect.bottom < rect.top) return {};
+    }
+    if (pixelBytes(update.imageRects) != update.pixels.size()) return {};
+    return update;
+}
+
+auto SessionTrace::keyframePayloadSize(Dimension image) -> size_t {
+    return sizeof(KeyframePayload) + static_cast<size_t>(image.width) * image.height * bytesPerPixel;
+}
+
+auto SessionTrace::decodeKeyframe(std::span<const uint8_t> payload) -> std::optional<Keyframe> {
+    auto decoder = Decoder{payload};
+    const auto header = decoder.get<KeyframePayload>();
+    if (decoder.failed || header.width < 0 || header.height < 0) return {};
+    const auto dimension = Dimension{header.width, header.height};
+    const auto pixels = decoder.section<uint8_t>(keyframePayloadSize(dimension) - sizeof(KeyframePayload));
+    if (decoder.failed) return {};
+    return Keyframe{
+        .position = header.position,
+        .image = SurfaceView{pixels.data(), dimension, dimension.width * bytesPerPixel},
+    };
+}
+
+void SessionTraceImage::reset(SessionTrace::Session const &session) {
+    m_session = session;
+    m_image = Surface{rotate(Rect::fromRECT(session.desktop).dimension, session.rotation)};
+}
+
+void SessionTraceImage::restore(SessionTrace::Keyframe const &keyframe) {
+    if (keyframe.image.dimension != m_image.dimension()) m_image = Surface{keyframe.image.dimension};
+    copyRect(keyframe.image, Rect{{}, keyframe.image.dimension}, m_image.span(), {});
+}
+
+void SessionTraceImage::apply(SessionTrace::Update const &update) {
+    const auto desktopDim = Rect::fromRECT(m_session.desktop).dimension;
+    const auto imageRect = Rect{{}, m_image.dimension()};
+    if (!update.moved.empty()) {
+        m_moves.clear();
+        for (const auto &move : update.moved) {
+            const auto destination = Rect::fromRECT(move.DestinationRect);
+            const auto source = Rect{Point::fromPOINT(move.SourcePoint), destination.dimension};
+            const auto rotatedSource = rotate(source, m_session.rotation, desktopDim);
+            const auto rotatedDestination = rotate(destination, m_session.rotation, desktopDim);
+            if (!containsRect(imageRect, rotatedSource) || !containsRect(imageRect, rotatedDestination)) continue;
+            m_moves.push_back({rotatedSource, rotatedDestination.topLeft});
+        }
+        const auto &plan = m_movePlanner.plan(m_moves);
+        const auto &tempDim = plan.tempDimension;
+        if (m_moveTmp.dimension().width < tempDim.width || m_moveTmp.dimension().height < tempDim.height) {
+            m_moveTmp = Surface{Dimension{
+                std::max(m_moveTmp.dimension().width, tempDim.width),
+                std::max(m_moveTmp.dimension().height, tempDim.height),
+            }};
+        }
+        executeMovePlan(m_image.span(), plan, m_moveTmp.span());
+    }
+    const auto *pixels = update.pixels.data();
+    for (const auto &imageRectRECT : update.imageRects) {
+        const auto rect = Rect::fromRECT(imageRectRECT);
+        const auto rectBytes = static_cast<size_t>(rect.width()) * rect.height() * bytesPerPixel;
+        if (containsRect(imageRect, rect)) {
+            const auto source = SurfaceView{pixels, rect.dimension, rect.width() * bytesPerPixel};
+            copyRect(source, Rect{{}, rect.dimension}, m_image.span(), rect.topLeft);
+        }
+        pixels += rectBytes;
+    }
+}
+
+bool SessionTraceWriter::open(std::filesystem::path const &path) {
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    m_offset = 0;
+    m_sessionOffset.reset();
+    m_index.clear();
+    m_keyframes.clear();
+    if (!m_file.is_open()) return false;
+    const auto header = SessionTrace::FileHeader{};
+    return write(asBytes(header));
+}
+
+bool SessionTraceWriter::append(std::span<const uint8_t> record) {
+    if (!m_file.is_open() || record.size() < sizeof(RecordHeader)) return false;
+    auto header = RecordHeader{};
+    std::memcpy(&header, record.data(), sizeof(header));
+    if (header.type == RecordType::Session) {
+        m_sessionOffset = m_offset;
+    }
+    else if (header.type == RecordType::Update) {
+        if (!m_sessionOffset) return false; // updates need a session
+        auto payload = UpdatePayload{};
+        std::memcpy(&payload, record.data() + sizeof(header), sizeof(payload));
+        m_index.push_back({
+            .offset = m_offset,
+            .sessionOffset = *m_sessionOffset,
+            .sequence = payload.sequence,
+            .presentTime = payload.presentTime,
+        });
+    }
+    else {
+        return false;
+    }
+    return write(record);
+}
+
+bool SessionTraceWriter::appendKeyframe(SurfaceView image) {
+    if (!m_file.is_open() || !m_sessionOffset) return false;
+    const auto payloadBytes = SessionTrace::keyframePayloadSize(image.dimension);
+    const auto header = RecordHeader{.type = RecordType::Keyframe, .bytes = payloadBytes};
+    const auto keyframe = KeyframePayload{
+        .position = m_index.size(),
+        .width = image.dimension.width,
+        .height = image.dimension.height,
+    };
+    const auto entry = SessionTrace::KeyframeEntry{
+        .offset = m_offset,
+        .position = keyframe.position,
+        .sessionOffset = *m_sessionOffset,
+    };
+    auto success = write(asBytes(header)) && write(asBytes(keyframe));
+    const auto rowBytes = static_cast<size_t>(image.dimension.width) * bytesPerPixel;
+    for (auto y = 0; success && y < image.dimension.height; ++y) success = write({image.row(y), rowBytes});
+    constexpr auto zeros = std::array<uint8_t, SessionTrace::alignment>{};
+    success = success && write({zeros.data(), padded(payloadBytes) - payloadBytes});
+    if (success) m_keyframes.push_back(entry);
+    return success;
+}
+
+bool SessionTraceWriter::finish() {
+    if (!m_file.is_open()) return false;
+    const auto updateBytes = std::span<const SessionTrace::IndexEntry>{m_index}.size_bytes();
+    const auto keyframeBytes = std::span<const SessionTrace::KeyframeEntry>{m_keyframes}.size_bytes();
+    const auto index = IndexPayload{.updateCount = m_index.size(), .keyframeCount = m_keyframes.size()};
+    const auto indexHeader = RecordHeader{
+        .type = RecordType::Index,
+        .bytes = sizeof(index) + updateBytes + keyframeBytes,
+    };
+    const auto trailer = SessionTrace::Trailer{.indexOffset = m_offset};
+    auto success = write(asBytes(indexHeader)) && write(asBytes(index)) &&
+        write({std::bit_cast<const uint8_t *>(m_index.data()), updateBytes}) &&
+        write({std::bit_cast<const uint8_t *>(m_keyframes.data()), keyframeBytes}) && write(asBytes(trailer));
+    m_file.close();
+    return success && !m_file.fail();
+}
+
+bool SessionTraceWriter::write(std::span<const uint8_t> bytes) {
+    m_file.write(std::bit_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    m_offset += bytes.size();
+    return m_file.good();
+}
+
+bool SessionTraceReader::open(std::filesystem::path const &path) {
+    m_index.clear();
+    m_keyframes.clear();
+    m_sessionOffset.reset();
+    m_isComplete = false;
+    if (!m_file.open(path)) return false;
+
+    const auto bytes = m_file.bytes();
+    auto header = SessionTrace::FileHeader{};
+    if (bytes.size() < sizeof(header)) return false;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != SessionTrace::fileMagic || header.version != SessionTrace::version ||
+        header.headerBytes < sizeof(header)) {
+        return false;
+    }
+    m_isComplete = readIndex();
+    if (!m_isComplete) {
+        m_index.clear();
+        m_keyframes.clear();
+        scanRecords();
+    }
+    return true;
+}
+
+auto SessionTraceReader::read(size_t position) -> std::optional<SessionTrace::Update> {
+    if (position >= m_index.size()) return {};
+    const auto &entry = m_index[position];
+    if (m_sessionOffset != entry.sessionOffset) {
+        m_sessionOffset.reset();
+        const auto payload = record(entry.sessionOffset, RecordType::Session);
+        if (!payload) return {};
+        const auto session = SessionTrace::decodeSession(*payload);
+        if (!session) return {};
+        m_session = *session;
+        m_sessionOffset = entry.sessionOffset;
+    }
+    const auto payload = record(entry.offset, RecordType::Update);
+    if (!payload) return {};
+    return SessionTrace::decodeUpdate(*payload);
+}
+
+auto SessionTraceReader::readKeyframe(size_t position) const -> std::optional<SessionTrace::Keyframe> {
+    if (position >= m_keyframes.size()) return {};
+    const auto payload = record(m_keyframes[position].offset, RecordType::Keyframe);
+    if (!payload) return {};
+    return SessionTrace::decodeKeyframe(*payload);
+}
+
+auto SessionTraceReader::record(uint64_t offset, RecordType type) const -> std::optional<std::span<const uint8_t>> {
+    const auto bytes = m_file.bytes();
+    auto header = RecordHeader{};
+    if (offset % SessionTrace::alignment != 0 || offset > bytes.size() || bytes.size() - offset < sizeof(header)) {
+        return {};
+    }
+    std::memcpy(&header, bytes.data() + offset, sizeof(header));
+    const auto available = bytes.size() - offset - sizeof(header);
+    if (header.type != type || header.bytes > available) return {};
+    return bytes.subspan(static_cast<size_t>(offset) + sizeof(header), static_cast<size_t>(header.bytes));
+}
+
+bool SessionTraceReader::readIndex() {
+    const auto bytes = m_file.bytes();
+    auto trailer = SessionTrace::Trailer{};
+    if (bytes.size() < sizeof(SessionTrace::FileHeader) + sizeof(trailer)) return false;
+    std::memcpy(&trailer, bytes.data() + bytes.size() - sizeof(trailer), sizeof(trailer));
+    if (trailer.magic != SessionTrace::trailerMagic) return false;
+
+    const auto payload = record(trailer.indexOffset, RecordType::Index);
+    if (!payload) return false;
+    auto decoder = Decoder{*payload};
+    const auto index = decoder.get<IndexPayload>();
+    const auto updates = decoder.section<IndexEntry>(index.updateCount);
+    const auto keyframes = decoder.section<KeyframeEntry>(index.keyframeCount);
+    if (decoder.failed) return false;
+    m_index.assign(updates.begin(), updates.end());
+    m_keyframes.assign(keyframes.begin(), keyframes.end());
+    const auto isValid = [&](uint64_t offset, uint64_t sessionOffset) {
+        return offset < trailer.indexOffset && sessionOffset < offset;
+    };
+    return std::ranges::all_of(m_index, [&](IndexEntry const &e) { return isValid(e.offset, e.sessionOffset); }) &&
+        std::ranges::all_of(m_keyframes, [&](KeyframeEntry const &e) {
+               return isValid(e.offset, e.sessionOffset) && e.position <= m_index.size();
+           });
+}
+
+void SessionTraceReader::scanRecords() {
+    const auto bytes = m_file.bytes();
+    auto offset = uint64_t{sizeof(SessionTrace::FileHeader)};
+    auto sessionOffset = std::optional<uint64_t>{};
+    while (bytes.size() - offset >= sizeof(RecordHeader)) {
+        auto header = RecordHeader{};
+        std::memcpy(&header, bytes.data() + offset, sizeof(header));
+        if (header.bytes > bytes.size() - offset - sizeof(header)) break; // truncated
+        const auto *payload = bytes.data() + offset + sizeof(header);
+        if (header.type == RecordType::Session) {
+            sessionOffset = offset;
+        }
+        else if (header.type == RecordType::Update && sessionOffset && header.bytes >= sizeof(UpdatePayload)) {
+            auto update = UpdatePayload{};
+            std::memcpy(&update, payload, sizeof(update));
+            m_index.push_back({
+                .offset = offset,
+                .sessionOffset = *sessionOffset,
+                .sequence = update.sequence,
+                .presentTime = update.presentTime,
+            });
+        }
+        else if (header.type == RecordType::Keyframe && sessionOffset && header.bytes >= sizeof(KeyframePayload)) {
+            auto keyframe = KeyframePayload{};
+            std::memcpy(&keyframe, payload, sizeof(keyframe));
+            if (keyframe.position != m_index.size()) break; // keyframes follow the updates they contain
+            m_keyframes.push_back({.offset = offset, .position = keyframe.position, .sessionOffset = *sessionOffset});
+        }
+        else {
+            break; // unknown or misplaced record
+        }
+        offset += SessionTrace::recordSize(static_cast<size_t>(header.bytes));
+        if (offset > bytes.size()) break;
+    }
+}
+
+} // namespace core
@@ -0,0 +1,213 @@
+#pragma once
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+#include "MappedFile.h"
+#include "MovePlanner.h"
+#include "Surface.h"
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+/// Append only binary format for recorded capture sessions
+/// layout:
+/// * FileHeader
+/// * records - RecordHeader followed by the payload, padded to 8 bytes
+///   - Session: output of all following updates (repeated if the output changes)
+///   - Update: one captured frame & pointer update
+///   - Keyframe: snapshot of the entire image after all preceding updates (allows to seek)
+///   - Index: offsets of all Update & Keyframe records (written when the recording is finished)
+/// * Trailer - offset of the Index record
+/// note:
+/// * all values are little endian, rects & pointer infos use the layout of the DXGI structs
+/// * without a Trailer (recording was interrupted) readers walk the record headers
+/// * all sections are 8 byte aligned, so memory mapped files are used in place
+struct SessionTrace {
+    static constexpr auto fileMagic = std::array<char, 8>{'D', 'D', 'T', 'R', 'A', 'C', 'E', 0};
+    static constexpr auto trailerMagic = std::array<char, 8>{'D', 'D', 'I', 'N', 'D', 'E', 'X', 0};
+    static constexpr auto version = uint32_t{2};
+    static constexpr auto alignment = size_t{8};
+
+    enum class RecordType : uint32_t {
+        Session = 1,
+        Update = 2,
+        Index = 3,
+        Keyframe = 4,
+    };
+
+    struct FileHeader {
+        std::array<char, 8> magic{fileMagic};
+        uint32_t version{SessionTrace::version};
+        uint32_t headerBytes{sizeof(FileHeader)};
+    };
+    struct RecordHeader {
+        RecordType type{};
+        uint32_t reserved{};
+        uint64_t bytes{}; ///< payload bytes (without padding)
+    };
+    struct Trailer {
+        uint64_t indexOffset{}; ///< file offset of the Index RecordHeader
+        std::array<char, 8> magic{trailerMagic};
+    };
+
+    /// captured output of the following updates
+    struct Session {
+        RECT desktop{}; ///< desktop coordinates of the output
+        DXGI_MODE_ROTATION rotation{DXGI_MODE_ROTATION_IDENTITY};
+        int64_t ticksPerSecond{}; ///< unit of present & pointer update times
+    };
+
+    /// one recorded CapturedUpdate
+    /// note: spans of decoded updates point into the buffer of the record
+    struct Update {
+        uint64_t sequence{};
+        int64_t presentTime{};
+        uint32_t frames{};
+        bool rectsCoalesced{};
+        bool protectedContentMaskedOut{};
+        bool hasImage{}; ///< the captured frame carried an image (pointer only updates do not)
+        std::span<const DXGI_OUTDUPL_MOVE_RECT> moved{};
+        std::span<const RECT> dirty{};
+        /// parts of the image that are stored in pixels (image coordinates, the rotated dirty rects)
+        std::span<const RECT> imageRects{};
+        /// BGRA rows of all imageRects tightly packed (set by decoding, encoding copies them from the image)
+        std::span<const uint8_t> pixels{};
+
+        uint64_t pointerUpdateTime{};
+        DXGI_OUTDUPL_POINTER_POSITION pointerPosition{};
+        DXGI_OUTDUPL_POINTER_SHAPE_INFO shapeInfo{};
+        std::span<const uint8_t> shape{};
+    };
+
+    /// image after all updates before position
+    struct Keyframe {
+        uint64_t position{}; ///< index of the next update
+        SurfaceView image{}; ///< tightly packed rows
+    };
+
+    struct IndexEntry {
+        uint64_t offset{}; ///< file offset of the Update RecordHeader
+        uint64_t sessionOffset{}; ///< file offset of the Session RecordHeader the update belongs to
+        uint64_t sequence{};
+        int64_t presentTime{};
+    };
+    struct KeyframeEntry {
+        uint64_t offset{}; ///< file offset of the Keyframe RecordHeader
+        uint64_t position{}; ///< see Keyframe::position
+        uint64_t sessionOffset{};
+    };
+
+    /// bytes of an encoded record with a payload of payloadBytes (including header & padding)
+    static constexpr auto recordSize(size_t payloadBytes) -> size_t {
+        return sizeof(RecordHeader) + (payloadBytes + alignment - 1) / alignment * alignment;
+    }
+
+    static auto encodedSize(Session const &) -> size_t;
+    static void encode(Session const &, std::span<uint8_t> out);
+
+    /// bytes of the encoded update record
+    static auto encodedSize(Update const &) -> size_t;
+    /// encode update into out (encodedSize bytes), the pixels of all imageRects are copied from image
+    static void encode(Update const &, SurfaceView image, std::span<uint8_t> out);
+
+    /// bytes of the payload of a keyframe of image
+    static auto keyframePayloadSize(Dimension image) -> size_t;
+
+    /// decode the payload of a record - nullopt if it is malformed
+    /// note: spans & views point into the payload
+    static auto decodeSession(std::span<const uint8_t> payload) -> std::optional<Session>;
+    static auto decodeUpdate(std::span<const uint8_t> payload) -> std::optional<Update>;
+    static auto decodeKeyframe(std::span<const uint8_t> payload) -> std::optional<Keyframe>;
+};
+
+/// Reconstructs the captured image of a session from the recorded updates
+/// note: same semantics as the SoftwareFrameUpdater - moves first, then the recorded pixels
+struct SessionTraceImage {
+    /// start over with a black image for the output of session
+    void reset(SessionTrace::Session const &);
+    void restore(SessionTrace::Keyframe const &);
+    void apply(SessionTrace::Update const &);
+
+    auto view() const -> SurfaceView { return m_image.view(); }
+
+private:
+    Surface m_image{};
+    Surface m_moveTmp{};
+    MovePlanner m_movePlanner{};
+    std::vector<RectMove> m_moves{};
+    SessionTrace::Session m_session{};
+};
+
+/// Writes encoded records into a session trace file
+/// note: one thread at a time - SessionRecorder runs it on its own thread
+struct SessionTraceWriter {
+    bool open(std::filesystem::path const &);
+    bool isOpen() const { return m_file.is_open(); }
+
+    /// append one encoded Session or Update record (as SessionTrace::encode produces it)
+    bool append(std::span<const uint8_t> record);
+    /// append a Keyframe record with image after all updates appended so far
+    bool appendKeyframe(SurfaceView image);
+
+    /// write the Index record & Trailer and close the file
+    bool finish();
+
+    auto bytesWritten() const -> uint64_t { return m_offset; }
+
+private:
+    bool write(std::span<const uint8_t> bytes);
+
+private:
+    std::ofstream m_file{};
+    uint64_t m_offset{};
+    std::optional<uint64_t> m_sessionOffset{}; // of the last Session record
+    std::vector<SessionTrace::IndexEntry> m_index{};
+    std::vector<SessionTrace::KeyframeEntry> m_keyframes{};
+};
+
+/// Reads a memory mapped session trace file
+/// note: decoded updates & keyframes point into the mapping (valid while the reader is open)
+struct SessionTraceReader {
+    using Session = SessionTrace::Session;
+    using IndexEntry = SessionTrace::IndexEntry;
+    using KeyframeEntry = SessionTrace::KeyframeEntry;
+
+    /// map the file and read its index - false if it is no session trace
+    bool open(std::filesystem::path const &);
+
+    /// true if the Index was written (otherwise it was recovered by walking all records)
+    bool isComplete() const { return m_isComplete; }
+    auto updates() const -> std::span<const IndexEntry> { return m_index; }
+    auto keyframes() const -> std::span<const KeyframeEntry> { return m_keyframes; }
+
+    /// read the update at index position (& the session it belongs to) - nullopt if the record is damaged
+    auto read(size_t position) -> std::optional<SessionTrace::Update>;
+    /// session of the last read update
+    auto session() const -> Session const & { return m_session; }
+
+    /// read the keyframe at keyframe index position - nullopt if the record is damaged
+    auto readKeyframe(size_t position) const -> std::optional<SessionTrace::Keyframe>;
+
+private:
+    auto record(uint64_t offset, SessionTrace::RecordType) const -> std::optional<std::span<const uint8_t>>;
+    bool readIndex();
+    void scanRecords();
+
+private:
+    MappedFile m_file{};
+    bool m_isComplete{};
+    std::vector<IndexEntry> m_index{};
+    std::vector<KeyframeEntry> m_keyframes{};
+    std::optional<uint64_t> m_sessionOffset{}; // of m_session
+    Session m_session{};
+};
+
+} // namespace core
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <stddef.h>
+
+namespace core {
+
+/// wait free ring buffer for exactly one producer thread and one consumer thread
+/// note: slots are constructed up front and reused by move assignment - no allocations happen
+template<class T, size_t Capacity>
+struct SpscRing {
+    static_assert(std::has_single_bit(Capacity), "Capacity has to be a power of two");
+
+    /// move value into the ring - returns false (and leaves value untouched) if the ring is full
+    /// note: only call from the producer thread
+    bool tryPush(T &&value) noexcept {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == Capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity) return false;
+        }
+        m_slots[tail & mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// move the oldest value out of the ring - returns false if the ring is empty
+    /// note: only call from the consumer thread
+    bool tryPop(T &value) noexcept {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) return false;
+        }
+        value = std::move(m_slots[head & mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// note: only a snapshot, exact only when both threads are idle
+    bool isEmpty() const noexcept {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr auto mask = Capacity - 1;
+    static constexpr auto cacheLine = size_t{64};
+
+    // consumer side
+    alignas(cacheLine) std::atomic<size_t> m_head{};
+    size_t m_cachedTail{};
+
+    // producer side
+    alignas(cacheLine) std::atomic<size_t> m_tail{};
+    size_t m_cachedHead{};
+
+    alignas(cacheLine) std::array<T, Capacity> m_slots{};
+};
+
+/// portable wake up for a consumer of a SpscRing
+/// note: on Windows we use an Event handle instead to integrate with the ThreadLoop
+struct WakeSignal {
+    void notify() noexcept {
+        m_signaled.store(true, std::memory_order_release);
+        m_signaled.notify_one();
+    }
+
+    /// blocks until notify was called (since the last wait)
+    /// note: drain the ring after this returns, values pushed before notify are visible
+    void wait() noexcept {
+        m_signaled.wait(false, std::memory_order_acquire);
+        m_signaled.exchange(false, std::memory_order_acq_rel);
+    }
+
+private:
+    std::atomic<bool> m_signaled{};
+};
+
+} // namespace core
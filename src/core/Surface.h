@@ -0,0 +1,64 @@
+#pragma once
+#include "win32/Geometry.h"
+
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+using win32::Dimension;
+using win32::Point;
+using win32::Rect;
+
+/// all surfaces store 32 bit BGRA pixels (DXGI_FORMAT_B8G8R8A8_UNORM)
+constexpr auto bytesPerPixel = 4;
+
+/// non owning read only view of BGRA pixels in system memory
+struct SurfaceView {
+    const uint8_t *data{};
+    Dimension dimension{};
+    int pitch{}; ///< bytes from one row to the next
+
+    explicit operator bool() const { return data != nullptr; }
+
+    auto row(int y) const -> const uint8_t * { return data + static_cast<ptrdiff_t>(y) * pitch; }
+    auto pixel(Point p) const -> const uint8_t * { return row(p.y) + static_cast<ptrdiff_t>(p.x) * bytesPerPixel; }
+};
+
+/// non owning mutable view of BGRA pixels in system memory
+struct SurfaceSpan {
+    uint8_t *data{};
+    Dimension dimension{};
+    int pitch{};
+
+    explicit operator bool() const { return data != nullptr; }
+
+    auto row(int y) const -> uint8_t * { return data + static_cast<ptrdiff_t>(y) * pitch; }
+    auto pixel(Point p) const -> uint8_t * { return row(p.y) + static_cast<ptrdiff_t>(p.x) * bytesPerPixel; }
+
+    operator SurfaceView() const { return {data, dimension, pitch}; }
+};
+
+/// owning BGRA image in system memory
+/// note: rows are tightly packed
+struct Surface {
+    Surface() = default;
+    explicit Surface(Dimension dim)
+        : m_dimension{dim}
+        , m_pixels(static_cast<size_t>(dim.width) * dim.height * bytesPerPixel) {}
+
+    auto dimension() const -> Dimension { return m_dimension; }
+    auto pitch() const -> int { return m_dimension.width * bytesPerPixel; }
+    auto bytes() const -> std::span<const uint8_t> { return m_pixels; }
+
+    auto view() const -> SurfaceView { return {m_pixels.data(), m_dimension, pitch()}; }
+    auto span() -> SurfaceSpan { return {m_pixels.data(), m_dimension, pitch()}; }
+
+private:
+    Dimension m_dimension{};
+    std::vector<uint8_t> m_pixels{};
+};
+
+} // namespace core
@@ -0,0 +1,324 @@
+#include "SurfaceScaler.h"
+
+#include "PixelCopy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#    define CORE_SURFACE_SCALER_SSE2
+#    include <emmintrin.h>
+#endif
+
+namespace core {
+namespace {
+
+constexpr auto maxBoxFactor = 16; // n×n sums of 8 bit channels have to fit into 16 bit
+
+auto floorDiv(int value, int divisor) -> int {
+    const auto quotient = value / divisor;
+    return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+}
+
+auto pixelAt(SurfaceView surface, int x, int y) -> uint32_t {
+    auto pixel = uint32_t{};
+    std::memcpy(&pixel, surface.pixel({x, y}), sizeof(pixel));
+    return pixel;
+}
+
+void fillPixels(uint8_t *to, uint32_t color, int count) {
+#ifdef CORE_SURFACE_SCALER_SSE2
+    const auto colors = _mm_set1_epi32(static_cast<int>(color));
+    for (; count >= 4; count -= 4, to += 16) _mm_storeu_si128(reinterpret_cast<__m128i *>(to), colors);
+#endif
+    for (; count > 0; --count, to += bytesPerPixel) std::memcpy(to, &color, sizeof(color));
+}
+
+/// fill everything of the target row outside of the covered span
+void fillBorders(uint8_t *row, int width, int begin, int end, uint32_t background) {
+    fillPixels(row, background, begin);
+    fillPixels(row + static_cast<ptrdiff_t>(end) * bytesPerPixel, background, width - end);
+}
+
+#ifndef CORE_SURFACE_SCALER_SSE2
+/// bilinear weights are 8 bit fixed point (0…256), rounding matches the SSE2 path
+auto blend(uint32_t a, uint32_t b, uint32_t weight) -> uint32_t {
+    auto result = uint32_t{};
+    for (auto shift = 0; shift < 32; shift += 8) {
+        const auto ca = (a >> shift) & 0xFF;
+        const auto cb = (b >> shift) & 0xFF;
+        result |= (((ca * (256 - weight) + cb * weight + 128) >> 8) & 0xFF) << shift;
+    }
+    return result;
+}
+#endif
+
+auto boxReciprocal(int factor) -> uint32_t {
+    const auto area = static_cast<uint32_t>(factor * factor);
+    return (65536 + area - 1) / area;
+}
+
+} // namespace
+
+auto SurfaceScaler::coverage(int sourceSize, int targetSize, float zoom, float offset) const -> Span {
+    const auto at = [&](float texel) {
+        return std::clamp(static_cast<int>(std::ceil(texel * zoom - 0.5f)), 0, targetSize);
+    };
+    return {at(offset), at(static_cast<float>(sourceSize) + offset)};
+}
+
+void SurfaceScaler::scale(SurfaceView source, SurfaceSpan target, const Args &args) {
+    if (!target) return;
+    const auto zoom = args.outputZoom;
+    if (!source || source.dimension.width <= 0 || source.dimension.height <= 0 || !(zoom > 0.0f)) {
+        for (auto y = 0; y < target.dimension.height; ++y) {
+            fillPixels(target.row(y), args.background, target.dimension.width);
+        }
+        return;
+    }
+    switch (args.filter) {
+    case Filter::IntegerRatio: {
+        if (zoom >= 1.0f) {
+            const auto factor = static_cast<int>(std::lround(zoom));
+            if (std::fabs(zoom - static_cast<float>(factor)) < 1e-4f) {
+                return scaleReplicate(source, target, args, factor);
+            }
+        }
+        else {
+            const auto factor = static_cast<int>(std::lround(1.0f / zoom));
+            if (std::fabs(1.0f / zoom - static_cast<float>(factor)) < 1e-3f) {
+                // note: the 16 bit reciprocal of a 1×1 box overflows
+                if (factor == 1) return scaleReplicate(source, target, args, factor);
+                if (factor <= maxBoxFactor) return scaleBox(source, target, args, factor);
+            }
+        }
+        return scaleNearest(source, target, args);
+    }
+    case Filter::Bilinear:
+        if (source.dimension.width < 2 || source.dimension.height < 2) return scaleNearest(source, target, args);
+        return scaleBilinear(source, target, args);
+    case Filter::Nearest: return scaleNearest(source, target, args);
+    }
+}
+
+void SurfaceScaler::scaleNearest(SurfaceView source, SurfaceSpan target, const Args &args) {
+    const auto zoom = args.outputZoom;
+    const auto [width, height] = target.dimension;
+    const auto columns = coverage(source.dimension.width, width, zoom, args.captureOffset.x);
+    const auto rows = coverage(source.dimension.height, height, zoom, args.captureOffset.y);
+
+    m_columns.resize(static_cast<size_t>(width));
+    for (auto x = columns.begin; x < columns.end; ++x) {
+        const auto texel = (static_cast<float>(x) + 0.5f) / zoom - args.captureOffset.x;
+        m_columns[x] = std::clamp(static_cast<int>(std::floor(texel)), 0, source.dimension.width - 1);
+    }
+    auto lastSourceRow = -1;
+    for (auto y = 0; y < height; ++y) {
+        auto *row = target.row(y);
+        if (y < rows.begin || y >= rows.end) {
+            fillPixels(row, args.background, width);
+            continue;
+        }
+        const auto texel = (static_cast<float>(y) + 0.5f) / zoom - args.captureOffset.y;
+        const auto sourceRow = std::clamp(static_cast<int>(std::floor(texel)), 0, source.dimension.height - 1);
+        if (sourceRow == lastSourceRow) {
+            copyRow(row, target.row(y - 1), static_cast<size_t>(width) * bytesPerPixel);
+            continue;
+        }
+        lastSourceRow = sourceRow;
+        fillBorders(row, width, columns.begin, columns.end, args.background);
+        const auto *from = source.row(sourceRow);
+        auto *to = row + static_cast<ptrdiff_t>(columns.begin) * bytesPerPixel;
+        for (auto x = columns.begin; x < columns.end; ++x, to += bytesPerPixel) {
+            std::memcpy(to, from + static_cast<ptrdiff_t>(m_columns[x]) * bytesPerPixel, bytesPerPixel);
+        }
+    }
+}
+
+void SurfaceScaler::scaleBilinear(SurfaceView source, SurfaceSpan target, const Args &args) {
+    const auto zoom = args.outputZoom;
+    const auto [width, height] = target.dimension;
+    const auto columns = coverage(source.dimension.width, width, zoom, args.captureOffset.x);
+    const auto rows = coverage(source.dimension.height, height, zoom, args.captureOffset.y);
+
+    // left texel and weight of the right texel, clamped so that left + 1 is always inside
+    const auto sampleAt = [zoom](int index, float offset, int size) {
+        const auto texel = (static_cast<float>(index) + 0.5f) / zoom - offset - 0.5f;
+        const auto left = static_cast<int>(std::floor(texel));
+        if (left < 0) return std::pair{0, 0};
+        if (left >= size - 1) return std::pair{size - 2, 256};
+        return std::pair{left, static_cast<int>(std::lround((texel - static_cast<float>(left)) * 256.0f))};
+    };
+    m_columns.resize(static_cast<size_t>(width));
+    m_columnWeights.resize(static_cast<size_t>(width));
+    for (auto x = columns.begin; x < columns.end; ++x) {
+        const auto [left, weight] = sampleAt(x, args.captureOffset.x, source.dimension.width);
+        m_columns[x] = left;
+        m_columnWeights[x] = static_cast<uint16_t>(weight);
+    }
+    for (auto y = 0; y < height; ++y) {
+        auto *row = target.row(y);
+        if (y < rows.begin || y >= rows.end) {
+            fillPixels(row, args.background, width);
+            continue;
+        }
+        fillBorders(row, width, columns.begin, columns.end, args.background);
+        const auto [top, rowWeight] = sampleAt(y, args.captureOffset.y, source.dimension.height);
+        const auto *upper = source.row(top);
+        const auto *lower = source.row(top + 1);
+#ifdef CORE_SURFACE_SCALER_SSE2
+        const auto zero = _mm_setzero_si128();
+        const auto rounding = _mm_set1_epi16(128);
+        const auto upperWeight = _mm_set1_epi16(static_cast<short>(256 - rowWeight));
+        const auto lowerWeight = _mm_set1_epi16(static_cast<short>(rowWeight));
+        // a pair of horizontal neighbours as 8×16 bit lanes (b, g, r, a of left then right)
+        const auto horizontal = [&](const uint8_t *pair, __m128i weights) {
+            const auto pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(pair)), zero);
+            const auto weighted = _mm_mullo_epi16(pixels, weights);
+            return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(weighted, _mm_srli_si128(weighted, 8)), rounding), 8);
+        };
+        for (auto x = columns.begin; x < columns.end; ++x) {
+            const auto offset = static_cast<ptrdiff_t>(m_columns[x]) * bytesPerPixel;
+            const auto weight = static_cast<short>(m_columnWeights[x]);
+            const auto weights = _mm_unpacklo_epi64(
+                _mm_set1_epi16(static_cast<short>(256 - weight)), _mm_set1_epi16(weight));
+            const auto high = horizontal(upper + offset, weights);
+            const auto low = horizontal(lower + offset, weights);
+            const auto mixed = _mm_srli_epi16(
+                _mm_add_epi16(
+                    _mm_add_epi16(_mm_mullo_epi16(high, upperWeight), _mm_mullo_epi16(low, lowerWeight)), rounding),
+                8);
+            const auto pixel = _mm_cvtsi128_si32(_mm_packus_epi16(mixed, zero));
+            std::memcpy(row + static_cast<ptrdiff_t>(x) * bytesPerPixel, &pixel, sizeof(pixel));
+        }
+#else
+        for (auto x = columns.begin; x < columns.end; ++x) {
+            const auto left = m_columns[x];
+            const auto weight = m_columnWeights[x];
+            const auto high = blend(pixelAt(source, left, top), pixelAt(source, left + 1, top), weight);
+            const auto low = blend(pixelAt(source, left, top + 1), pixelAt(source, left + 1, top + 1), weight);
+            const auto pixel = blend(high, low, static_cast<uint32_t>(rowWeight));
+            std::memcpy(row + static_cast<ptrdiff_t>(x) * bytesPerPixel, &pixel, sizeof(pixel));
+        }
+        (void)upper;
+        (void)lower;
+#endif
+    }
+}
+
+void SurfaceScaler::scaleReplicate(SurfaceView source, SurfaceSpan target, const Args &args, int factor) {
+    const auto [width, height] = target.dimension;
+    const auto origin = Point{
+        static_cast<int>(std::lround(args.captureOffset.x * static_cast<float>(factor))),
+        static_cast<int>(std::lround(args.captureOffset.y * static_cast<float>(factor))),
+    };
+    const auto begin = Point{std::clamp(origin.x, 0, width), std::clamp(origin.y, 0, height)};
+    const auto end = Point{
+        std::clamp(origin.x + source.dimension.width * factor, 0, width),
+        std::clamp(origin.y + source.dimension.height * factor, 0, height),
+    };
+    auto lastSourceRow = -1;
+    for (auto y = 0; y < height; ++y) {
+        auto *row = target.row(y);
+        if (y < begin.y || y >= end.y) {
+            fillPixels(row, args.background, width);
+            continue;
+        }
+        const auto sourceRow = floorDiv(y - origin.y, factor);
+        if (sourceRow == lastSourceRow) {
+            copyRow(row, target.row(y - 1), static_cast<size_t>(width) * bytesPerPixel);
+            continue;
+        }
+        lastSourceRow = sourceRow;
+        fillBorders(row, width, begin.x, end.x, args.background);
+        auto x = begin.x;
+#ifdef CORE_SURFACE_SCALER_SSE2
+        if (factor == 2 && (x - origin.x) % 2 == 0) {
+            // duplicate 4 source pixels into 8 target pixels
+            const auto *from = source.pixel({(x - origin.x) / 2, sourceRow});
+            for (; x + 8 <= end.x; x += 8, from += 4 * bytesPerPixel) {
+                const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(from));
+                auto *to = reinterpret_cast<__m128i *>(row + static_cast<ptrdiff_t>(x) * bytesPerPixel);
+                _mm_storeu_si128(to, _mm_unpacklo_epi32(pixels, pixels));
+                _mm_storeu_si128(to + 1, _mm_unpackhi_epi32(pixels, pixels));
+            }
+        }
+#endif
+        while (x < end.x) {
+            const auto sourceColumn = floorDiv(x - origin.x, factor);
+            const auto runEnd = std::min(end.x, origin.x + (sourceColumn + 1) * factor);
+            fillPixels(
+                row + static_cast<ptrdiff_t>(x) * bytesPerPixel, pixelAt(source, sourceColumn, sourceRow), runEnd - x);
+            x = runEnd;
+        }
+    }
+}
+
+void SurfaceScaler::scaleBox(SurfaceView source, SurfaceSpan target, const Args &args, int factor) {
+    const auto [width, height] = target.dimension;
+    const auto origin = Point{
+        static_cast<int>(std::lround(args.captureOffset.x / static_cast<float>(factor))),
+        static_cast<int>(std::lround(args.captureOffset.y / static_cast<float>(factor))),
+    };
+    // only target pixels with a complete box of source pixels are covered
+    const auto begin = Point{std::clamp(origin.x, 0, width), std::clamp(origin.y, 0, height)};
+    const auto end = Point{
+        std::clamp(origin.x + source.dimension.width / factor, 0, width),
+        std::clamp(origin.y + source.dimension.height / factor, 0, height),
+    };
+    const auto half = static_cast<uint32_t>(factor * factor / 2);
+    const auto reciprocal = boxReciprocal(factor);
+    for (auto y = 0; y < height; ++y) {
+        auto *row = target.row(y);
+        if (y < begin.y || y >= end.y) {
+            fillPixels(row, args.background, width);
+            continue;
+        }
+        fillBorders(row, width, begin.x, end.x, args.background);
+        const auto sourceTop = (y - origin.y) * factor;
+#ifdef CORE_SURFACE_SCALER_SSE2
+        const auto zero = _mm_setzero_si128();
+        const auto halfLane = static_cast<short>(half);
+        const auto rounding = _mm_setr_epi16(halfLane, halfLane, halfLane, halfLane, 0, 0, 0, 0);
+        const auto scale = _mm_set1_epi16(static_cast<short>(reciprocal));
+        for (auto x = begin.x; x < end.x; ++x) {
+            const auto sourceLeft = (x - origin.x) * factor;
+            auto sum = rounding;
+            for (auto sy = sourceTop; sy < sourceTop + factor; ++sy) {
+                const auto *from = source.pixel({sourceLeft, sy});
+                auto column = 0;
+                for (; column + 2 <= factor; column += 2) {
+                    const auto pair = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(from + column * bytesPerPixel));
+                    sum = _mm_add_epi16(sum, _mm_unpacklo_epi8(pair, zero));
+                }
+                if (column < factor) {
+                    const auto single = _mm_cvtsi32_si128(static_cast<int>(pixelAt(source, sourceLeft + column, sy)));
+                    sum = _mm_add_epi16(sum, _mm_unpacklo_epi8(single, zero));
+                }
+            }
+            // pairs were summed into two halves, the rounding is only part of the lower one
+            const auto total = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+            const auto average = _mm_mulhi_epu16(total, scale);
+            const auto pixel = _mm_cvtsi128_si32(_mm_packus_epi16(average, zero));
+            std::memcpy(row + static_cast<ptrdiff_t>(x) * bytesPerPixel, &pixel, sizeof(pixel));
+        }
+#else
+        for (auto x = begin.x; x < end.x; ++x) {
+            const auto sourceLeft = (x - origin.x) * factor;
+            auto sums = std::array<uint32_t, 4>{};
+            for (auto sy = sourceTop; sy < sourceTop + factor; ++sy) {
+                for (auto sx = sourceLeft; sx < sourceLeft + factor; ++sx) {
+                    const auto value = pixelAt(source, sx, sy);
+                    for (auto c = 0; c < 4; ++c) sums[c] += (value >> (8 * c)) & 0xFF;
+                }
+            }
+            auto pixel = uint32_t{};
+            for (auto c = 0; c < 4; ++c) pixel |= (((sums[c] + half) * reciprocal >> 16) & 0xFF) << (8 * c);
+            std::memcpy(row + static_cast<ptrdiff_t>(x) * bytesPerPixel, &pixel, sizeof(pixel));
+        }
+#endif
+    }
+}
+
+} // namespace core
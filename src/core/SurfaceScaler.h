@@ -0,0 +1,52 @@
+#pragma once
+#include "Surface.h"
+#include "win32/Geometry.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+using win32::Vec2f;
+
+/// Scales BGRA surfaces in system memory like the WindowRenderer presents the captured texture
+/// note:
+/// * target pixel (x, y) shows source texel ((x + 0.5) / outputZoom - captureOffset.x, …)
+/// * target pixels that do not show the source are filled with the background
+/// * tables are kept between calls to avoid allocations
+struct SurfaceScaler {
+    enum class Filter {
+        Nearest,
+        Bilinear,
+        /// zoom has to be an integer n (replicate) or 1/n (box average of n×n)
+        /// note: other zoom factors fall back to Nearest
+        IntegerRatio,
+    };
+    /// same meaning as WindowRenderer::Args
+    struct Args {
+        float outputZoom{1.0f};
+        Vec2f captureOffset{};
+        Filter filter{Filter::Bilinear};
+        uint32_t background{0xFF000000};
+    };
+
+    void scale(SurfaceView source, SurfaceSpan target, const Args &);
+
+private:
+    struct Span {
+        int begin{}; ///< first target index that shows the source
+        int end{}; ///< behind last target index that shows the source
+    };
+    auto coverage(int sourceSize, int targetSize, float zoom, float offset) const -> Span;
+
+    void scaleNearest(SurfaceView source, SurfaceSpan target, const Args &);
+    void scaleBilinear(SurfaceView source, SurfaceSpan target, const Args &);
+    void scaleReplicate(SurfaceView source, SurfaceSpan target, const Args &, int factor);
+    void scaleBox(SurfaceView source, SurfaceSpan target, const Args &, int factor); ///< factor >= 2
+
+private:
+    std::vector<int32_t> m_columns{}; ///< source column per target column
+    std::vector<uint16_t> m_columnWeights{}; ///< weight of the right source column (0…256)
+};
+
+} // namespace core
@@ -0,0 +1,156 @@
+#include "TileChangeDetector.h"
+
+#include "Hash.h"
+#include "RectCoalescer.h"
+#include "Rotation.h"
+#include "VisibleAreaCuller.h"
+
+#include <algorithm>
+
+namespace core {
+
+void TileChangeDetector::reset(Dimension desktop, DXGI_MODE_ROTATION rotation) {
+    const auto tileSize = std::max(m_config.tileSize, 1);
+    m_desktop = desktop;
+    m_rotation = rotation;
+    m_image = rotate(desktop, rotation);
+    m_tiles = Dimension{(m_image.width + tileSize - 1) / tileSize, (m_image.height + tileSize - 1) / tileSize};
+    m_table.assign(static_cast<size_t>(m_tiles.width) * m_tiles.height, Tile{});
+}
+
+auto TileChangeDetector::tileRects(std::span<const Rect> dirty) -> std::span<const Rect> {
+    m_tileRects.clear();
+    for (const auto &rect : dirty) {
+        const auto imageRect = toImage(rect);
+        if (!imageRect) continue;
+        const auto range = tileRange(*imageRect);
+        const auto topLeft = tileRect(range.left, range.top);
+        const auto bottomRight = tileRect(range.right - 1, range.bottom - 1);
+        m_tileRects.push_back(toDesktop(boundingRect(topLeft, bottomRight)));
+    }
+    return m_tileRects;
+}
+
+void TileChangeDetector::detect(SurfaceView image, std::span<const MoveRect> moved, std::span<const Rect> dirty) {
+    m_stats.frames++;
+    m_frame++;
+    m_dirty.clear();
+    for (const auto &rect : dirty) m_stats.inputArea += area(rect);
+
+    // moved content was never hashed at its destination
+    for (const auto &move : moved) {
+        const auto destination = toImage(Rect::fromRECT(move.DestinationRect));
+        if (destination) forget(*destination);
+    }
+    if (!image || image.dimension != m_image) {
+        for (const auto &rect : dirty) {
+            const auto imageRect = toImage(rect);
+            if (imageRect) forget(*imageRect);
+        }
+        m_dirty.assign(dirty.begin(), dirty.end());
+        for (const auto &rect : m_dirty) m_stats.outputArea += area(rect);
+        return;
+    }
+
+    const auto hashStart = std::chrono::steady_clock::now();
+    m_imageDirty.clear();
+    for (const auto &rect : dirty) {
+        const auto imageRect = toImage(rect);
+        if (!imageRect) continue;
+        m_imageDirty.push_back(*imageRect);
+        const auto range = tileRange(*imageRect);
+        for (auto y = range.top; y < range.bottom; ++y) {
+            for (auto x = range.left; x < range.right; ++x) {
+                auto &tile = m_table[static_cast<size_t>(y) * m_tiles.width + x];
+                if (tile.frame == m_frame) continue; // already hashed for another dirty rect
+                const auto rect = tileRect(x, y);
+                const auto hash = hashTile(image, rect);
+                tile.isChanged = hash != tile.hash;
+                tile.hash = hash;
+                tile.frame = m_frame;
+                m_stats.hashedTiles++;
+                m_stats.hashedArea += area(rect);
+                if (tile.isChanged) m_stats.changedTiles++;
+            }
+        }
+    }
+    m_stats.hashTime += std::chrono::steady_clock::now() - hashStart;
+
+    // changed tiles inside of each dirty rect, rows of equal runs are merged
+    for (const auto &imageRect : m_imageDirty) {
+        const auto first = m_dirty.size();
+        const auto range = tileRange(imageRect);
+        for (auto y = range.top; y < range.bottom; ++y) {
+            for (auto x = range.left; x < range.right;) {
+                const auto isChanged = [&](int tx) {
+                    return m_table[static_cast<size_t>(y) * m_tiles.width + tx].isChanged;
+                };
+                if (!isChanged(x)) {
+                    ++x;
+                    continue;
+                }
+                auto end = x + 1;
+                while (end < range.right && isChanged(end)) ++end;
+                const auto run = intersect(boundingRect(tileRect(x, y), tileRect(end - 1, y)), imageRect);
+                x = end;
+                if (!run) continue;
+                const auto above = std::find_if(m_dirty.begin() + first, m_dirty.end(), [&](Rect const &r) {
+                    return r.left() == run->left() && r.width() == run->width() && r.bottom() == run->top();
+                });
+                if (above != m_dirty.end()) {
+                    above->dimension.height += run->height();
+                }
+                else {
+                    m_dirty.push_back(*run);
+                }
+            }
+        }
+    }
+    for (auto &rect : m_dirty) {
+        rect = toDesktop(rect);
+        m_stats.outputArea += area(rect);
+    }
+}
+
+auto TileChangeDetector::toImage(Rect const &desktopRect) const -> std::optional<Rect> {
+    return intersect(rotate(desktopRect, m_rotation, m_desktop), Rect{{}, m_image});
+}
+
+auto TileChangeDetector::toDesktop(Rect const &imageRect) const -> Rect {
+    return rotate(imageRect, inverse(m_rotation), m_image);
+}
+
+auto TileChangeDetector::tileRange(Rect const &imageRect) const -> TileRange {
+    const auto tileSize = std::max(m_config.tileSize, 1);
+    return {
+        .left = imageRect.left() / tileSize,
+        .top = imageRect.top() / tileSize,
+        .right = (imageRect.right() + tileSize - 1) / tileSize,
+        .bottom = (imageRect.bottom() + tileSize - 1) / tileSize,
+    };
+}
+
+auto TileChangeDetector::tileRect(int x, int y) const -> Rect {
+    const auto tileSize = std::max(m_config.tileSize, 1);
+    const auto left = x * tileSize;
+    const auto top = y * tileSize;
+    return Rect{{left, top}, {std::min(tileSize, m_image.width - left), std::min(tileSize, m_image.height - top)}};
+}
+
+void TileChangeDetector::forget(Rect const &imageRect) {
+    const auto range = tileRange(imageRect);
+    for (auto y = range.top; y < range.bottom; ++y) {
+        for (auto x = range.left; x < range.right; ++x) {
+            m_table[static_cast<size_t>(y) * m_tiles.width + x].hash = 0;
+        }
+    }
+}
+
+auto TileChangeDetector::hashTile(SurfaceView image, Rect const &tile) const -> uint64_t {
+    const auto rowBytes = static_cast<size_t>(tile.width()) * bytesPerPixel;
+    auto hash = uint64_t{};
+    for (auto y = tile.top(); y < tile.bottom(); ++y) hash = hashBytes({image.pixel({tile.left(), y}), rowBytes}, hash);
+    return hash != 0 ? hash : 1; // 0 marks unknown content
+}
+
+} // namespace core
@@ -0,0 +1,88 @@
+#pragma once
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+#include "Surface.h"
+
+#include <chrono>
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+using win32::Dimension;
+using win32::Rect;
+
+/// Reduces dirty rects to the tiles whose content really changed
+/// note:
+/// * all rects are in desktop coordinates, tiles are aligned in the (rotated) display image
+/// * each tile remembers the hash of its content when it was last reported, so the table follows what consumers show
+/// * tiles touched by moves or updated without an image are always reported on their next change
+struct TileChangeDetector {
+    using MoveRect = DXGI_OUTDUPL_MOVE_RECT;
+    struct Config {
+        int tileSize{32}; ///< width & height of a tile in pixels
+    };
+    struct Stats {
+        uint64_t frames{};
+        int64_t inputArea{}; ///< dirty pixels reported
+        int64_t outputArea{}; ///< dirty pixels kept because their tile changed
+        int64_t hashedArea{}; ///< pixels of all hashed tiles
+        uint64_t hashedTiles{};
+        uint64_t changedTiles{};
+        std::chrono::nanoseconds hashTime{};
+    };
+
+    TileChangeDetector() = default;
+    explicit TileChangeDetector(Config config)
+        : m_config{config} {}
+
+    /// start over for an output - all tiles are unknown
+    void reset(Dimension desktop, DXGI_MODE_ROTATION rotation);
+
+    /// dirty rects grown to whole tiles - detect() reads the image inside of them
+    /// note: result is valid until the next call
+    auto tileRects(std::span<const Rect> dirty) -> std::span<const Rect>;
+
+    /// drop the parts of dirty where all tiles have the hashed content
+    /// note: without an image nothing is dropped and the touched tiles become unknown
+    void detect(SurfaceView image, std::span<const MoveRect> moved, std::span<const Rect> dirty);
+
+    /// dirty rects of the last detect - valid until the next call
+    auto dirty() const -> std::span<const Rect> { return m_dirty; }
+
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    struct Tile {
+        uint64_t hash{}; // 0 = unknown content
+        uint64_t frame{}; // detect call that hashed the tile last
+        bool isChanged{};
+    };
+    struct TileRange {
+        int left{}, top{}, right{}, bottom{}; // in tiles, right & bottom are exclusive
+    };
+    auto toImage(Rect const &desktopRect) const -> std::optional<Rect>;
+    auto toDesktop(Rect const &imageRect) const -> Rect;
+    auto tileRange(Rect const &imageRect) const -> TileRange;
+    auto tileRect(int x, int y) const -> Rect;
+    void forget(Rect const &imageRect);
+    auto hashTile(SurfaceView image, Rect const &tile) const -> uint64_t;
+
+private:
+    Config m_config{};
+    Dimension m_desktop{};
+    DXGI_MODE_ROTATION m_rotation{DXGI_MODE_ROTATION_IDENTITY};
+    Dimension m_image{};
+    Dimension m_tiles{}; // number of tiles in each direction
+    std::vector<Tile> m_table{};
+    uint64_t m_frame{};
+    std::vector<Rect> m_tileRects{};
+    std::vector<Rect> m_imageDirty{};
+    std::vector<Rect> m_dirty{};
+    Stats m_stats{};
+};
+
+} // namespace core
@@ -0,0 +1,65 @@
+#include "VisibleAreaCuller.h"
+
+#include "RectCoalescer.h"
+
+namespace core {
+
+void VisibleAreaCuller::setVisibleArea(std::optional<Rect> area) {
+    if (area == m_visible) return;
+    m_visible = area;
+    m_needsRefresh = true;
+}
+
+void VisibleAreaCuller::cull(std::span<const MoveRect> moved, std::span<const Rect> dirty, bool hasImage) {
+    m_moved.clear();
+    m_dirty.clear();
+    for (auto const &move : moved) m_stats.inputArea += area(Rect::fromRECT(move.DestinationRect));
+    for (auto const &rect : dirty) m_stats.inputArea += area(rect);
+
+    if (!m_visible) {
+        m_moved.assign(moved.begin(), moved.end());
+        m_dirty.assign(dirty.begin(), dirty.end());
+        m_needsRefresh = false;
+    }
+    else if (hasImage && m_needsRefresh) {
+        // everything visible is updated anyways
+        if (area(*m_visible) > 0) m_dirty.push_back(*m_visible);
+        m_needsRefresh = false;
+    }
+    else {
+        const auto &visible = *m_visible;
+        for (auto const &move : moved) {
+            const auto destination = Rect::fromRECT(move.DestinationRect);
+            const auto clipped = intersect(destination, visible);
+            if (!clipped) continue;
+            const auto dx = move.SourcePoint.x - destination.left();
+            const auto dy = move.SourcePoint.y - destination.top();
+            const auto source = Rect{{clipped->left() + dx, clipped->top() + dy}, clipped->dimension};
+            if (containsRect(visible, source)) {
+                m_moved.push_back(MoveRect{
+                    .SourcePoint = source.topLeft.toPOINT(),
+                    .DestinationRect = clipped->toRECT(),
+                });
+            }
+            else {
+                // source content was culled before and is stale
+                m_dirty.push_back(*clipped);
+                m_stats.movesToDirty++;
+            }
+        }
+        for (auto const &rect : dirty) {
+            const auto clipped = intersect(rect, visible);
+            if (clipped) m_dirty.push_back(*clipped);
+        }
+        if (!hasImage && !m_dirty.empty()) {
+            // we cannot update anything without an image - keep everything stale
+            m_dirty.clear();
+            m_needsRefresh = true;
+        }
+    }
+
+    for (auto const &move : m_moved) m_stats.outputArea += area(Rect::fromRECT(move.DestinationRect));
+    for (auto const &rect : m_dirty) m_stats.outputArea += area(rect);
+}
+
+} // namespace core
@@ -0,0 +1,65 @@
+#pragma once
+#include "win32/DxgiTypes.h"
+#include "win32/Geometry.h"
+
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace core {
+
+using win32::Rect;
+
+/// Restricts frame updates to the visible part of the captured display
+/// note:
+/// * all rects are in desktop coordinates of the captured output
+/// * moves with a source outside the visible area are turned into dirty rects
+/// * content outside the visible area gets stale, so the whole visible area is requested as dirty after a change
+struct VisibleAreaCuller {
+    using MoveRect = DXGI_OUTDUPL_MOVE_RECT;
+    struct Stats {
+        int64_t inputArea{}; ///< dirty & moved pixels reported
+        int64_t outputArea{}; ///< dirty & moved pixels kept
+        uint64_t movesToDirty{}; ///< moves that had to be replaced with dirty rects
+    };
+
+    /// area that is visible - nullopt disables culling
+    void setVisibleArea(std::optional<Rect>);
+    auto visibleArea() const -> std::optional<Rect> const & { return m_visible; }
+
+    /// cull the metadata of one frame
+    /// note: hasImage is false if the frame carries no image content (dirty rects can not be added)
+    void cull(std::span<const MoveRect> moved, std::span<const Rect> dirty, bool hasImage);
+
+    // results of the last cull - valid until the next call
+    auto moved() const -> std::span<const MoveRect> { return m_moved; }
+    auto dirty() const -> std::span<const Rect> { return m_dirty; }
+
+    auto stats() const -> Stats const & { return m_stats; }
+
+private:
+    std::optional<Rect> m_visible{};
+    bool m_needsRefresh{};
+    std::vector<MoveRect> m_moved{};
+    std::vector<Rect> m_dirty{};
+    Stats m_stats{};
+};
+
+/// intersection of both rects - nullopt if they do not overlap
+constexpr auto intersect(Rect const &a, Rect const &b) -> std::optional<Rect> {
+    const auto left = a.left() > b.left() ? a.left() : b.left();
+    const auto top = a.top() > b.top() ? a.top() : b.top();
+    const auto right = a.right() < b.right() ? a.right() : b.right();
+    const auto bottom = a.bottom() < b.bottom() ? a.bottom() : b.bottom();
+    if (left >= right || top >= bottom) return {};
+    return Rect{{left, top}, {right - left, bottom - top}};
+}
+
+/// true if inner is completely inside of outer
+constexpr bool containsRect(Rect const &outer, Rect const &inner) {
+    return outer.left() <= inner.left() && outer.top() <= inner.top() && outer.right() >= inner.right() &&
+           outer.bottom() >= inner.bottom();
+}
+
+} // namespace core
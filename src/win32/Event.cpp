@@ -0,0 +1,11 @@
+#include "Event.h"
+
+namespace win32 {
+
+Event::Event(Config config) {
+    auto securityAttributes = nullptr;
+    auto name = nullptr;
+    m_handle.reset(::CreateEventW(securityAttributes, config.manualReset, config.initialState, name));
+}
+
+} // namespace win32
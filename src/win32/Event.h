@@ -0,0 +1,25 @@
+#pragma once
+#include "Handle.h"
+
+#include <Windows.h>
+
+namespace win32 {
+
+/// Wrapper for a win32 Event handle
+struct Event {
+    struct Config {
+        bool manualReset = {};
+        bool initialState = {};
+    };
+    explicit Event(Config = {});
+
+    auto handle() const -> HANDLE { return m_handle.get(); }
+
+    void set() { ::SetEvent(m_handle.get()); }
+    void reset() { ::ResetEvent(m_handle.get()); }
+
+private:
+    Handle m_handle;
+};
+
+} // namespace win32
@@ -1,5 +1,5 @@
 #pragma once
-#include <Windows.h>
+#include "Types.h"
 
 namespace win32 {
 
@@ -5,10 +5,9 @@
 namespace win32 {
 namespace {
 
-auto GetCurrentThreadHandle() -> HANDLE {
+auto DuplicateThreadHandle(HANDLE thread) -> HANDLE {
     auto output = HANDLE{};
     const auto process = GetCurrentProcess();
-    const auto thread = GetCurrentThread();
     const auto desiredAccess = 0;
     const auto inheritHandle = false;
     const auto options = DUPLICATE_SAME_ACCESS;
@@ -20,6 +19,8 @@ auto GetCurrentThreadHandle() -> HANDLE {
 
 } // namespace
 
-auto Thread::fromCurrent() -> Thread { return Thread{GetCurrentThreadHandle()}; }
+auto Thread::fromCurrent() -> Thread { return Thread{DuplicateThreadHandle(GetCurrentThread())}; }
+
+auto Thread::fromHandle(HANDLE thread) -> Thread { return Thread{DuplicateThreadHandle(thread)}; }
 
 } // namespace win32
@@ -13,15 +13,18 @@ struct Thread {
         : m_threadHandle{handle} {}
 
     static auto fromCurrent() -> Thread;
+    /// duplicates the handle of another thread (e.g. std::thread::native_handle)
+    static auto fromHandle(HANDLE thread) -> Thread;
 
     auto handle() const -> HANDLE { return m_threadHandle.get(); }
 
+    /// returns false if the APC could not be queued (functor is dropped)
     template<class Functor>
-    void queueUserApc(Functor&& functor) {
+    bool queueUserApc(Functor&& functor) {
         auto callback = UniqueCallbackAdapter<ULONG_PTR>(std::forward<Functor>(functor));
         const auto success = ::QueueUserAPC(callback.c_callback(), handle(), callback.c_parameter());
         if (success) callback.release();
-        // if (!success) throw Unexpected{"api::setError failed to queue APC"};
+        return success != 0;
     }
 
 private:
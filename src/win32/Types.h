@@ -0,0 +1,34 @@
+#pragma once
+/// Basic win32 value types
+/// note: on other platforms we provide layout compatible replacements,
+///       so portable code (benchmarks, software backends) can be compiled without <Windows.h>.
+#ifdef _WIN32
+#    include <Windows.h>
+#else
+#    include <stdint.h>
+
+using BOOL = int;
+using INT = int;
+using UINT = unsigned int;
+using LONG = int32_t;
+using WCHAR = wchar_t;
+using HMONITOR = void *;
+
+struct POINT {
+    LONG x;
+    LONG y;
+};
+
+struct SIZE {
+    LONG cx;
+    LONG cy;
+};
+
+struct RECT {
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+
+#endif